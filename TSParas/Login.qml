@@ -6,10 +6,8 @@ Item {
     anchors.fill: parent
 
     property string ip: "localhost"
-    property string hash: "TS1:Mechanism:RotorLife"
-    property string key: "users"
-    property var correctUsers: []
-    signal loginSuccessful
+    property int apiPort: 7380 // 服务端EDITOR_API_PORT
+    signal loginSuccessful(string token)
 
     Rectangle {
         anchors.fill: parent
@@ -61,18 +59,7 @@ Item {
                     color: "#5C6BC0"
                     radius: 5
                 }
-                onClicked: {
-                    const hashedPassword = HashProvider.hashPassword(
-                                             passwordField.text)
-                    for (let user of correctUsers) {
-                        if (usernameField.text === user.username
-                                && hashedPassword === user.password) {
-                            loginSuccessful()
-                            return
-                        }
-                    }
-                    loginMessage.text = "Incorrect username or password."
-                }
+                onClicked: login()
             }
 
             Text {
@@ -84,32 +71,26 @@ Item {
         }
     }
 
-    Component.onCompleted: {
-        fetchUsers()
-    }
-
-    function fetchUsers() {
-        let url = `http://${ip}:7379/hget/${hash}/${key}`
+    // 密码由服务端与散列比较, 成功时得到修改参数所需的令牌
+    function login() {
         let xhr = new XMLHttpRequest()
 
         xhr.onreadystatechange = function () {
             if (xhr.readyState === XMLHttpRequest.DONE) {
                 if (xhr.status === 200) {
-                    let data = JSON.parse(xhr.responseText).hget
-//                    console.log(data);
-                    let parsedData = JSON.parse(data)
-                    for (let username in parsedData) {
-                        correctUsers.push({
-                                              "username": username,
-                                              "password": parsedData[username]
-                                          })
-                    }
+                    loginSuccessful(JSON.parse(xhr.responseText).token)
+                } else if (xhr.status === 401) {
+                    loginMessage.text = "Incorrect username or password."
                 } else {
-                    console.error("Error:", xhr.statusText)
+                    loginMessage.text = "Login failed: " + xhr.statusText
                 }
             }
         }
-        xhr.open("GET", url)
-        xhr.send()
+        xhr.open("POST", `http://${ip}:${apiPort}/api/login`)
+        xhr.setRequestHeader("Content-Type", "application/json")
+        xhr.send(JSON.stringify({
+                                    "username": usernameField.text,
+                                    "password": passwordField.text
+                                }))
     }
 }
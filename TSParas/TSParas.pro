@@ -1,4 +1,4 @@
-QT += quick
+QT += quick websockets
 
 SOURCES += \
         main.cpp
@@ -18,5 +18,3 @@ qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
-HEADERS += \
-    HashProvider.h
@@ -1,7 +1,5 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
-#include <QQmlContext>
-#include "HashProvider.h"
 
 int main(int argc, char *argv[])
 {
@@ -9,9 +7,6 @@ int main(int argc, char *argv[])
 
     QQmlApplicationEngine engine;
 
-    HashProvider hashProvider;
-    engine.rootContext()->setContextProperty("HashProvider", &hashProvider);
-
     const QUrl url(u"qrc:/TSParas/main.qml"_qs);
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
                      &app, [url](QObject *obj, const QUrl &objUrl) {
@@ -1,6 +1,7 @@
 import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
+import QtWebSockets
 import "."
 
 ApplicationWindow {
@@ -12,11 +13,15 @@ ApplicationWindow {
     //    flags: Qt.FramelessWindowHint
     property bool showRowLayout: false
     property string ip: "localhost"
-    property string hash: "TS1:Mechanism:RotorParams"
+    property int apiPort: 7380 // 服务端EDITOR_API_PORT
     property int maxPages: 1
     property int currentPage: 1
     property var textInputObjs: ({})
     property var textInputs: ({})
+    property var dirtyPages: ({}) // 有手工修改的页, 保存时一起提交
+    property var rotorParams: ({}) // /api/parameters的rotors
+    property var liveState: ({}) // 转子名 -> /api/live推送的一行
+    property string token: "" // /api/login返回, 提交参数时使用
     property var parameters: ["slaveID", "controlWord", "density", "radius", "holeRadius", "deltaR", "scanCycle", "surfaceFactor", "centerFactor", "freeFactor"]
     property var listParameters: ["tcz_X", "tcz_Y", "shz_X", "shz_Y", "emz_X", "emz_Y", "prz_X", "prz_Y", "lecz_X", "lecz_Y", "SN1_X", "SN1_Y", "SN2_X", "SN2_Y", "SN3_X", "SN3_Y", "sn"]
 
@@ -70,6 +75,13 @@ ApplicationWindow {
                     }
                 }
 
+                Text {
+                    property var row: liveState[String(currentPage)]
+                    text: row ? `lifeRatio: ${row[1]}  overhaulLifeRatio: ${row[2]}  alert: ${row[3]}  ts: ${row[4]}  thermalStress: ${row[8]}  margin: ${row[9]}` : "No live data"
+                    color: "#5C6BC0"
+                    font.pixelSize: 14
+                }
+
                 GridLayout {
                     columns: 3
 
@@ -111,6 +123,9 @@ ApplicationWindow {
                                             textInputs[currentPage] = {}
                                         }
                                         textInputs[currentPage][key] = text
+                                        if (activeFocus) {
+                                            dirtyPages[currentPage] = true
+                                        }
 
                                         if (text.length > 0 && !text.match(
                                                     /^\d*\.?\d*$/)) {
@@ -179,6 +194,9 @@ ApplicationWindow {
                                             textInputs[currentPage] = {}
                                         }
                                         textInputs[currentPage][key] = text
+                                        if (activeFocus) {
+                                            dirtyPages[currentPage] = true
+                                        }
 
                                         if (text.length > 0 && !text.match(
                                                     /^(\s*\d+(\.\d*)?\s*,\s*)*(\s*\d+(\.\d*)?\s*)?$/)) {
@@ -264,7 +282,8 @@ ApplicationWindow {
         Login {}
     }
 
-    function handleLoginSuccessful() {
+    function handleLoginSuccessful(loginToken) {
+        token = loginToken
         stackView.pop()
         stackView.push(pageComponent)
         showRowLayout = true
@@ -278,7 +297,39 @@ ApplicationWindow {
 
     Component.onCompleted: {
         showLoginPage()
-        fetchPageNums()
+        fetchAll()
+    }
+
+    // 服务端每个周期推送一次所有转子的状态, 格式同TS<unit>/Rotors
+    WebSocket {
+        id: liveSocket
+        url: `ws://${ip}:${apiPort}/api/live`
+        active: showRowLayout
+
+        onTextMessageReceived: message => {
+            let state = {}
+            for (let row of JSON.parse(message).rotors) {
+                state[row[0]] = row
+            }
+            liveState = state
+        }
+
+        onStatusChanged: {
+            if (status === WebSocket.Error || status === WebSocket.Closed) {
+                reconnectTimer.start()
+            }
+        }
+    }
+
+    Timer {
+        id: reconnectTimer
+        interval: 5000
+        onTriggered: {
+            if (showRowLayout) {
+                liveSocket.active = false
+                liveSocket.active = true
+            }
+        }
     }
 
     RowLayout {
@@ -373,95 +424,79 @@ ApplicationWindow {
     }
 
     function saveCurrentTextInputs() {
-        let batch = {}
-        let textPages = textInputs[currentPage]
-
-        for (let key in textPages) {
-            batch[key] = textPages[key]
+        let rotors = {}
+        dirtyPages[currentPage] = true
+        for (let page in dirtyPages) {
+            if (textInputs[page]) {
+                rotors[page] = textInputs[page]
+            }
         }
 
-        sendBatch(batch, currentPage)
-//        console.log(maxPages)
-        savePageNums(maxPages)
-    }
-
-    function sendBatch(batch, key) {
-        let url = `http://${ip}:7379/hset/${hash}/${key}/${JSON.stringify(
-                batch)}`
-
-        //        console.log("Batch Save URL:", url);
+        // 一次提交所有修改过的转子, 服务端校验失败时不写入任何转子
         let xhr = new XMLHttpRequest()
         xhr.onreadystatechange = function () {
             if (xhr.readyState === XMLHttpRequest.DONE) {
-                if (xhr.status !== 200) {
+                if (xhr.status === 200) {
+                    for (let page in rotors) {
+                        rotorParams[page] = rotors[page]
+                    }
+                    dirtyPages = {}
+                } else if (xhr.status === 400) {
+                    console.error("Invalid parameters:", JSON.parse(xhr.responseText).errors.join("\n"))
+                } else if (xhr.status === 401) {
+                    // 令牌过期或服务已重启
+                    stackView.pop()
+                    showLoginPage()
+                } else {
                     console.error("Error:", xhr.statusText)
                 }
             }
         }
-        xhr.open("GET", url)
-        xhr.send()
+        xhr.open("POST", `http://${ip}:${apiPort}/api/parameters`)
+        xhr.setRequestHeader("Content-Type", "application/json")
+        xhr.setRequestHeader("Authorization", "Bearer " + token)
+        xhr.send(JSON.stringify({
+                                    "nums": maxPages,
+                                    "rotors": rotors
+                                }))
     }
 
     function loadCurrentTextInputs() {
-        fetchData(currentPage)
+        fetchAll()
     }
 
     function fetchData(key) {
-        let url = `http://${ip}:7379/hget/${hash}/${key}`
-        let xhr = new XMLHttpRequest()
-
-        xhr.onreadystatechange = function () {
-            if (xhr.readyState === XMLHttpRequest.DONE) {
-                if (xhr.status === 200) {
-                    let data = JSON.parse(xhr.responseText).hget
-                    //                    console.log("Load Data:", data);
-                    //                    console.log("Data type:", typeof data);
-                    let parsedData = JSON.parse(data)
-                    for (let field in parsedData) {
-                        if (textInputObjs[key][field]) {
-                            textInputObjs[key][field].text = parsedData[field]
-                        }
-                    }
-                } else {
-                    console.error("Error:", xhr.statusText)
-                }
+        let parsedData = rotorParams[key]
+        if (!parsedData || !textInputObjs[key]) {
+            return
+        }
+        for (let field in parsedData) {
+            if (textInputObjs[key][field]) {
+                textInputObjs[key][field].text = parsedData[field]
             }
         }
-        xhr.open("GET", url)
-        xhr.send()
     }
 
-    function fetchPageNums() {
-        let url = `http://${ip}:7379/hget/TS1:Mechanism:RotorLife/nums`
+    // 一次读取所有转子的参数和转子数, 翻页时不再访问服务端
+    function fetchAll() {
         let xhr = new XMLHttpRequest()
 
         xhr.onreadystatechange = function () {
             if (xhr.readyState === XMLHttpRequest.DONE) {
                 if (xhr.status === 200) {
-                    let data = JSON.parse(xhr.responseText).hget
-                    maxPages = data
-//                    console.log(data, maxPages)
+                    let data = JSON.parse(xhr.responseText)
+                    rotorParams = data.rotors
+                    if (data.nums > 0) {
+                        maxPages = data.nums
+                    }
+                    dirtyPages = {}
+                    fetchData(currentPage)
                 } else {
                     console.error("Error:", xhr.statusText)
                 }
             }
         }
-        xhr.open("GET", url)
-        xhr.send()
-    }
-
-    function savePageNums(value) {
-        let url = `http://${ip}:7379/hset/TS1:Mechanism:RotorLife/nums/${value}`
-        let xhr = new XMLHttpRequest()
-
-        xhr.onreadystatechange = function () {
-            if (xhr.readyState === XMLHttpRequest.DONE) {
-                if (xhr.status !== 200) {
-                    console.error("Error:", xhr.statusText)
-                }
-            }
-        }
-        xhr.open("GET", url)
+        xhr.open("GET", `http://${ip}:${apiPort}/api/parameters`)
         xhr.send()
     }
 }
@@ -2,61 +2,23 @@
 #include "src/myModbus.h"
 
 #include "src/myLogger.h"
-#include "src/Rotor.h"
+#include "src/task.h"
 
-constexpr const long long TASK_INTERVAL { 5000000 };
-constexpr const int MQTT_SEND_PERIOD { 20 };
 constexpr const bool PARAS_FROM_Redis { false };
-
-class Task {
-private:
-    std::vector<Rotor> rotors;
-    const std::vector<std::string> m_names;
-
-public:
-    Task(const std::vector<std::string>& names, const std::string& unit, const std::vector<Parameters>& paraList, const std::vector<int>& controlWords,
-        std::shared_ptr<MyRedis> redisCli, std::shared_ptr<MyMQTT> MQTTCli,
-        std::vector<std::unique_ptr<MyModbusClient>>&& modbusClis,
-        std::shared_ptr<MyModbusServer> modbusServer)
-        : m_names { names }
-    {
-        for (std::size_t i { 0 }; i < names.size(); ++i) {
-            Rotor rotor(names[i], unit, paraList[i], controlWords[i], redisCli, MQTTCli, std::move(modbusClis[i]), modbusServer);
-            rotors.emplace_back(std::move(rotor));
-        }
-    }
-
-    void run(long long& count) {
-        const std::size_t len { m_names.size() };
-        
-        while (true) {
-            auto start = std::chrono::steady_clock::now();
-            std::vector<std::future<void>> futures;
-
-            for (std::size_t i { 0 }; i < len; ++i) {
-                futures.emplace_back(std::async(std::launch::async, [this, i, &count]() {
-                    rotors[i].run();
-                    if (count % MQTT_SEND_PERIOD == 1) {
-                        rotors[i].send_message();
-                    }
-                }));
-            }
-
-            for (auto& f : futures) {
-                f.wait();
-            }
-
-            auto end = std::chrono::steady_clock::now();
-            auto elapsed_time = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-            std::cout << "Loop " << ++count << " time used: " << elapsed_time.count() << " microseconds\n";
-            std::this_thread::sleep_for(std::chrono::microseconds(TASK_INTERVAL - elapsed_time.count()));
-        }
-    }
-};
+constexpr const std::size_t TRACE_FILE_SIZE { 1024 * 1024 * 64 };
+constexpr const std::size_t TRACE_FILE_NUM { 4 };
+constexpr const bool IO_REACTOR { false }; // true: 单线程反应器+协程, false: 每周期每转子一个线程
+constexpr const bool REALTIME_MODE { false }; // 需要IO_REACTOR; 核由RT_COMPUTE_CPUS/RT_IO_CPUS指定
+constexpr const bool EDITOR_API { false }; // TSParas的HTTP/WebSocket接口, 地址由EDITOR_API_IP/EDITOR_API_PORT指定, 编辑器页面的来源由EDITOR_API_ORIGIN指定
+constexpr const bool SHARDING { false }; // 多个进程按Redis租约分担转子, 进程以WORKER_ID区分, 见src/shard.h
+constexpr const bool MQTT_SPOOL { false }; // MQTT断线期间的消息写入spool/目录下的文件, 重连后按顺序补发, 大小由MQTT_SPOOL_MB指定, 见src/mqttSpool.h
 
 int main()
 {
     init_logger();
+    // TRACE_LEVEL: off/info/debug/verbose, 运行中可用SIGUSR1/SIGUSR2调整
+    init_trace("logs/trace.bin", TRACE_FILE_SIZE, TRACE_FILE_NUM, parse_trace_level(std::getenv("TRACE_LEVEL")));
+    const TraceGuard traceGuard; // 之后每个return都会停止跟踪线程
 
     if (!fileExists(".env")) {
         spdlog::error("File .env does not exist!");
@@ -64,6 +26,18 @@ int main()
     }
 
     dotenv::init();
+
+    const RealtimeConfig rtConfig { load_realtime_config() };
+    if (REALTIME_MODE) {
+        if (!IO_REACTOR) {
+            spdlog::warn("Real-time mode requires IO_REACTOR, ignored");
+        } else {
+            // 已有的日志线程和之后创建的MQTT/Modbus服务端/反应器线程都在I/O核上
+            set_process_affinity(rtConfig.ioCpus);
+            lock_memory();
+            prefault_heap();
+        }
+    }
     const std::string MQTT_ADDRESS { std::getenv("MQTT_ADDRESS") };
     const std::string MQTT_USERNAME { std::getenv("MQTT_USERNAME") };
     const std::string MQTT_PASSWORD { std::getenv("MQTT_PASSWORD") };
@@ -86,8 +60,14 @@ int main()
     const std::string MODBUS_SERVER_IP = std::getenv("MODBUS_SERVER_IP");
     const int MODBUS_SERVER_PORT = std::atoi(std::getenv("MODBUS_SERVER_PORT"));
 
+    // 同机的多个分片进程各用一个队列文件, 以WORKER_ID命名; 文件名不变, 重启后继续补发上次未发送的消息.
+    // 未指定WORKER_ID时CLIENT_ID每次启动都不同, 不用于命名, 由MqttSpool在文件被占用时改用带编号的文件
+    const char* spoolWorker { SHARDING ? std::getenv("WORKER_ID") : nullptr };
+    const std::string MQTT_SPOOL_FILE { MQTT_SPOOL ? "spool/mqtt" + std::string(spoolWorker ? std::string(".") + spoolWorker : "") + ".spool" : "" };
+    const char* spoolMb { std::getenv("MQTT_SPOOL_MB") };
+    const std::size_t MQTT_SPOOL_BYTES { spoolMb && std::atoi(spoolMb) > 0 ? static_cast<std::size_t>(std::atoi(spoolMb)) * 1024 * 1024 : MQTT_SPOOL_SIZE };
     auto MQTTCli = std::make_shared<MyMQTT>(MQTT_ADDRESS, CLIENT_ID, MQTT_USERNAME, MQTT_PASSWORD,
-        MQTT_CA_CERTS, MQTT_CERTFILE, MQTT_KEYFILE, MQTT_KEYFILE_PASSWORD);
+        MQTT_CA_CERTS, MQTT_CERTFILE, MQTT_KEYFILE, MQTT_KEYFILE_PASSWORD, MQTT_SPOOL_FILE, MQTT_SPOOL_BYTES);
 
     std::shared_ptr<MyRedis> redisCli;
     if (!REDIS_UNIX_SOCKET.empty()) {
@@ -100,7 +80,7 @@ int main()
     json j;
 
     if (PARAS_FROM_Redis) {
-        j = redisCli->m_hgetall("TS" + unit1 + ":Mechanism:RotorParams");
+        j = redisCli->m_hgetall("TS" + unit1 + ":Mechanism:RotorParams").value_or(json {});
     } else {
         std::ifstream file("parameters.json");
         if (!file) {
@@ -115,9 +95,11 @@ int main()
     }
 
     std::vector<std::string> keys;
+    MaterialLibrary materials; // paraList中的曲线指向这里, 须在Task之前构造
     std::vector<Parameters> paraList;
     std::vector<std::unique_ptr<MyModbusClient>> modbusClis;
     std::vector<int> controlWords;
+    std::vector<int> slaveIDs;
 
     for (json::iterator it = j.begin(); it != j.end(); ++it) {
         const std::string key = it.key();
@@ -125,29 +107,79 @@ int main()
         keys.emplace_back(key);
 
         if (PARAS_FROM_Redis) {
-            Parameters paras = loadParasFromRedis(j, key);
+            Parameters paras = loadParasFromRedis(j, key, materials);
             paraList.emplace_back(paras);
         } else {
-            Parameters paras = loadParasFromJson(j, key);
+            Parameters paras = loadParasFromJson(j, key, materials);
             // std::cout << paras << '\n';
             paraList.emplace_back(paras);
         }
 
         int slaveID = std::stoi(j[key]["slaveID"].get<std::string>());
-        // libmodbus不支持shared_ptr
-        auto modbusCli = std::make_unique<MyModbusClient>(MODBUS_CLIENT_IP, MODBUS_CLIENT_PORT, slaveID);
-        modbusClis.emplace_back(std::move(modbusCli));
+        slaveIDs.emplace_back(slaveID);
+        if (!IO_REACTOR) {
+            // libmodbus不支持shared_ptr
+            auto modbusCli = std::make_unique<MyModbusClient>(MODBUS_CLIENT_IP, MODBUS_CLIENT_PORT, slaveID);
+            modbusClis.emplace_back(std::move(modbusCli));
+        }
 
         const int controlWord = std::stoi(j[key]["controlWord"].get<std::string>());
         controlWords.emplace_back(controlWord);
     }
+    spdlog::info("Material library: {} curves, {} of {} bytes after deduplication",
+        materials.curves(), materials.stored_bytes(), materials.requested_bytes());
+
+    // 未提供register_map.json时使用原有的每转子37个寄存器布局
+    json registerMapConfig = RegisterMap::default_config();
+    if (fileExists("register_map.json")) {
+        std::ifstream registerMapFile("register_map.json");
+        registerMapFile >> registerMapConfig;
+    }
+    auto registerMap = RegisterMap::compile(registerMapConfig, keys, MODBUS_REGISTER_MAX);
+    if (!registerMap) {
+        return 1;
+    }
+    // 寄存器映像只包含映射用到的地址
+    auto modbusServer = std::make_shared<MyModbusServer>(MODBUS_SERVER_IP, MODBUS_SERVER_PORT, registerMap->registers());
+
+    // 未提供rates.json时所有转子按TASK_INTERVAL计算, 按MQTT_SEND_PERIOD发布
+    json ratesConfig = RateTable::default_config();
+    if (fileExists("rates.json")) {
+        std::ifstream ratesFile("rates.json");
+        ratesFile >> ratesConfig;
+    }
+    auto rates = RateTable::compile(ratesConfig, keys);
+    if (!rates) {
+        return 1;
+    }
 
-    auto modbusServer = std::make_shared<MyModbusServer>(MODBUS_SERVER_IP, MODBUS_SERVER_PORT);
     auto serverFuture = std::async(std::launch::async, [&]() { modbusServer.get()->run(); });
 
-    Task task1 { keys, unit1, paraList, controlWords, redisCli, MQTTCli, std::move(modbusClis), modbusServer };
+    std::unique_ptr<Task> task1;
+    if (IO_REACTOR) {
+        auto reactorTask = std::make_unique<ReactorTask>(keys, unit1, paraList, controlWords, redisCli, MQTTCli,
+            MODBUS_CLIENT_IP, MODBUS_CLIENT_PORT, slaveIDs, modbusServer, std::move(*registerMap), std::move(*rates));
+        if (REALTIME_MODE) {
+            reactorTask->enable_realtime(rtConfig);
+        }
+        task1 = std::move(reactorTask);
+    } else {
+        task1 = std::make_unique<Task>(keys, unit1, paraList, controlWords, redisCli, MQTTCli, std::move(modbusClis), modbusServer, std::move(*registerMap), std::move(*rates));
+    }
+    if (EDITOR_API) {
+        const char* editorIp { std::getenv("EDITOR_API_IP") };
+        const char* editorPort { std::getenv("EDITOR_API_PORT") };
+        const char* editorOrigin { std::getenv("EDITOR_API_ORIGIN") };
+        task1->enable_editor_api(std::make_unique<EditorApi>(unit1, redisCli, editorIp ? editorIp : "127.0.0.1", editorPort ? std::atoi(editorPort) : 7380,
+            editorOrigin ? editorOrigin : ""));
+    }
+    if (SHARDING) {
+        // 未指定WORKER_ID时每次启动都是新的进程, 旧进程的租约过期后才被接手
+        const char* workerId { std::getenv("WORKER_ID") };
+        task1->enable_sharding(std::make_unique<ShardManager>(unit1, keys, redisCli, workerId ? workerId : CLIENT_ID));
+    }
     long long count { 0 };
-    auto clientFuture = std::async(std::launch::async, [&]() { task1.run(count); });
+    auto clientFuture = std::async(std::launch::async, [&]() { task1->run(count); });
 
     return 0;
 }
\ No newline at end of file
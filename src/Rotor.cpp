@@ -1,94 +1,326 @@
 #include "Rotor.h"
+#include "reactor.h"
 
 Rotor::Rotor(const std::string& name, const std::string& unit, const Parameters& para, const int controlWord,
-    std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli,
-    std::unique_ptr<MyModbusClient> modbusCli, std::shared_ptr<MyModbusServer> modbusServer)
+    std::span<RotorSection> sections, std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli,
+    std::unique_ptr<MyModbusClient> modbusCli)
     : m_name { name }
     , m_unit { unit }
     , m_para { para }
     , m_controlWord { controlWord }
+    , m_sections { sections }
     , m_redis { redis }
     , m_MQTTCli { MQTTCli }
     , m_ModbusCli { std::move(modbusCli) }
-    , m_ModbusServer { modbusServer }
 {
-    init();
 }
 
-void Rotor::run()
+void Rotor::run(bool saveLife, bool pollControl)
 {
-    get_control_command();
+    const RegisterBlock block { acquisition_block(pollControl) };
+    const auto registers = read_registers(block.start, block.count, "acquisition");
+    if (pollControl) {
+        apply_control_command(contains_control_word(block) ? slice(registers, block, m_controlWord, 1) : read_registers(m_controlWord, 1, "control word"));
+    }
 
-    temp_field();
-    thermal_stress();
-    life();
+    step();
+    if (saveLife && m_lifeDirty) {
+        save_life();
+    }
 
-    surfaceTemp.cur = get_surface_temp(0, 600);
+    update_surface_temp(slice(registers, block, SURFACE_REGISTER_START, SURFACE_REGISTER_NUM));
 }
 
-void Rotor::send_message()
+RegisterBlock Rotor::acquisition_block(bool pollControl) const
+{
+    const int start { std::min(SURFACE_REGISTER_START, m_controlWord) };
+    const int end { std::max(SURFACE_REGISTER_START + SURFACE_REGISTER_NUM, m_controlWord + 1) };
+    if (pollControl && end - start <= MODBUS_READ_MAX) {
+        return { start, end - start };
+    }
+    return { SURFACE_REGISTER_START, SURFACE_REGISTER_NUM };
+}
+
+bool Rotor::contains_control_word(const RegisterBlock& block) const
+{
+    return m_controlWord >= block.start && m_controlWord < block.start + block.count;
+}
+
+std::vector<uint16_t> Rotor::slice(const std::vector<uint16_t>& registers, const RegisterBlock& block, int start, int count)
+{
+    const int offset { start - block.start };
+    if (offset < 0 || offset + count > static_cast<int>(registers.size())) {
+        return {};
+    }
+    return { registers.begin() + offset, registers.begin() + offset + count };
+}
+
+bool Rotor::step()
+{
+    // 周期延迟或按较慢的速率运行时, 按实际经过的时间积分
+    const auto now = std::chrono::steady_clock::now();
+    double dt { std::chrono::duration<double>(now - m_lastStep).count() };
+    m_lastStep = now;
+    if (dt > STEP_ELAPSED_MAX) {
+        spdlog::warn("Rotor {} was not stepped for {} s, integrating {} s only", m_name, dt, STEP_ELAPSED_MAX);
+        dt = STEP_ELAPSED_MAX;
+    }
+    return step(dt);
+}
+
+bool Rotor::step(double dt)
+{
+    const double end { steady_seconds(m_lastStep) };
+    const std::size_t len { m_sections.size() };
+    std::vector<char> changed(len, 0);
+    auto advance = [this, dt, end, &changed](std::size_t begin, std::size_t last) {
+        for (std::size_t k { begin }; k < last; ++k) {
+            changed[k] = m_sections[k].step(dt, end);
+        }
+    };
+    if (len < SECTION_PARALLEL_MIN || m_pool == nullptr) {
+        advance(0, len);
+    } else {
+        // 截面之间没有共享状态, 按线程池大小(含调用线程)分块
+        const std::size_t workers { std::min(m_pool->size() + 1, len) };
+        const std::size_t chunk { (len + workers - 1) / workers };
+        m_pool->parallel_for((len + chunk - 1) / chunk, [&advance, chunk, len](std::size_t c) { advance(c * chunk, std::min(c * chunk + chunk, len)); });
+    }
+
+    update_governing();
+    const bool any { std::find(changed.begin(), changed.end(), 1) != changed.end() };
+    m_lifeDirty = m_lifeDirty || any;
+    return any;
+}
+
+void Rotor::update_governing()
+{
+    m_governing = 0;
+    for (std::size_t k { 1 }; k < m_sections.size(); ++k) {
+        if (m_sections[k].stress.thermalStressMargin < m_sections[m_governing].stress.thermalStressMargin) {
+            m_governing = k;
+        }
+    }
+}
+
+std::size_t Rotor::life_section() const
+{
+    std::size_t res { 0 };
+    for (std::size_t k { 1 }; k < m_sections.size(); ++k) {
+        if (m_sections[k].life.lifeRatio > m_sections[res].life.lifeRatio) {
+            res = k;
+        }
+    }
+    return res;
+}
+
+std::pair<double, double> Rotor::max_life() const
+{
+    double lr { 0 }, olr { 0 };
+    for (const auto& section : m_sections) {
+        lr = std::max(lr, section.life.lifeRatio);
+        olr = std::max(olr, section.life.overhaulLifeRatio);
+    }
+    return { lr, olr };
+}
+
+std::vector<std::string> Rotor::life_fields() const
 {
-    double lr = m_redis->m_hget("TS" + m_unit + ":Mechanism:RotorLife", "life" + m_name);
-    double olr = m_redis->m_hget("TS" + m_unit + ":Mechanism:RotorLife", "overhaulLife" + m_name);
+    std::vector<std::string> fields;
+    fields.reserve(2 * m_sections.size());
+    for (std::size_t k { 0 }; k < m_sections.size(); ++k) {
+        const std::string suffix { k == 0 ? m_name : m_name + "." + m_sections[k].name };
+        fields.emplace_back("life" + suffix);
+        fields.emplace_back("overhaulLife" + suffix);
+    }
+    return fields;
+}
+
+std::vector<std::pair<std::string, std::string>> Rotor::take_life_values()
+{
+    m_lifeDirty = false;
+    const auto fields = life_fields();
+    std::vector<std::pair<std::string, std::string>> values;
+    for (std::size_t k { 0 }; k < m_sections.size(); ++k) {
+        values.emplace_back(fields[2 * k], std::to_string(m_sections[k].life.lifeRatio));
+        values.emplace_back(fields[2 * k + 1], std::to_string(m_sections[k].life.overhaulLifeRatio));
+    }
+    return values;
+}
 
+void Rotor::save_life()
+{
+    m_redis->m_hmset(life_key(), take_life_values());
+}
+
+json Rotor::build_message(double lr, double olr) const
+{
+    const RotorSection& g = m_sections[m_governing];
     json j;
     j["lifeRatio"] = lr;
     j["overhaulLifeRatio"] = olr;
-    if (lr > 0.75) {
-        j["alert"] = 2; // "建议转子大修"
-    } else if (olr > 0.06) {
-        j["alert"] = 1; // "建议转子报废"
-    } else {
-        j["alert"] = 0; // "正常"
+    j["alert"] = alert_level(lr, olr);
+    j["ts"] = g.thermal.surface_temp();
+    j["temperature"] = g.thermal.fieldmHR();
+    j["t0"] = g.thermal.center_temp();
+    j["centerThermalStress"] = g.stress.centerThermalStress;
+    j["surfaceThermalStress"] = g.stress.surfaceThermalStress;
+    j["thermalStress"] = g.stress.thermalStress;
+    j["thermalStressMargin"] = g.stress.thermalStressMargin;
+    if (m_sections.size() > 1) {
+        j["governingSection"] = g.name;
+        json sections = json::array();
+        for (const auto& section : m_sections) {
+            sections.push_back({
+                { "name", section.name },
+                { "lifeRatio", section.life.lifeRatio },
+                { "overhaulLifeRatio", section.life.overhaulLifeRatio },
+                { "ts", section.thermal.surface_temp() },
+                { "t0", section.thermal.center_temp() },
+                { "centerThermalStress", section.stress.centerThermalStress },
+                { "surfaceThermalStress", section.stress.surfaceThermalStress },
+                { "thermalStress", section.stress.thermalStress },
+                { "thermalStressMargin", section.stress.thermalStressMargin }
+            });
+        }
+        j["sections"] = std::move(sections);
     }
-    j["ts"] = surfaceTemp.cur;
-    j["temperature"] = fieldmHR;
-    j["t0"] = centerTemp.cur;
-    j["centerThermalStress"] = centerThermalStress;
-    j["surfaceThermalStress"] = surfaceThermalStress;
-    j["thermalStress"] = thermalStress;
-    j["thermalStressMargin"] = thermalStressMargin;
+    return j;
+}
 
-    const std::string jsonString = j.dump();
+json Rotor::message() const
+{
+    const auto [lr, olr] = max_life();
+    return build_message(lr, olr);
+}
+
+void Rotor::send_message()
+{
+    const auto values = m_redis->m_hmget("TS" + m_unit + ":Mechanism:RotorLife", life_fields());
+    double lr { 0 }, olr { 0 };
+    for (std::size_t k { 0 }; k + 1 < values.size(); k += 2) {
+        lr = std::max(lr, values[k]);
+        olr = std::max(olr, values[k + 1]);
+    }
+
+    const std::string jsonString = build_message(lr, olr).dump();
     m_MQTTCli->publish("TS" + m_unit + "/Rotor" + m_name, jsonString, QOS);
     // m_redis->m_hset("TS" + m_unit + ":Mechanism:SendMessage", m_name, jsonString);
     // std::cout << j.dump(4) << '\n';
-    m_ModbusServer.get()->update(j, m_name);
 }
 
-void Rotor::get_control_command()
+RotorState Rotor::state() const
 {
-    std::vector<uint16_t> registers;
-    try {
-        registers = m_ModbusCli.get()->read_registers(m_controlWord, 1);
-    } catch (const std::exception& e) {
-        spdlog::warn("Exception from get_control_command: {}", e.what());
+    // 直接使用内存中的寿命, 避免每个转子两次Redis往返
+    const auto [lr, olr] = max_life();
+    const RotorSection& g = m_sections[m_governing];
+    return {
+        lr,
+        olr,
+        alert_level(lr, olr),
+        g.thermal.surface_temp(),
+        g.thermal.center_temp(),
+        g.stress.centerThermalStress,
+        g.stress.surfaceThermalStress,
+        g.stress.thermalStress,
+        g.stress.thermalStressMargin,
+        g.thermal.fieldmHR()
+    };
+}
+
+int Rotor::alert_level(double lr, double olr)
+{
+    if (lr > 0.75) {
+        return 2; // "建议转子大修"
+    } else if (olr > 0.06) {
+        return 1; // "建议转子报废"
+    }
+    return 0; // "正常"
+}
+
+bool Rotor::has_control_command(const std::vector<uint16_t>& registers)
+{
+    return !registers.empty() && (registers[0] & 0x3) != 0;
+}
+
+void Rotor::apply_control_command(const std::vector<uint16_t>& registers)
+{
+    if (registers.empty()) {
+        return;
     }
 
     uint16_t value = registers[0];
     bool firstBit = value & 0x1;
     bool secondBit = value & 0x2;
+    reset_life(firstBit, secondBit);
+}
 
-    if (firstBit) {
-        m_redis->m_hset("TS" + m_unit + ":Mechanism:RotorLife", "life" + m_name, "0");
+std::vector<std::pair<std::string, std::string>> Rotor::reset_values(bool life, bool overhaulLife) const
+{
+    const auto fields = life_fields();
+    std::vector<std::pair<std::string, std::string>> values;
+    for (std::size_t k { 0 }; k < m_sections.size(); ++k) {
+        if (life) {
+            values.emplace_back(fields[2 * k], "0");
+        }
+        if (overhaulLife) {
+            values.emplace_back(fields[2 * k + 1], "0");
+        }
     }
-    if (secondBit) {
-        m_redis->m_hset("TS" + m_unit + ":Mechanism:RotorLife", "overhaulLife" + m_name, "0");
+    return values;
+}
+
+void Rotor::clear_lives(bool life, bool overhaulLife)
+{
+    for (auto& section : m_sections) {
+        if (life) {
+            section.life.lifeRatio = 0;
+        }
+        if (overhaulLife) {
+            section.life.overhaulLifeRatio = 0;
+        }
     }
 }
 
-double Rotor::get_surface_temp(double min, double max)
+bool Rotor::reset_life(bool life, bool overhaulLife)
 {
+    if (!life && !overhaulLife) {
+        return true;
+    }
+    if (m_deferLifeWrites) {
+        clear_lives(life, overhaulLife);
+        m_lifeDirty = true;
+        return true;
+    }
+    // 写入成功后内存中的寿命才清零, 否则下次寿命累加保存时会覆盖Redis中的复位; 失败时两边都不变
+    if (!m_redis->m_hmset(life_key(), reset_values(life, overhaulLife))) {
+        spdlog::warn("Unable to reset the life of rotor {}", m_name);
+        return false;
+    }
+    clear_lives(life, overhaulLife);
+    return true;
+}
+
+std::vector<uint16_t> Rotor::read_registers(int start, int count, const char* what)
+{
+    std::vector<uint16_t> registers;
     try {
-        std::vector<uint16_t> registers = m_ModbusCli.get()->read_registers(0, 10);
-        if (!registers.empty()) {
-            for (const auto& reg : registers) {
-                std::cout << reg << " ";
-            }
-        }
-        std::cout << '\n';
+        registers = m_ModbusCli.get()->read_registers(start, count);
     } catch (const std::exception& e) {
-        spdlog::warn("Exception from get_surface_temp: {}", e.what());
+        spdlog::warn("Exception from reading {} of rotor {}: {}", what, m_name, e.what());
+    }
+    return registers;
+}
+
+double Rotor::to_surface_temp(const std::vector<uint16_t>& registers, double min, double max) const
+{
+    if (trace_enabled(TraceLevel::debug)) {
+        RegistersPayload payload {};
+        m_name.copy(payload.name, sizeof(payload.name));
+        payload.start = 0;
+        payload.count = static_cast<uint16_t>(registers.size());
+        std::copy_n(registers.begin(), std::min(registers.size(), std::size(payload.registers)), payload.registers);
+        trace(TraceLevel::debug, TraceEvent::surface_registers, payload);
     }
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -96,155 +328,110 @@ double Rotor::get_surface_temp(double min, double max)
     return dis(gen);
 }
 
-template <typename T>
-double Rotor::interpolation(double temp, const T& data, std::size_t pointNum) const
+std::vector<uint16_t> Rotor::section_registers(std::size_t k, const std::vector<uint16_t>& registers) const
 {
-    if (pointNum == 0 || pointNum > data.X.size()) {
-        return 0.0;
-    }
-
-    if (temp < data.X[0]) {
-        return data.Y[0];
-    } else if (temp >= data.X[pointNum - 1]) {
-        return data.Y[pointNum - 1];
-    } else {
-        for (std::size_t i { 1 }; i < pointNum; ++i) {
-            if (temp < data.X[i]) {
-                double value = data.Y[i - 1] + (data.Y[i] - data.Y[i - 1]) * (temp - data.X[i - 1]) / (data.X[i] - data.X[i - 1]);
-                return value;
-            }
-        }
-    }
-    return 0;
-}
-
-// 计算T1, T2~T19, T20
-void Rotor::cal_T()
-{
-    for (std::size_t i { 0 }; i < 20; ++i) {
-        tc = interpolation(field[i].last, m_para.tcz);
-        sh = interpolation(field[i].last, m_para.shz);
-        double ri = m_para.radius - m_para.deltaR * i;
-
-        double term1 = 2 * tc * m_para.scanCycle;
-        double term2, term3, term4;
-        if (i == 0) {
-            term2 = 2 * (ri - m_para.deltaR / 4) * surfaceTemp.last;
-            term3 = 3 * (ri - m_para.deltaR / 2) * field[i].last;
-            term4 = (ri - m_para.deltaR) * field[i + 1].last;
-        } else if (i != 20) {
-            term2 = ri * field[i - 1].last;
-            term3 = (2 * ri - m_para.deltaR) * field[i].last;
-            term4 = (ri - m_para.deltaR) * field[i + 1].last;
-        } else {
-            term2 = ri * field[i - 1].last;
-            term3 = 3 * (ri - m_para.deltaR / 2) * field[i].last;
-            term4 = 2 * (ri - 3 * m_para.deltaR / 4) * centerTemp.last;
-        }
-        double denominator = (2 * ri - m_para.deltaR) * m_para.density * sh * m_para.deltaR * m_para.deltaR * 1000;
-
-        double T = term1 * (term2 - term3 + term4) / denominator;
-        T += field[i].last;
-        field[i].cur = T;
+    if (k == 0) {
+        return registers;
     }
-    // 计算中心孔温度
-    centerTemp.cur = (3 * field[19].cur - field[18].cur) / 2;
+    const std::size_t r { m_sections[k].surfaceRegister };
+    return r < registers.size() ? std::vector<uint16_t> { registers[r] } : std::vector<uint16_t> {};
 }
 
-void Rotor::cal_average_T()
+void Rotor::update_surface_temp(const std::vector<uint16_t>& registers)
 {
-    double temp { 0 }, temp1 { 0 }, temp2 { 0 }, temp3 { 0 };
-    double ri, denominator, numerator;
-
-    for (std::size_t i { 0 }; i < 20; ++i) {
-        ri = m_para.radius - m_para.deltaR * i;
-        denominator = 2 * ri * m_para.deltaR - m_para.deltaR * m_para.deltaR;
-        numerator = denominator * field[i].cur;
-        temp += numerator;
-        temp1 += denominator;
-        temp2 += numerator;
-        temp3 += denominator;
-        if (i % 2 != 0) {
-            fieldmHR[(i - 1) / 2] = temp2 / temp3;
-            temp2 = 0;
-            temp3 = 0;
-        }
+    for (std::size_t k { 0 }; k < m_sections.size(); ++k) {
+        m_sections[k].thermal.set_surface_temp(to_surface_temp(section_registers(k, registers), 0, 600));
     }
-    aveTemp = temp / temp1;
 }
 
-void Rotor::update_T()
+void Rotor::set_lives(std::span<const double> values)
 {
-    for (std::size_t i { 0 }; i < 20; ++i) {
-        field[i].last = field[i].cur;
+    for (std::size_t k { 0 }; k < m_sections.size() && 2 * k + 1 < values.size(); ++k) {
+        m_sections[k].life.lifeRatio = values[2 * k];
+        m_sections[k].life.overhaulLifeRatio = values[2 * k + 1];
     }
-    centerTemp.last = centerTemp.cur;
-    surfaceTemp.last = surfaceTemp.cur;
 }
 
-void Rotor::init()
+bool Rotor::init_field(const std::vector<uint16_t>& registers)
 {
-    lifeRatio = m_redis->m_hget("TS" + m_unit + ":Mechanism:RotorLife", "life" + m_name);
-    overhaulLifeRatio = m_redis->m_hget("TS" + m_unit + ":Mechanism:RotorLife", "overhaulLife" + m_name);
-
-    double flangeTemp { get_surface_temp(0, 600) };
-    for (std::size_t i { 0 }; i < 20; ++i) {
-        field[i].last = flangeTemp;
+    if (registers.size() < SURFACE_REGISTER_NUM) {
+        return false;
     }
-    surfaceTemp.last = flangeTemp;
-    centerTemp.last = flangeTemp;
+    for (std::size_t k { 0 }; k < m_sections.size(); ++k) {
+        m_sections[k].thermal.init_field(to_surface_temp(section_registers(k, registers), 0, 600));
+    }
+    m_lastStep = std::chrono::steady_clock::now();
+    return true;
 }
 
-void Rotor::temp_field()
+bool Rotor::init()
 {
-    cal_T();
-    cal_average_T();
-    update_T();
+    return init_field(read_registers(SURFACE_REGISTER_START, SURFACE_REGISTER_NUM, "surface temperature"));
 }
 
-void Rotor::thermal_stress()
+json Rotor::section_snapshot(const RotorSection& section)
 {
-    double em { interpolation(aveTemp, m_para.emz) };
-    double pr { interpolation(aveTemp, m_para.prz) };
-    double lec { interpolation(aveTemp, m_para.lecz, m_para.lecz.X.size()) };
-
-    surfaceThermalStress = m_para.surfaceFactor * em * lec * (aveTemp - surfaceTemp.cur) / 1000 / (1 - pr);
-    centerThermalStress = m_para.centerFactor * em * lec * (aveTemp - centerTemp.cur) / 1000 / (1 - pr);
-    thermalStress = std::max(fabs(surfaceThermalStress), fabs(centerThermalStress));
-    thermalStressMargin = 100.0 * (1 - thermalStress / m_para.freeFactor);
+    std::vector<double> field(section.thermal.nodes());
+    section.thermal.copy_field(field.data(), field.size());
+    json j;
+    j["field"] = field;
+    j["ts"] = section.thermal.surface_temp();
+    j["t0"] = section.thermal.center_temp();
+    j["lifeRatio"] = section.life.lifeRatio;
+    j["overhaulLifeRatio"] = section.life.overhaulLifeRatio;
+    j["thermalStressMax"] = section.life.thermalStressMax;
+    return j;
 }
 
-void Rotor::life(double K)
+bool Rotor::restore_section(RotorSection& section, const json& snapshot)
 {
-    // 最小寿命消耗率对应的应力
-    double thermalStressMin;
-    TempZone SNx;
-    double life, lifeConsumptionRate;
+    if (!section.thermal.load_field(snapshot.at("field").get<std::vector<double>>(), snapshot.at("ts").get<double>(), snapshot.at("t0").get<double>())) {
+        return false;
+    }
+    section.life.lifeRatio = snapshot.at("lifeRatio").get<double>();
+    section.life.overhaulLifeRatio = snapshot.at("overhaulLifeRatio").get<double>();
+    section.life.thermalStressMax = snapshot.at("thermalStressMax").get<double>();
+    section.stress = section.thermal.thermal_stress();
+    return true;
+}
 
-    if (aveTemp < m_para.sn[0]) {
-        SNx = m_para.SN1;
-    } else if (aveTemp > m_para.sn[1]) {
-        SNx = m_para.SN3;
-    } else {
-        SNx = m_para.SN2;
+json Rotor::snapshot() const
+{
+    json j = section_snapshot(m_sections[0]);
+    j["time"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    if (m_sections.size() > 1) {
+        json sections = json::array();
+        for (std::size_t k { 1 }; k < m_sections.size(); ++k) {
+            sections.push_back(section_snapshot(m_sections[k]));
+        }
+        j["sections"] = std::move(sections);
     }
-    thermalStressMin = fabs(SNx.X[0]);
+    return j;
+}
 
-    if (fabs(thermalStress) >= thermalStressMin) {
-        if (thermalStress > thermalStressMax) {
-            thermalStressMax = thermalStress;
+bool Rotor::restore(const json& snapshot)
+{
+    try {
+        const std::size_t extra { m_sections.size() - 1 };
+        if (extra > 0 && (!snapshot.contains("sections") || snapshot["sections"].size() != extra)) {
+            spdlog::warn("Snapshot of rotor {} has a different section count", m_name);
+            return false;
         }
-    } else {
-        if (thermalStressMax > thermalStressMin) {
-            life = interpolation(K * thermalStressMax, SNx, SNx.X.size());
-            lifeConsumptionRate = 1.0 / life;
-            lifeRatio += lifeConsumptionRate;
-            overhaulLifeRatio += lifeConsumptionRate;
-            thermalStressMax = 0;
-
-            m_redis->m_hset("TS" + m_unit + ":Mechanism:RotorLife", "life" + m_name, std::to_string(lifeRatio));
-            m_redis->m_hset("TS" + m_unit + ":Mechanism:RotorLife", "overhaulLife" + m_name, std::to_string(overhaulLifeRatio));
+        for (std::size_t k { 0 }; k < m_sections.size(); ++k) {
+            if (!restore_section(m_sections[k], k == 0 ? snapshot : snapshot["sections"][k - 1])) {
+                spdlog::warn("Snapshot of rotor {} has a different node count", m_name);
+                return false;
+            }
         }
+        update_governing();
+
+        // 各主机的steady_clock不可比, 用系统时间计算快照的年龄, 下次step()推进这段时间
+        const long long now { std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() };
+        const double age { std::clamp((now - snapshot.at("time").get<long long>()) / 1000.0, 0.0, STEP_ELAPSED_MAX) };
+        m_lastStep = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(age));
+        return true;
+    } catch (const std::exception& e) {
+        spdlog::warn("Invalid snapshot of rotor {}: {}", m_name, e.what());
+        return false;
     }
-    // std::cout << "lifeRatio: " << lifeRatio << "\toverhaulLifeRatio: " << overhaulLifeRatio << '\n';
 }
@@ -7,19 +7,111 @@
 #include "myMQTT.h"
 #include "myModbus.h"
 #include "myRedis.h"
+#include "myTrace.h"
+#include "rotorSection.h"
 #include "utils.h"
+#include <chrono>
 #include <memory>
+#include <span>
+
+class ThreadPool;
 
 constexpr const int QOS { 1 };
+constexpr const double STEP_ELAPSED_MAX { 3600 }; // 单次推进的最长时间, 秒, 超过时按此值推进
+constexpr const int SURFACE_REGISTER_START { 0 };
+constexpr const int SURFACE_REGISTER_NUM { 10 };
+constexpr const int MODBUS_READ_MAX { 125 }; // 一次读保持寄存器的上限
+
+// 一次采集读取的连续寄存器
+struct RegisterBlock {
+    int start;
+    int count;
+};
+
+// 一个周期的输出快照, 字段与send_message的json一致. 有多个截面时, 寿命为各截面的最大值,
+// 温度和应力取热应力裕度最小(起控制作用)的截面
+struct RotorState {
+    double lifeRatio;
+    double overhaulLifeRatio;
+    int alert;
+    double ts;
+    double t0;
+    double centerThermalStress;
+    double surfaceThermalStress;
+    double thermalStress;
+    double thermalStressMargin;
+    std::array<double, 10> temperature;
+};
 
 class Rotor {
 public:
+    // sections由RotorRegistry持有, 截面0由para描述, 其余对应para.sections
     Rotor(const std::string& name, const std::string& unit, const Parameters& para, const int controlWord,
-        std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli,
-        std::unique_ptr<MyModbusClient> modbusCli, std::shared_ptr<MyModbusServer> modbusServer);
+        std::span<RotorSection> sections, std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli,
+        std::unique_ptr<MyModbusClient> modbusCli);
 
-    void run();
+    // 构造不做任何I/O. 运行前先set_lives(), 再用init()或init_field()初始化温度场
+    // 各截面的寿命字段, 依次为life和overhaulLife: 截面0为life<name>, 其余为life<name>.<截面名>
+    std::vector<std::string> life_fields() const;
+    // 按life_fields()的顺序设置寿命
+    void set_lives(std::span<const double> values);
+    // 同步读取表面温度并初始化温度场, 读取失败或不完整时返回false, 温度场不变
+    bool init();
+    // 同步执行一个周期: 采集(控制字+表面温度) -> 控制字 -> 计算 -> 表面温度.
+    // saveLife为false时寿命的变化留到之后保存, pollControl为false时不读控制字
+    void run(bool saveLife = true, bool pollControl = true);
     void send_message();
+    RotorState state() const;
+    const std::string& name() const { return m_name; }
+    const Parameters& parameters() const { return m_para; }
+    int control_word() const { return m_controlWord; }
+    std::size_t section_count() const { return m_sections.size(); }
+    // 截面数不少于SECTION_PARALLEL_MIN时在pool上分块推进, 为空时顺序推进
+    void set_pool(ThreadPool* pool) { m_pool = pool; }
+    const RotorSection& section(std::size_t k) const { return m_sections[k]; }
+    // 热应力裕度最小的截面
+    std::size_t governing_section() const { return m_governing; }
+    // 寿命消耗最多的截面
+    std::size_t life_section() const;
+    // 起控制作用的截面的温度场与寿命, 供推演使用
+    const ThermalModel& thermal() const { return m_sections[m_governing].thermal; }
+    const LifeState& life_state() const { return m_sections[m_governing].life; }
+
+    // 以下接口把init()/run()拆分为I/O与计算两部分, 供异步调度使用
+    // 寄存器少于SURFACE_REGISTER_NUM(读取失败)时返回false, 温度场不变
+    bool init_field(const std::vector<uint16_t>& registers);
+    // 表面温度寄存器块; pollControl为true且控制字与之相距不超过MODBUS_READ_MAX时扩展为包含控制字
+    RegisterBlock acquisition_block(bool pollControl) const;
+    bool contains_control_word(const RegisterBlock& block) const;
+    // 从block读到的寄存器中取出[start, start+count), 不完整时返回空
+    static std::vector<uint16_t> slice(const std::vector<uint16_t>& registers, const RegisterBlock& block, int start, int count);
+    static bool has_control_command(const std::vector<uint16_t>& registers);
+    void apply_control_command(const std::vector<uint16_t>& registers);
+    // 所有截面的寿命/大修寿命清零: 先写入Redis, 成功后才清零内存中的寿命, 返回是否成功.
+    // defer_life_writes()之后不写Redis, 只清零并标记未保存, 由调用者核对租约后保存
+    bool reset_life(bool life, bool overhaulLife);
+    void defer_life_writes(bool defer) { m_deferLifeWrites = defer; }
+    // reset_life()要写入life_key()的字段
+    std::vector<std::pair<std::string, std::string>> reset_values(bool life, bool overhaulLife) const;
+    // 清零内存中的寿命, 不写Redis
+    void clear_lives(bool life, bool overhaulLife);
+    // 按距上次推进的实际时间推进所有截面的温度场/应力/寿命, 返回true表示寿命有变化
+    bool step();
+    // 推进dt秒, 截面数不少于SECTION_PARALLEL_MIN时分块并行
+    bool step(double dt);
+    // 寿命有未保存的变化
+    bool life_dirty() const { return m_lifeDirty; }
+    void save_life();
+    std::string life_key() const { return "TS" + m_unit + ":Mechanism:RotorLife"; }
+    // 要保存的寿命字段, 并清除未保存标记; 由调用者写入life_key()
+    std::vector<std::pair<std::string, std::string>> take_life_values();
+    void update_surface_temp(const std::vector<uint16_t>& registers);
+    // 基于内存状态的消息, 不访问Redis
+    json message() const;
+    // 温度场和寿命的快照, 用于分片模式下在进程间交接转子(shard.h). 截面0在顶层, 其余在"sections"中
+    json snapshot() const;
+    // 恢复snapshot()保存的状态, 并按快照之后经过的时间推进. 快照无效时返回false, 需要init()
+    bool restore(const json& snapshot);
 
 private:
     const std::string m_name;
@@ -27,40 +119,28 @@ private:
     const Parameters& m_para;
     const int m_controlWord;
 
-    double tc;
-    double sh;
-    double aveTemp;
-    double surfaceThermalStress;
-    double centerThermalStress;
-    double thermalStress;
-    double thermalStressMargin;
-    double thermalStressMax; // 最大寿命消耗率对应的应力
-    double lifeRatio { 0 };
-    double overhaulLifeRatio { 0 };
-
-    TempPoint surfaceTemp {};
-    TempPoint centerTemp {};
-    std::array<TempPoint, 20> field {};
+    std::span<RotorSection> m_sections;
+    std::size_t m_governing { 0 };
+    bool m_lifeDirty { false };
+    bool m_deferLifeWrites { false };
+    std::chrono::steady_clock::time_point m_lastStep {};
+    ThreadPool* m_pool { nullptr };
 
     std::shared_ptr<MyRedis> m_redis;
     std::shared_ptr<MyMQTT> m_MQTTCli;
     std::unique_ptr<MyModbusClient> m_ModbusCli;
-    std::shared_ptr<MyModbusServer> m_ModbusServer;
 
-    // 输出
-    std::array<double, 10> fieldmHR;
-    void get_control_command();
-    double get_surface_temp(double min, double max);
-    template <typename T>
-    double interpolation(double temp, const T& data, std::size_t pointNum = 8) const;
-    // 计算T1, T2~T19, T20
-    void cal_T();
-    void cal_average_T();
-    void update_T();
-    void init();
-    void temp_field();
-    void thermal_stress();
-    void life(double K = 1.0 /*热应力集中系数*/);
+    static int alert_level(double lr, double olr);
+    json build_message(double lr, double olr) const;
+    // 各截面寿命的最大值
+    std::pair<double, double> max_life() const;
+    void update_governing();
+    double to_surface_temp(const std::vector<uint16_t>& registers, double min, double max) const;
+    // 截面k的表面温度寄存器
+    std::vector<uint16_t> section_registers(std::size_t k, const std::vector<uint16_t>& registers) const;
+    std::vector<uint16_t> read_registers(int start, int count, const char* what);
+    static json section_snapshot(const RotorSection& section);
+    static bool restore_section(RotorSection& section, const json& snapshot);
 };
 
 #endif // ROTOR_H
\ No newline at end of file
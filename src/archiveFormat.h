@@ -0,0 +1,347 @@
+#ifndef ARCHIVEFORMAT_H
+#define ARCHIVEFORMAT_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// 转子状态归档文件格式, 写者(ArchiveWriter)与读者(ArchiveReader)共用, 不依赖其他头文件.
+//
+// 目录<dir>/TS<unit>/下每个UTC日一个文件YYYYMMDD.tsa, 只追加. 文件由块组成, 每块为一个转子连续的
+// 至多ARCHIVE_BLOCK_SAMPLES个样本, 按列存放: ArchiveBlockHeader, 转子名, 时间列, 再依次为ARCHIVE_VALUE_NUM个值列.
+// 时间列(毫秒)为Gorilla的二阶差分编码, 值列为Gorilla的XOR浮点编码, 各列按字节对齐.
+// 块头中有时间范围, 按时间或转子查找时不解码的块直接跳过. 块以一次write追加, 进程中断时末尾不完整的块被读者忽略
+
+constexpr const uint32_t ARCHIVE_MAGIC { 0x41535354 }; // "TSSA"
+constexpr const uint16_t ARCHIVE_VERSION { 1 };
+constexpr const std::size_t ARCHIVE_BLOCK_SAMPLES { 120 }; // 5秒周期时为10分钟
+constexpr const std::size_t ARCHIVE_VALUE_NUM { 19 };
+
+// 值列, 与RotorState/RegisterSource的顺序一致
+constexpr const char* ARCHIVE_COLUMNS[ARCHIVE_VALUE_NUM] {
+    "lifeRatio", "overhaulLifeRatio", "alert", "ts", "t0",
+    "centerThermalStress", "surfaceThermalStress", "thermalStress", "thermalStressMargin",
+    "temperature[0]", "temperature[1]", "temperature[2]", "temperature[3]", "temperature[4]",
+    "temperature[5]", "temperature[6]", "temperature[7]", "temperature[8]", "temperature[9]"
+};
+
+struct ArchiveBlockHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t nameLength;
+    uint32_t count; // 样本数
+    uint32_t valueNum; // 值列数
+    int64_t firstMs; // system_clock, 毫秒
+    int64_t lastMs;
+    uint32_t timeBytes; // 时间列字节数
+    uint32_t valueBytes[ARCHIVE_VALUE_NUM]; // 各值列字节数
+};
+static_assert(sizeof(ArchiveBlockHeader) == 112, "ArchiveBlockHeader layout changed");
+
+constexpr const int64_t ARCHIVE_MS_PER_DAY { 86400000 };
+constexpr const int64_t ARCHIVE_MAX_DAY { 2932896 }; // 9999-12-31
+
+// 样本所在的UTC日
+inline int64_t archive_day(int64_t timeMs)
+{
+    return timeMs >= 0 ? timeMs / ARCHIVE_MS_PER_DAY : (timeMs - ARCHIVE_MS_PER_DAY + 1) / ARCHIVE_MS_PER_DAY;
+}
+
+// YYYYMMDD.tsa
+inline std::string archive_file_name(int64_t day)
+{
+    day = std::clamp<int64_t>(day, 0, ARCHIVE_MAX_DAY);
+    const std::time_t t { static_cast<std::time_t>(day * (ARCHIVE_MS_PER_DAY / 1000)) };
+    std::tm tm {};
+    ::gmtime_r(&t, &tm);
+    char name[16];
+    std::strftime(name, sizeof(name), "%Y%m%d", &tm);
+    return std::string(name) + ".tsa";
+}
+
+struct ArchiveSample {
+    int64_t timeMs;
+    double values[ARCHIVE_VALUE_NUM];
+};
+
+class BitWriter {
+private:
+    std::vector<uint8_t> m_bytes;
+    uint64_t m_acc { 0 };
+    int m_accBits { 0 };
+
+public:
+    void clear()
+    {
+        m_bytes.clear();
+        m_acc = 0;
+        m_accBits = 0;
+    }
+
+    // 写入value的低n位, 高位在前, n <= 64
+    void write(uint64_t value, int n)
+    {
+        if (n > 32) {
+            write(value >> 32, n - 32);
+            n = 32;
+        }
+        m_acc = (m_acc << n) | (value & ((uint64_t { 1 } << n) - 1));
+        m_accBits += n;
+        while (m_accBits >= 8) {
+            m_accBits -= 8;
+            m_bytes.push_back(static_cast<uint8_t>(m_acc >> m_accBits));
+        }
+        m_acc &= (uint64_t { 1 } << m_accBits) - 1;
+    }
+
+    // 补齐到字节边界后的内容
+    const std::vector<uint8_t>& finish()
+    {
+        if (m_accBits > 0) {
+            m_bytes.push_back(static_cast<uint8_t>(m_acc << (8 - m_accBits)));
+            m_accBits = 0;
+        }
+        m_acc = 0;
+        return m_bytes;
+    }
+};
+
+class BitReader {
+private:
+    const uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_pos { 0 }; // 位
+
+public:
+    BitReader(const uint8_t* data, std::size_t size)
+        : m_data { data }
+        , m_size { size }
+    {
+    }
+
+    // 超出末尾时返回false, 已读出的位不可信
+    bool read(int n, uint64_t& out)
+    {
+        if (m_pos + n > m_size * 8) {
+            return false;
+        }
+        out = 0;
+        for (int i { 0 }; i < n;) {
+            const std::size_t byte { m_pos / 8 };
+            const int offset { static_cast<int>(m_pos % 8) };
+            const int take { std::min(8 - offset, n - i) };
+            const uint64_t bits { (static_cast<uint64_t>(m_data[byte]) >> (8 - offset - take)) & ((1u << take) - 1) };
+            out = (out << take) | bits;
+            m_pos += take;
+            i += take;
+        }
+        return true;
+    }
+};
+
+// 时间戳: 第一个原样64位, 之后为二阶差分 dod = (t_n - t_{n-1}) - (t_{n-1} - t_{n-2}):
+// 0 -> '0'; [-63, 64] -> '10'+7位; [-255, 256] -> '110'+9位; [-2047, 2048] -> '1110'+12位; 其余 -> '1111'+64位
+class TimeEncoder {
+private:
+    int64_t m_last { 0 };
+    int64_t m_delta { 0 };
+    bool m_first { true };
+
+public:
+    void reset()
+    {
+        m_last = 0;
+        m_delta = 0;
+        m_first = true;
+    }
+
+    void encode(BitWriter& out, int64_t t)
+    {
+        if (m_first) {
+            out.write(static_cast<uint64_t>(t), 64);
+            m_last = t;
+            m_first = false;
+            return;
+        }
+        const int64_t delta { t - m_last };
+        const int64_t dod { delta - m_delta };
+        if (dod == 0) {
+            out.write(0, 1);
+        } else if (dod >= -63 && dod <= 64) {
+            out.write(0b10, 2);
+            out.write(static_cast<uint64_t>(dod + 63), 7);
+        } else if (dod >= -255 && dod <= 256) {
+            out.write(0b110, 3);
+            out.write(static_cast<uint64_t>(dod + 255), 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            out.write(0b1110, 4);
+            out.write(static_cast<uint64_t>(dod + 2047), 12);
+        } else {
+            out.write(0b1111, 4);
+            out.write(static_cast<uint64_t>(dod), 64);
+        }
+        m_delta = delta;
+        m_last = t;
+    }
+};
+
+class TimeDecoder {
+private:
+    BitReader m_in;
+    int64_t m_last { 0 };
+    int64_t m_delta { 0 };
+    bool m_first { true };
+
+public:
+    TimeDecoder(const uint8_t* data, std::size_t size)
+        : m_in { data, size }
+    {
+    }
+
+    bool next(int64_t& t)
+    {
+        uint64_t v { 0 };
+        if (m_first) {
+            if (!m_in.read(64, v)) {
+                return false;
+            }
+            m_last = static_cast<int64_t>(v);
+            m_first = false;
+            t = m_last;
+            return true;
+        }
+        int prefix { 0 };
+        for (; prefix < 4; ++prefix) {
+            if (!m_in.read(1, v)) {
+                return false;
+            }
+            if (v == 0) {
+                break;
+            }
+        }
+        int64_t dod { 0 };
+        constexpr const int BITS[4] { 7, 9, 12, 64 };
+        constexpr const int64_t BIAS[4] { 63, 255, 2047, 0 };
+        if (prefix > 0) {
+            if (!m_in.read(BITS[prefix - 1], v)) {
+                return false;
+            }
+            dod = static_cast<int64_t>(v) - BIAS[prefix - 1];
+        }
+        m_delta += dod;
+        m_last += m_delta;
+        t = m_last;
+        return true;
+    }
+};
+
+// 浮点: 第一个原样64位, 之后与前一个值异或: 0 -> '0'; 有效位落在前一个窗口内 -> '10'+窗口内的位;
+// 否则 -> '11'+5位前导零数+6位有效位数(64记为0)+有效位
+class ValueEncoder {
+private:
+    uint64_t m_last { 0 };
+    int m_leading { -1 }; // -1: 还没有窗口
+    int m_trailing { 0 };
+    bool m_first { true };
+
+public:
+    void reset()
+    {
+        m_last = 0;
+        m_leading = -1;
+        m_trailing = 0;
+        m_first = true;
+    }
+
+    void encode(BitWriter& out, double value)
+    {
+        const uint64_t bits { std::bit_cast<uint64_t>(value) };
+        if (m_first) {
+            out.write(bits, 64);
+            m_last = bits;
+            m_first = false;
+            return;
+        }
+        const uint64_t x { bits ^ m_last };
+        m_last = bits;
+        if (x == 0) {
+            out.write(0, 1);
+            return;
+        }
+        const int leading { std::min(std::countl_zero(x), 31) };
+        const int trailing { std::countr_zero(x) };
+        if (m_leading >= 0 && leading >= m_leading && trailing >= m_trailing) {
+            out.write(0b10, 2);
+            out.write(x >> m_trailing, 64 - m_leading - m_trailing);
+            return;
+        }
+        const int meaningful { 64 - leading - trailing };
+        out.write(0b11, 2);
+        out.write(static_cast<uint64_t>(leading), 5);
+        out.write(static_cast<uint64_t>(meaningful & 63), 6);
+        out.write(x >> trailing, meaningful);
+        m_leading = leading;
+        m_trailing = trailing;
+    }
+};
+
+class ValueDecoder {
+private:
+    BitReader m_in;
+    uint64_t m_last { 0 };
+    int m_leading { 0 };
+    int m_trailing { 0 };
+    bool m_first { true };
+
+public:
+    ValueDecoder(const uint8_t* data, std::size_t size)
+        : m_in { data, size }
+    {
+    }
+
+    bool next(double& value)
+    {
+        uint64_t v { 0 };
+        if (m_first) {
+            if (!m_in.read(64, v)) {
+                return false;
+            }
+            m_last = v;
+            m_first = false;
+            value = std::bit_cast<double>(m_last);
+            return true;
+        }
+        if (!m_in.read(1, v)) {
+            return false;
+        }
+        if (v != 0) {
+            if (!m_in.read(1, v)) {
+                return false;
+            }
+            if (v != 0) {
+                uint64_t leading { 0 };
+                uint64_t meaningful { 0 };
+                if (!m_in.read(5, leading) || !m_in.read(6, meaningful)) {
+                    return false;
+                }
+                m_leading = static_cast<int>(leading);
+                m_trailing = 64 - m_leading - (meaningful == 0 ? 64 : static_cast<int>(meaningful));
+                if (m_trailing < 0) {
+                    return false;
+                }
+            }
+            if (!m_in.read(64 - m_leading - m_trailing, v)) {
+                return false;
+            }
+            m_last ^= v << m_trailing;
+        }
+        value = std::bit_cast<double>(m_last);
+        return true;
+    }
+};
+
+#endif // ARCHIVEFORMAT_H
@@ -0,0 +1,84 @@
+#include "archiveReader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+ArchiveReader::ArchiveReader(const std::string& dir, const std::string& unit)
+    : m_dir { dir + "/TS" + unit }
+{
+}
+
+std::vector<std::string> ArchiveReader::files(int64_t fromMs, int64_t toMs) const
+{
+    // 文件名为YYYYMMDD.tsa, 按字典序即按日期
+    const std::string first { archive_file_name(archive_day(fromMs)) };
+    const std::string last { archive_file_name(archive_day(toMs)) };
+    std::vector<std::string> res;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_dir, ec)) {
+        const std::string name { entry.path().filename().string() };
+        if (entry.path().extension() == ".tsa" && name.size() == first.size() && name >= first && name <= last) {
+            res.emplace_back(entry.path().string());
+        }
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+std::size_t ArchiveReader::scan(int64_t fromMs, int64_t toMs, const std::string& rotor, const Visitor& fn) const
+{
+    std::size_t n { 0 };
+    std::vector<uint8_t> body;
+    std::string name;
+    ArchiveSample sample {};
+
+    for (const auto& path : files(fromMs, toMs)) {
+        std::ifstream file(path, std::ios::binary);
+        ArchiveBlockHeader header {};
+        while (file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION || header.valueNum != ARCHIVE_VALUE_NUM) {
+                break;
+            }
+            name.resize(header.nameLength);
+            if (!file.read(name.data(), static_cast<std::streamsize>(name.size()))) {
+                break;
+            }
+            const std::size_t bodySize { std::accumulate(std::begin(header.valueBytes), std::end(header.valueBytes), std::size_t { header.timeBytes }) };
+            if (header.lastMs < fromMs || header.firstMs > toMs || (!rotor.empty() && name != rotor)) {
+                file.seekg(static_cast<std::streamoff>(bodySize), std::ios::cur);
+                continue;
+            }
+            body.resize(bodySize);
+            if (!file.read(reinterpret_cast<char*>(body.data()), static_cast<std::streamsize>(bodySize))) {
+                break;
+            }
+
+            // 逐样本从各列解码
+            const uint8_t* p { body.data() };
+            TimeDecoder time(p, header.timeBytes);
+            p += header.timeBytes;
+            std::vector<ValueDecoder> values;
+            values.reserve(ARCHIVE_VALUE_NUM);
+            for (std::size_t c { 0 }; c < ARCHIVE_VALUE_NUM; ++c) {
+                values.emplace_back(p, header.valueBytes[c]);
+                p += header.valueBytes[c];
+            }
+            for (uint32_t k { 0 }; k < header.count; ++k) {
+                bool ok { time.next(sample.timeMs) };
+                for (std::size_t c { 0 }; c < ARCHIVE_VALUE_NUM && ok; ++c) {
+                    ok = values[c].next(sample.values[c]);
+                }
+                if (!ok) {
+                    break;
+                }
+                if (sample.timeMs >= fromMs && sample.timeMs <= toMs) {
+                    fn(name, sample);
+                    ++n;
+                }
+            }
+        }
+    }
+    return n;
+}
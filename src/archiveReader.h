@@ -0,0 +1,30 @@
+#ifndef ARCHIVEREADER_H
+#define ARCHIVEREADER_H
+
+#include "archiveFormat.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// 归档读者, 只依赖archiveFormat.h, 可单独编入导出工具或寿命审计程序. 流式读取, 一次只解码一个块:
+//
+//     ArchiveReader reader("archive", "1");
+//     reader.scan(fromMs, toMs, "HP", [](const std::string& rotor, const ArchiveSample& s) { use(s.values[0]); });
+class ArchiveReader {
+private:
+    const std::string m_dir;
+
+    // [fromMs, toMs]涉及的日文件, 按日期排序
+    std::vector<std::string> files(int64_t fromMs, int64_t toMs) const;
+
+public:
+    using Visitor = std::function<void(const std::string& rotor, const ArchiveSample& sample)>;
+
+    ArchiveReader(const std::string& dir, const std::string& unit);
+
+    // 回调[fromMs, toMs]内的样本, rotor为空时为所有转子. 按块的写入顺序回调, 同一转子的样本按时间先后.
+    // 时间范围外或其它转子的块只读块头, 不解码. 文件末尾不完整的块被忽略. 返回回调的样本数
+    std::size_t scan(int64_t fromMs, int64_t toMs, const std::string& rotor, const Visitor& fn) const;
+};
+
+#endif // ARCHIVEREADER_H
@@ -0,0 +1,299 @@
+#include "archiveWriter.h"
+#include "registerMap.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+static_assert(ARCHIVE_VALUE_NUM == REGISTER_SOURCE_NUM, "Archive columns must follow RegisterSource");
+
+namespace {
+
+template <typename T>
+void append_bytes(std::vector<uint8_t>& out, const T* data, std::size_t size)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+} // namespace
+
+ArchiveWriter::ArchiveWriter(const std::string& dir, const std::string& unit, const std::vector<std::string>& names)
+    : m_dir { dir + "/TS" + unit }
+    , m_names { names }
+    , m_blocks(names.size())
+    , m_journalPath { m_dir + "/" + ARCHIVE_JOURNAL_NAME }
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+    if (ec) {
+        spdlog::error("Unable to create archive directory {}: {}", m_dir, ec.message());
+        return;
+    }
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+    prune(archive_day(now.count()));
+    recover_journal();
+}
+
+ArchiveWriter::~ArchiveWriter() noexcept
+{
+    flush();
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+    if (m_journalFd != -1) {
+        ::close(m_journalFd);
+    }
+}
+
+void ArchiveWriter::append(std::size_t rotor, int64_t timeMs, const RotorState& state)
+{
+    ArchiveSample sample { timeMs, {} };
+    const RegisterValues values { pack_register_values(state) };
+    std::copy(values.begin(), values.end(), sample.values);
+    append_sample(rotor, sample);
+    append_record(m_journal, rotor, sample);
+}
+
+void ArchiveWriter::append_sample(std::size_t rotor, const ArchiveSample& sample)
+{
+    Block& block = m_blocks[rotor];
+    const int64_t timeMs { sample.timeMs };
+    const int64_t day { archive_day(timeMs) };
+    // 时间倒退(校时)时也另起一块, 块内时间单调
+    if (block.count > 0 && (day != block.day || timeMs < block.lastMs)) {
+        write_block(rotor);
+    }
+    if (block.count == 0) {
+        block.firstMs = timeMs;
+        block.day = day;
+    }
+    block.lastMs = timeMs;
+
+    block.timeEncoder.encode(block.time, timeMs);
+    for (std::size_t c { 0 }; c < ARCHIVE_VALUE_NUM; ++c) {
+        block.valueEncoders[c].encode(block.values[c], sample.values[c]);
+    }
+    block.samples.push_back(sample);
+
+    if (++block.count == ARCHIVE_BLOCK_SAMPLES) {
+        write_block(rotor);
+    }
+}
+
+void ArchiveWriter::sync()
+{
+    if (m_journalStale) {
+        rewrite_journal();
+    } else if (!m_journal.empty() && m_journalFd != -1) {
+        const ssize_t n { ::write(m_journalFd, m_journal.data(), m_journal.size()) };
+        if (n != static_cast<ssize_t>(m_journal.size())) {
+            spdlog::warn("Unable to write archive journal {}: {}", m_journalPath, n == -1 ? std::strerror(errno) : "short write");
+        }
+    }
+    m_journal.clear();
+}
+
+void ArchiveWriter::flush()
+{
+    for (std::size_t i { 0 }; i < m_blocks.size(); ++i) {
+        if (m_blocks[i].count > 0) {
+            write_block(i);
+        }
+    }
+    sync();
+}
+
+void ArchiveWriter::append_record(std::vector<uint8_t>& out, std::size_t rotor, const ArchiveSample& sample) const
+{
+    const std::string& name { m_names[rotor] };
+    ArchiveJournalRecord record {};
+    record.magic = ARCHIVE_JOURNAL_MAGIC;
+    record.nameLength = static_cast<uint16_t>(name.size());
+    record.sample = sample;
+    append_bytes(out, &record, sizeof(record));
+    append_bytes(out, name.data(), name.size());
+}
+
+void ArchiveWriter::recover_journal()
+{
+    std::ifstream in(m_journalPath, std::ios::binary);
+    const std::vector<char> data { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    std::size_t recovered { 0 };
+    std::size_t dropped { 0 };
+    std::size_t pos { 0 };
+    while (pos + sizeof(ArchiveJournalRecord) <= data.size()) {
+        ArchiveJournalRecord record;
+        std::memcpy(&record, data.data() + pos, sizeof(record));
+        if (record.magic != ARCHIVE_JOURNAL_MAGIC || pos + sizeof(record) + record.nameLength > data.size()) {
+            break;
+        }
+        const std::string name { data.data() + pos + sizeof(record), record.nameLength };
+        pos += sizeof(record) + record.nameLength;
+        const auto it = std::find(m_names.begin(), m_names.end(), name);
+        if (it == m_names.end()) {
+            ++dropped;
+            continue;
+        }
+        append_sample(static_cast<std::size_t>(it - m_names.begin()), record.sample);
+        ++recovered;
+    }
+    if (recovered > 0 || dropped > 0) {
+        spdlog::info("Archive journal {}: {} samples recovered, {} of unknown rotors dropped", m_journalPath, recovered, dropped);
+    }
+    // 同时去掉不完整的记录, 并打开日志供之后追加
+    rewrite_journal();
+}
+
+void ArchiveWriter::rewrite_journal()
+{
+    m_buffer.clear();
+    for (std::size_t i { 0 }; i < m_blocks.size(); ++i) {
+        for (const auto& sample : m_blocks[i].samples) {
+            append_record(m_buffer, i, sample);
+        }
+    }
+
+    const std::string tmp { m_journalPath + ".tmp" };
+    const int fd { ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644) };
+    if (fd == -1) {
+        spdlog::warn("Unable to create archive journal {}: {}", tmp, std::strerror(errno));
+        return;
+    }
+    if (!m_buffer.empty() && ::write(fd, m_buffer.data(), m_buffer.size()) != static_cast<ssize_t>(m_buffer.size())) {
+        spdlog::warn("Unable to write archive journal {}: {}", tmp, std::strerror(errno));
+        ::close(fd);
+        return;
+    }
+    if (::rename(tmp.c_str(), m_journalPath.c_str()) == -1) {
+        spdlog::warn("Unable to replace archive journal {}: {}", m_journalPath, std::strerror(errno));
+        ::close(fd);
+        return;
+    }
+    if (m_journalFd != -1) {
+        ::close(m_journalFd);
+    }
+    m_journalFd = fd;
+    m_journalStale = false;
+}
+
+bool ArchiveWriter::open_day(int64_t day)
+{
+    if (day == m_fileDay && m_fd != -1) {
+        return true;
+    }
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+    // 启动时已在构造中清理过
+    if (m_fileDay != -1 && day > m_fileDay) {
+        prune(day);
+    }
+    const std::string path { m_dir + "/" + archive_file_name(day) };
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd == -1) {
+        spdlog::error("Unable to open archive file {}: {}", path, std::strerror(errno));
+        m_fileDay = -1;
+        return false;
+    }
+    m_fileDay = day;
+    return true;
+}
+
+void ArchiveWriter::write_block(std::size_t rotor)
+{
+    Block& block = m_blocks[rotor];
+    const std::string& name { m_names[rotor] };
+
+    ArchiveBlockHeader header {};
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.nameLength = static_cast<uint16_t>(name.size());
+    header.count = static_cast<uint32_t>(block.count);
+    header.valueNum = ARCHIVE_VALUE_NUM;
+    header.firstMs = block.firstMs;
+    header.lastMs = block.lastMs;
+
+    const auto& time = block.time.finish();
+    header.timeBytes = static_cast<uint32_t>(time.size());
+    for (std::size_t c { 0 }; c < ARCHIVE_VALUE_NUM; ++c) {
+        header.valueBytes[c] = static_cast<uint32_t>(block.values[c].finish().size());
+    }
+
+    m_buffer.clear();
+    append_bytes(m_buffer, &header, sizeof(header));
+    append_bytes(m_buffer, name.data(), name.size());
+    append_bytes(m_buffer, time.data(), time.size());
+    for (auto& column : block.values) {
+        const auto& bytes = column.finish();
+        append_bytes(m_buffer, bytes.data(), bytes.size());
+    }
+
+    // O_APPEND下一次write追加整块, 读者不会看到交错的块
+    if (open_day(block.day)) {
+        const ssize_t n { ::write(m_fd, m_buffer.data(), m_buffer.size()) };
+        if (n != static_cast<ssize_t>(m_buffer.size())) {
+            spdlog::error("Unable to write archive block of rotor {}: {}", name, n == -1 ? std::strerror(errno) : "short write");
+        } else {
+            m_rawBytes += block.count * sizeof(ArchiveSample);
+            m_writtenBytes += m_buffer.size();
+        }
+    }
+
+    m_journalStale = true;
+    block.samples.clear();
+    block.count = 0;
+    block.timeEncoder.reset();
+    block.time.clear();
+    for (std::size_t c { 0 }; c < ARCHIVE_VALUE_NUM; ++c) {
+        block.valueEncoders[c].reset();
+        block.values[c].clear();
+    }
+}
+
+void ArchiveWriter::prune(int64_t today)
+{
+    // 文件名YYYYMMDD.tsa按字典序即按日期排序
+    std::vector<std::pair<std::string, uint64_t>> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_dir, ec)) {
+        const std::string name { entry.path().filename().string() };
+        std::error_code sizeEc;
+        const uint64_t size { entry.is_regular_file(sizeEc) ? entry.file_size(sizeEc) : 0 };
+        if (name.size() == 12 && name.ends_with(".tsa") && !sizeEc) {
+            files.emplace_back(name, size);
+        }
+    }
+    if (ec) {
+        spdlog::error("Unable to list archive directory {}: {}", m_dir, ec.message());
+        return;
+    }
+    std::sort(files.begin(), files.end());
+
+    uint64_t total { 0 };
+    for (const auto& file : files) {
+        total += file.second;
+    }
+    const std::string oldest { ARCHIVE_RETENTION_DAYS > 0 ? archive_file_name(today - ARCHIVE_RETENTION_DAYS + 1) : std::string {} };
+    const std::string current { archive_file_name(today) };
+    for (const auto& [name, size] : files) {
+        const bool expired { name < oldest };
+        const bool oversize { ARCHIVE_RETENTION_BYTES > 0 && total > ARCHIVE_RETENTION_BYTES };
+        if (name >= current || (!expired && !oversize)) {
+            break;
+        }
+        const std::string path { m_dir + "/" + name };
+        if (std::filesystem::remove(path, ec)) {
+            spdlog::info("Archive file {} removed ({} bytes, {})", path, size, expired ? "expired" : "over size limit");
+            total -= size;
+        } else if (ec) {
+            spdlog::error("Unable to remove archive file {}: {}", path, ec.message());
+            break;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef ARCHIVEWRITER_H
+#define ARCHIVEWRITER_H
+
+#include "Rotor.h"
+#include "archiveFormat.h"
+#include <array>
+#include <string>
+#include <vector>
+
+// 转子状态的压缩列式归档, 格式见archiveFormat.h, 用tools/archive_export导出.
+// 每个转子在内存中编码当前块, 满ARCHIVE_BLOCK_SAMPLES个样本或跨UTC日时一次追加到当天的文件.
+// 未写出的样本同时以原始格式追加到日志文件ARCHIVE_JOURNAL_NAME(每次sync()一次write), 块写出后日志只保留仍未写出的样本;
+// 进程崩溃后重启时从日志恢复这些样本, 继续填充原来的块. 日志不fsync, 掉电时可能丢失;
+// 崩溃恰好发生在块已写出而本周期的sync()之前时, 该块的样本会被恢复两次.
+// 启动和换日时按ARCHIVE_RETENTION_DAYS和ARCHIVE_RETENTION_BYTES从最早的日文件删起, 当天的文件不删.
+// 只在一个线程中写; 目录或文件无法创建时记录错误并丢弃该块
+constexpr const char* ARCHIVE_JOURNAL_NAME { "journal.tsj" };
+constexpr const uint32_t ARCHIVE_JOURNAL_MAGIC { 0x4A535354 }; // "TSSJ"
+constexpr const int64_t ARCHIVE_RETENTION_DAYS { 400 }; // 0表示不按日期删除
+constexpr const uint64_t ARCHIVE_RETENTION_BYTES { uint64_t { 20 } << 30 }; // 0表示不按大小删除
+
+// 日志记录, 后接转子名; 不完整的记录(写入中途崩溃)在恢复时忽略
+struct ArchiveJournalRecord {
+    uint32_t magic;
+    uint16_t nameLength;
+    uint16_t reserved;
+    ArchiveSample sample;
+};
+
+class ArchiveWriter {
+private:
+    struct Block {
+        std::size_t count { 0 };
+        int64_t firstMs { 0 };
+        int64_t lastMs { 0 };
+        int64_t day { 0 };
+        TimeEncoder timeEncoder;
+        BitWriter time;
+        std::array<ValueEncoder, ARCHIVE_VALUE_NUM> valueEncoders;
+        std::array<BitWriter, ARCHIVE_VALUE_NUM> values;
+        std::vector<ArchiveSample> samples; // 未写出的原始样本, 用于重写日志
+    };
+
+    const std::string m_dir;
+    const std::vector<std::string> m_names;
+    std::vector<Block> m_blocks;
+    std::vector<uint8_t> m_buffer; // 复用, 一个块的全部内容
+    int m_fd { -1 };
+    int64_t m_fileDay { -1 };
+    const std::string m_journalPath;
+    int m_journalFd { -1 };
+    std::vector<uint8_t> m_journal; // 上次sync()以来的日志记录
+    bool m_journalStale { false }; // 有块已写出, 下次sync()重写日志
+    std::size_t m_rawBytes { 0 }; // 已写出样本的未压缩字节数, 用于统计
+    std::size_t m_writtenBytes { 0 };
+
+    void append_sample(std::size_t rotor, const ArchiveSample& sample);
+    void write_block(std::size_t rotor);
+    void append_record(std::vector<uint8_t>& out, std::size_t rotor, const ArchiveSample& sample) const;
+    // 把日志中的样本放回各块, 名称已不在names中的转子丢弃
+    void recover_journal();
+    // 以各块未写出的样本替换日志(写临时文件后rename)
+    void rewrite_journal();
+    bool open_day(int64_t day);
+    // 删除超出保留期限或总大小的日文件, today及以后的文件保留
+    void prune(int64_t today);
+
+public:
+    ArchiveWriter(const std::string& dir, const std::string& unit, const std::vector<std::string>& names);
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+    // 写出所有未满的块
+    ~ArchiveWriter() noexcept;
+
+    void append(std::size_t rotor, int64_t timeMs, const RotorState& state);
+    // 把本周期append()的样本写入日志, 每个周期的append()之后调用一次
+    void sync();
+    // 写出所有未满的块并清空日志
+    void flush();
+    // 已写出部分的压缩比(未压缩的样本字节数/文件字节数)
+    double ratio() const { return m_writtenBytes ? static_cast<double>(m_rawBytes) / m_writtenBytes : 0; }
+};
+
+#endif // ARCHIVEWRITER_H
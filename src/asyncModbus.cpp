@@ -0,0 +1,205 @@
+#include "asyncModbus.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const int MAX_READ_REGISTERS { 125 };
+constexpr const std::size_t MBAP_LENGTH { 7 };
+
+} // namespace
+
+AsyncModbusClient::AsyncModbusClient(Reactor& reactor, const std::string& ip, int port, int slave_id)
+    : m_reactor { reactor }
+    , m_ip { ip }
+    , m_port { port }
+    , m_slave_id { slave_id }
+{
+}
+
+AsyncModbusClient::~AsyncModbusClient() noexcept
+{
+    close();
+}
+
+void AsyncModbusClient::close()
+{
+    if (m_fd != -1) {
+        m_reactor.forget(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+Coro<bool> AsyncModbusClient::connect()
+{
+    if (Reactor::Clock::now() < m_retryAt) {
+        co_return false;
+    }
+    m_retryAt = Reactor::Clock::now() + MODBUS_RECONNECT_INTERVAL;
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(m_port));
+    if (::inet_pton(AF_INET, m_ip.c_str(), &addr.sin_addr) != 1) {
+        spdlog::warn("Exception from modbus client connect {}: invalid address {}", m_slave_id, m_ip);
+        co_return false;
+    }
+
+    m_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd == -1) {
+        spdlog::warn("Exception from modbus client connect {}: {}", m_slave_id, std::strerror(errno));
+        co_return false;
+    }
+    const int one { 1 };
+    ::setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (::connect(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+        if (errno != EINPROGRESS) {
+            spdlog::warn("Exception from modbus client connect {}: {}", m_slave_id, std::strerror(errno));
+            close();
+            co_return false;
+        }
+        if (!co_await m_reactor.writable(m_fd, MODBUS_RESPONSE_TIMEOUT)) {
+            spdlog::warn("Exception from modbus client connect {}: timed out", m_slave_id);
+            close();
+            co_return false;
+        }
+        int error { 0 };
+        socklen_t len { sizeof(error) };
+        ::getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error != 0) {
+            spdlog::warn("Exception from modbus client connect {}: {}", m_slave_id, std::strerror(error));
+            close();
+            co_return false;
+        }
+    }
+    spdlog::info("Modbus client {} connected.", m_slave_id);
+    co_return true;
+}
+
+Coro<bool> AsyncModbusClient::write_all(const uint8_t* data, std::size_t len)
+{
+    while (len > 0) {
+        const ssize_t n = ::send(m_fd, data, len, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!co_await m_reactor.writable(m_fd, MODBUS_RESPONSE_TIMEOUT)) {
+                co_return false;
+            }
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else {
+            co_return false;
+        }
+    }
+    co_return true;
+}
+
+Coro<bool> AsyncModbusClient::read_exact(uint8_t* data, std::size_t len)
+{
+    while (len > 0) {
+        const ssize_t n = ::recv(m_fd, data, len, 0);
+        if (n > 0) {
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!co_await m_reactor.readable(m_fd, MODBUS_RESPONSE_TIMEOUT)) {
+                co_return false;
+            }
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else {
+            co_return false; // 对端关闭或出错
+        }
+    }
+    co_return true;
+}
+
+Coro<bool> AsyncModbusClient::read_block(int addr, int nb, uint16_t* dest)
+{
+    const uint16_t tid { ++m_transaction };
+    const uint8_t request[] {
+        static_cast<uint8_t>(tid >> 8), static_cast<uint8_t>(tid),
+        0, 0, // 协议标识
+        0, 6, // 后续长度
+        static_cast<uint8_t>(m_slave_id),
+        0x03,
+        static_cast<uint8_t>(addr >> 8), static_cast<uint8_t>(addr),
+        static_cast<uint8_t>(nb >> 8), static_cast<uint8_t>(nb)
+    };
+    if (!co_await write_all(request, sizeof(request))) {
+        co_return false;
+    }
+
+    uint8_t header[MBAP_LENGTH + 2]; // MBAP + 功能码 + 字节数/异常码
+    if (!co_await read_exact(header, sizeof(header))) {
+        co_return false;
+    }
+    const uint16_t rtid = static_cast<uint16_t>(header[0] << 8 | header[1]);
+    if (rtid != tid) {
+        spdlog::warn("Modbus client {} transaction mismatch: {} != {}", m_slave_id, rtid, tid);
+        co_return false;
+    }
+    if (header[7] & 0x80) {
+        spdlog::warn("Read Holding Registers failed: exception code {}", header[8]);
+        co_return false;
+    }
+    if (header[7] != 0x03 || header[8] != 2 * nb) {
+        spdlog::warn("Modbus client {} invalid response", m_slave_id);
+        co_return false;
+    }
+
+    uint8_t payload[2 * MAX_READ_REGISTERS];
+    if (!co_await read_exact(payload, header[8])) {
+        co_return false;
+    }
+    for (int i { 0 }; i < nb; ++i) {
+        dest[i] = static_cast<uint16_t>(payload[2 * i] << 8 | payload[2 * i + 1]);
+    }
+    co_return true;
+}
+
+Coro<std::vector<uint16_t>> AsyncModbusClient::read_registers(int start_registers, int nb_registers)
+{
+    if (nb_registers <= 0) {
+        co_return std::vector<uint16_t> {};
+    }
+    co_await m_mutex.lock();
+    std::vector<uint16_t> holding_registers;
+    try {
+        holding_registers = co_await read_locked(start_registers, nb_registers);
+    } catch (...) {
+        m_mutex.unlock();
+        throw;
+    }
+    m_mutex.unlock();
+    co_return holding_registers;
+}
+
+Coro<std::vector<uint16_t>> AsyncModbusClient::read_locked(int start_registers, int nb_registers)
+{
+    if (m_fd == -1 && !co_await connect()) {
+        co_return std::vector<uint16_t> {};
+    }
+
+    std::vector<uint16_t> holding_registers(nb_registers);
+    for (int offset { 0 }; offset < nb_registers; offset += MAX_READ_REGISTERS) {
+        const int nb { std::min(MAX_READ_REGISTERS, nb_registers - offset) };
+        if (!co_await read_block(start_registers + offset, nb, &holding_registers[offset])) {
+            spdlog::warn("Exception from read_registers: slave {} request failed", m_slave_id);
+            // 连接状态未知, 关闭后由下次请求重连
+            close();
+            co_return std::vector<uint16_t> {};
+        }
+    }
+    co_return holding_registers;
+}
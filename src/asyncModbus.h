@@ -0,0 +1,42 @@
+#ifndef ASYNCMODBUS_H
+#define ASYNCMODBUS_H
+
+#include "reactor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr const auto MODBUS_RESPONSE_TIMEOUT { std::chrono::milliseconds(200) };
+constexpr const auto MODBUS_RECONNECT_INTERVAL { std::chrono::seconds(5) };
+
+// 基于反应器的Modbus TCP客户端, 只实现读保持寄存器(功能码3), 与MyModbusClient行为一致:
+// 失败时返回空结果, 断线后间隔MODBUS_RECONNECT_INTERVAL重连, 不阻塞反应器线程
+class AsyncModbusClient {
+private:
+    Reactor& m_reactor;
+    const std::string m_ip;
+    int m_port;
+    int m_slave_id;
+    int m_fd { -1 };
+    uint16_t m_transaction { 0 };
+    Reactor::Clock::time_point m_retryAt {};
+    AsyncMutex m_mutex; // 一个连接上同时只有一个请求
+
+
+    Coro<bool> connect();
+    void close();
+    Coro<bool> write_all(const uint8_t* data, std::size_t len);
+    Coro<bool> read_exact(uint8_t* data, std::size_t len);
+    Coro<bool> read_block(int addr, int nb, uint16_t* dest);
+    Coro<std::vector<uint16_t>> read_locked(int start_registers, int nb_registers);
+
+public:
+    AsyncModbusClient(Reactor& reactor, const std::string& ip, int port, int slave_id);
+    AsyncModbusClient(const AsyncModbusClient&) = delete;
+    AsyncModbusClient& operator=(const AsyncModbusClient&) = delete;
+    ~AsyncModbusClient() noexcept;
+
+    Coro<std::vector<uint16_t>> read_registers(int start_registers, int nb_registers);
+};
+
+#endif // ASYNCMODBUS_H
@@ -0,0 +1,104 @@
+#include "controlPlane.h"
+#include "Rotor.h"
+
+#include <algorithm>
+
+ControlPlane::ControlPlane(const std::string& unit, const std::vector<std::string>& names,
+    std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli, bool fromMQTT, bool fromRedis)
+    : m_unit { unit }
+    , m_names { names }
+    , m_redis { redis }
+    , m_MQTTCli { MQTTCli }
+{
+    if (fromMQTT) {
+        m_MQTTCli->subscribe("TS" + m_unit + "/Command", QOS, [this](const std::string& payload) { receive(payload, CommandSource::mqtt); });
+    }
+    if (fromRedis) {
+        m_redisThread = std::thread([this]() {
+            m_redis->m_subscribe("TS" + m_unit + ":Mechanism:Command", [this](const std::string& payload) { receive(payload, CommandSource::redis); }, m_stop);
+        });
+    }
+}
+
+ControlPlane::~ControlPlane() noexcept
+{
+    if (m_redisThread.joinable()) {
+        m_stop = true;
+        // 没有socket_timeout的连接(unix socket)只能由一条消息唤醒, 空消息被receive忽略
+        m_redis->m_publish("TS" + m_unit + ":Mechanism:Command", "");
+        m_redisThread.join();
+    }
+}
+
+void ControlPlane::receive(const std::string& payload, CommandSource source)
+{
+    if (payload.empty()) {
+        return;
+    }
+
+    std::string id;
+    try {
+        const json j = json::parse(payload);
+        if (j.contains("id")) {
+            id = j["id"].is_string() ? j["id"].get<std::string>() : j["id"].dump();
+        }
+
+        const std::string rotor { j.at("rotor").get<std::string>() };
+        const auto it = std::find(m_names.begin(), m_names.end(), rotor);
+        if (it == m_names.end()) {
+            throw std::invalid_argument("unknown rotor " + rotor);
+        }
+        ControlCommand command { id, static_cast<std::size_t>(it - m_names.begin()), false, false, source };
+        for (const auto& target : j.at("reset")) {
+            const std::string name { target.get<std::string>() };
+            if (name == "life") {
+                command.life = true;
+            } else if (name == "overhaulLife") {
+                command.overhaulLife = true;
+            } else {
+                throw std::invalid_argument("unknown reset target " + name);
+            }
+        }
+        if (!command.life && !command.overhaulLife) {
+            throw std::invalid_argument("nothing to reset");
+        }
+
+        spdlog::info("Control command {} from {}: reset rotor {}", command.id, source == CommandSource::mqtt ? "MQTT" : "Redis", rotor);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(std::move(command));
+    } catch (const std::exception& e) {
+        spdlog::warn("Rejected control command {}: {}", id, e.what());
+        reply(source, { { "id", id }, { "status", "rejected" }, { "error", e.what() } });
+    }
+}
+
+std::vector<ControlCommand> ControlPlane::take()
+{
+    std::vector<ControlCommand> commands;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    commands.swap(m_pending);
+    return commands;
+}
+
+void ControlPlane::ack(const ControlCommand& command, const std::string& status, const std::string& error) const
+{
+    json j { { "id", command.id }, { "rotor", m_names[command.rotor] }, { "status", status } };
+    if (!error.empty()) {
+        j["error"] = error;
+    }
+    reply(command.source, j);
+}
+
+void ControlPlane::reply(CommandSource source, const json& ack) const
+{
+    if (source == CommandSource::mqtt) {
+        // 可能在paho回调线程中, 不能等待完成
+        m_MQTTCli->publish_async("TS" + m_unit + "/CommandAck", ack.dump(), QOS, [](bool ok) {
+            if (!ok) {
+                spdlog::warn("Failed to publish control command ack");
+            }
+        });
+    } else {
+        m_redis->m_publish("TS" + m_unit + ":Mechanism:CommandAck", ack.dump());
+    }
+}
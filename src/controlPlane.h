@@ -0,0 +1,63 @@
+#ifndef CONTROLPLANE_H
+#define CONTROLPLANE_H
+
+#include "myMQTT.h"
+#include "myRedis.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 控制面: 通过MQTT主题TS<unit>/Command或Redis频道TS<unit>:Mechanism:Command接收寿命复位命令,
+// 命令在下一个周期开始时执行, 结果从同一通道应答(TS<unit>/CommandAck或TS<unit>:Mechanism:CommandAck).
+//
+// 命令: { "id": "42", "rotor": "HP", "reset": ["life", "overhaulLife"] }
+// 应答: { "id": "42", "rotor": "HP", "status": "done" }
+//       { "id": "42", "status": "rejected", "error": "unknown rotor HP" }
+//       { "id": "42", "rotor": "HP", "status": "failed", "error": "Redis write failed" } (未复位, 可重发)
+// 与控制字位0/位1的含义相同; 控制字轮询仍然保留, 周期见rates.h的controlPeriod
+
+enum class CommandSource : uint8_t {
+    mqtt,
+    redis
+};
+
+struct ControlCommand {
+    std::string id;
+    std::size_t rotor;
+    bool life;
+    bool overhaulLife;
+    CommandSource source;
+};
+
+class ControlPlane {
+private:
+    const std::string m_unit;
+    const std::vector<std::string> m_names;
+    std::shared_ptr<MyRedis> m_redis;
+    std::shared_ptr<MyMQTT> m_MQTTCli;
+
+    std::mutex m_mutex;
+    std::vector<ControlCommand> m_pending;
+
+    std::atomic<bool> m_stop { false };
+    std::thread m_redisThread;
+
+    void receive(const std::string& payload, CommandSource source);
+    void reply(CommandSource source, const json& ack) const;
+
+public:
+    ControlPlane(const std::string& unit, const std::vector<std::string>& names,
+        std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli, bool fromMQTT, bool fromRedis);
+    ControlPlane(const ControlPlane&) = delete;
+    ControlPlane& operator=(const ControlPlane&) = delete;
+    ~ControlPlane() noexcept;
+
+    // 取出已收到的命令, 由循环线程在转子不运行时调用
+    std::vector<ControlCommand> take();
+    void ack(const ControlCommand& command, const std::string& status, const std::string& error = "") const;
+};
+
+#endif // CONTROLPLANE_H
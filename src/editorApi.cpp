@@ -0,0 +1,854 @@
+#include "editorApi.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <optional>
+#include <poll.h>
+#include <random>
+#include <set>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const std::size_t MAX_CONNECTIONS { 16 };
+constexpr const std::size_t MAX_HEADER_SIZE { 16 * 1024 };
+constexpr const std::size_t MAX_BODY_SIZE { 4 * 1024 * 1024 };
+constexpr const std::size_t MAX_FRAME_SIZE { 64 * 1024 }; // 客户端只发控制帧
+constexpr const std::size_t MAX_PENDING_OUTPUT { 4 * 1024 * 1024 }; // 超过时断开慢客户端
+
+constexpr const std::size_t MAX_TOKENS { 64 }; // 超过时丢弃最早到期的
+constexpr const auto TOKEN_TTL { std::chrono::hours(12) };
+
+constexpr const char* WEBSOCKET_GUID { "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" };
+
+const char* const INTEGER_FIELDS[] { "slaveID", "controlWord", "nodes" };
+const char* const POSITIVE_FIELDS[] { "density", "radius", "deltaR", "scanCycle" };
+const char* const NUMBER_FIELDS[] { "holeRadius", "surfaceFactor", "centerFactor", "freeFactor" };
+const char* const CURVE_FIELDS[] { "tcz", "shz", "emz", "prz", "lecz", "SN1", "SN2", "SN3" };
+// 转子记录中main.cpp和loadParasFromRedis没有缺省值的字段, 另有各曲线的_X/_Y和sn
+const char* const REQUIRED_FIELDS[] { "slaveID", "controlWord", "density", "radius", "holeRadius", "deltaR", "scanCycle",
+    "surfaceFactor", "centerFactor", "freeFactor" };
+
+// WebSocket握手只需要SHA-1
+std::array<uint8_t, 20> sha1(const std::string& message)
+{
+    uint32_t h[5] { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    std::string data { message };
+    const uint64_t bits { static_cast<uint64_t>(message.size()) * 8 };
+    data.push_back(static_cast<char>(0x80));
+    while (data.size() % 64 != 56) {
+        data.push_back(0);
+    }
+    for (int i { 7 }; i >= 0; --i) {
+        data.push_back(static_cast<char>(bits >> (i * 8)));
+    }
+
+    auto rotl = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+    for (std::size_t chunk { 0 }; chunk < data.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i { 0 }; i < 16; ++i) {
+            const auto* p = reinterpret_cast<const uint8_t*>(data.data() + chunk + i * 4);
+            w[i] = static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | p[3];
+        }
+        for (int i { 16 }; i < 80; ++i) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a { h[0] }, b { h[1] }, c { h[2] }, d { h[3] }, e { h[4] };
+        for (int i { 0 }; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            const uint32_t t { rotl(a, 5) + f + e + k + w[i] };
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    std::array<uint8_t, 20> digest;
+    for (int i { 0 }; i < 20; ++i) {
+        digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - (i % 4) * 8));
+    }
+    return digest;
+}
+
+// 与TSParas的HashProvider相同, users中保存的是密码的SHA-256十六进制串
+std::string sha256_hex(const std::string& message)
+{
+    static constexpr const uint32_t K[64] {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+    uint32_t h[8] { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    std::string data { message };
+    const uint64_t bits { static_cast<uint64_t>(message.size()) * 8 };
+    data.push_back(static_cast<char>(0x80));
+    while (data.size() % 64 != 56) {
+        data.push_back(0);
+    }
+    for (int i { 7 }; i >= 0; --i) {
+        data.push_back(static_cast<char>(bits >> (i * 8)));
+    }
+
+    auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+    for (std::size_t chunk { 0 }; chunk < data.size(); chunk += 64) {
+        uint32_t w[64];
+        for (int i { 0 }; i < 16; ++i) {
+            const auto* p = reinterpret_cast<const uint8_t*>(data.data() + chunk + i * 4);
+            w[i] = static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | p[3];
+        }
+        for (int i { 16 }; i < 64; ++i) {
+            const uint32_t s0 { rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3) };
+            const uint32_t s1 { rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10) };
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t v[8];
+        std::copy(std::begin(h), std::end(h), v);
+        for (int i { 0 }; i < 64; ++i) {
+            const uint32_t s1 { rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25) };
+            const uint32_t ch { (v[4] & v[5]) ^ (~v[4] & v[6]) };
+            const uint32_t t1 { v[7] + s1 + ch + K[i] + w[i] };
+            const uint32_t s0 { rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22) };
+            const uint32_t maj { (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]) };
+            std::copy_backward(v, v + 7, v + 8);
+            v[4] += t1;
+            v[0] = t1 + s0 + maj;
+        }
+        for (int i { 0 }; i < 8; ++i) {
+            h[i] += v[i];
+        }
+    }
+    return fmt::format("{:08x}{:08x}{:08x}{:08x}{:08x}{:08x}{:08x}{:08x}", h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+}
+
+// 比较时间与内容无关
+bool same_secret(const std::string& a, const std::string& b)
+{
+    unsigned char diff { static_cast<unsigned char>(a.size() != b.size()) };
+    for (std::size_t i { 0 }; i < std::min(a.size(), b.size()); ++i) {
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
+
+std::string random_token()
+{
+    std::random_device rd;
+    std::string token;
+    for (int i { 0 }; i < 4; ++i) {
+        token += fmt::format("{:08x}", rd());
+    }
+    return token;
+}
+
+std::string base64(const uint8_t* data, std::size_t size)
+{
+    static constexpr const char* TABLE { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/" };
+    std::string out;
+    for (std::size_t i { 0 }; i < size; i += 3) {
+        const uint32_t n { static_cast<uint32_t>(data[i]) << 16
+            | (i + 1 < size ? static_cast<uint32_t>(data[i + 1]) << 8 : 0)
+            | (i + 2 < size ? data[i + 2] : 0) };
+        out.push_back(TABLE[(n >> 18) & 0x3F]);
+        out.push_back(TABLE[(n >> 12) & 0x3F]);
+        out.push_back(i + 1 < size ? TABLE[(n >> 6) & 0x3F] : '=');
+        out.push_back(i + 2 < size ? TABLE[n & 0x3F] : '=');
+    }
+    return out;
+}
+
+std::string lower(std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+std::string http_response(int status, const std::string& body, const char* contentType = "application/json")
+{
+    const char* reason { status == 200 ? "OK" : status == 400 ? "Bad Request"
+            : status == 401                                   ? "Unauthorized"
+            : status == 403                                   ? "Forbidden"
+            : status == 404                                   ? "Not Found"
+            : status == 413                                   ? "Payload Too Large"
+            : status == 415                                   ? "Unsupported Media Type"
+            : status == 503                                   ? "Service Unavailable"
+                                                              : "Internal Server Error" };
+    return fmt::format("HTTP/1.1 {} {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+        status, reason, contentType, body.size(), body);
+}
+
+std::string websocket_frame(uint8_t opcode, const std::string& payload)
+{
+    std::string frame;
+    frame.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(126);
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size()));
+    } else {
+        frame.push_back(127);
+        for (int i { 7 }; i >= 0; --i) {
+            frame.push_back(static_cast<char>(static_cast<uint64_t>(payload.size()) >> (i * 8)));
+        }
+    }
+    frame.append(payload);
+    return frame;
+}
+
+std::optional<double> parse_number(const std::string& text)
+{
+    const char* begin { text.c_str() };
+    char* end { nullptr };
+    errno = 0;
+    const double value { std::strtod(begin, &end) };
+    while (end && std::isspace(static_cast<unsigned char>(*end))) {
+        ++end;
+    }
+    if (end == begin || *end != '\0' || errno != 0 || !std::isfinite(value)) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<std::vector<double>> parse_list(const std::string& text)
+{
+    std::vector<double> values;
+    std::size_t start { 0 };
+    while (start <= text.size()) {
+        const std::size_t comma { std::min(text.find(',', start), text.size()) };
+        const auto value = parse_number(text.substr(start, comma - start));
+        if (!value) {
+            return std::nullopt;
+        }
+        values.push_back(*value);
+        start = comma + 1;
+    }
+    return values;
+}
+
+bool contains(const char* const* first, const char* const* last, const std::string& key)
+{
+    return std::find_if(first, last, [&key](const char* name) { return key == name; }) != last;
+}
+
+void validate_parameters(const std::string& rotor, const json& record, std::vector<std::string>& errors);
+
+// 合并后的转子记录须完整, 否则下次从Redis加载参数时无法启动. 截面只覆盖部分字段, 不检查
+void require_parameters(const std::string& rotor, const json& record, std::vector<std::string>& errors)
+{
+    auto require = [&rotor, &record, &errors](const std::string& key) {
+        if (!record.contains(key)) {
+            errors.push_back(rotor + "." + key + ": missing");
+        }
+    };
+    for (const char* key : REQUIRED_FIELDS) {
+        require(key);
+    }
+    for (const char* curve : CURVE_FIELDS) {
+        require(std::string { curve } + "_X");
+        require(std::string { curve } + "_Y");
+    }
+    require("sn");
+}
+
+// sections为截面数组的JSON字符串, 见utils.h中的SectionParameters
+void validate_sections(const std::string& rotor, const std::string& text, std::vector<std::string>& errors)
+{
+    const json sections = json::parse(text, nullptr, false);
+    if (!sections.is_array()) {
+        errors.push_back(rotor + ".sections: must be a JSON array");
+        return;
+    }
+    std::set<std::string> names;
+    for (const auto& section : sections) {
+        if (!section.is_object() || !section.contains("name") || !section["name"].is_string() || section["name"].get<std::string>().empty()) {
+            errors.push_back(rotor + ".sections: every section must have a name");
+            continue;
+        }
+        const std::string name { section["name"].get<std::string>() };
+        if (!names.insert(name).second) {
+            errors.push_back(rotor + ".sections." + name + ": duplicate name");
+        }
+        json overrides = section;
+        overrides.erase("name");
+        if (overrides.contains("surfaceRegister")) {
+            const auto n = overrides["surfaceRegister"].is_string() ? parse_number(overrides["surfaceRegister"].get<std::string>()) : std::nullopt;
+            if (!n || *n < 0 || std::floor(*n) != *n || *n >= SECTION_REGISTER_NUM) {
+                errors.push_back(rotor + ".sections." + name + ".surfaceRegister: must be an integer less than " + std::to_string(SECTION_REGISTER_NUM));
+            }
+            overrides.erase("surfaceRegister");
+        }
+        validate_parameters(rotor + ".sections." + name, overrides, errors);
+    }
+}
+
+// 字段值与TSParas一致, 均为字符串; 校验规则与loadParasFromRedis/ThermalModel对参数的要求一致
+void validate_parameters(const std::string& rotor, const json& record, std::vector<std::string>& errors)
+{
+    auto error = [&rotor, &errors](const std::string& key, const std::string& message) {
+        errors.push_back(rotor + "." + key + ": " + message);
+    };
+
+    std::map<std::string, std::vector<double>> lists;
+    for (const auto& [key, value] : record.items()) {
+        if (!value.is_string()) {
+            error(key, "must be a string");
+            continue;
+        }
+        const std::string text { value.get<std::string>() };
+        if (key == "sections") {
+            validate_sections(rotor, text, errors);
+        } else if (key == "precision") {
+            if (text != "double" && text != "float") {
+                error(key, "must be double or float");
+            }
+        } else if (contains(std::begin(INTEGER_FIELDS), std::end(INTEGER_FIELDS), key)) {
+            const auto n = parse_number(text);
+            if (!n || *n < 0 || std::floor(*n) != *n) {
+                error(key, "must be a non-negative integer");
+            } else if (key == "nodes" && *n != 20 && *n != 40) {
+                error(key, "must be 20 or 40");
+            }
+        } else if (contains(std::begin(POSITIVE_FIELDS), std::end(POSITIVE_FIELDS), key)) {
+            const auto n = parse_number(text);
+            if (!n || *n <= 0) {
+                error(key, "must be a positive number");
+            }
+        } else if (contains(std::begin(NUMBER_FIELDS), std::end(NUMBER_FIELDS), key)) {
+            if (!parse_number(text)) {
+                error(key, "must be a number");
+            }
+        } else if (key == "sn" || (key.size() > 2 && (key.ends_with("_X") || key.ends_with("_Y"))
+                                      && contains(std::begin(CURVE_FIELDS), std::end(CURVE_FIELDS), key.substr(0, key.size() - 2)))) {
+            auto list = parse_list(text);
+            if (!list) {
+                error(key, "must be comma separated numbers");
+            } else {
+                lists[key] = std::move(*list);
+            }
+        } else {
+            error(key, "unknown parameter");
+        }
+    }
+
+    if (lists.contains("sn") && lists["sn"].size() != 2) {
+        error("sn", "must have 2 values");
+    }
+    for (const char* curve : CURVE_FIELDS) {
+        const std::string x { std::string { curve } + "_X" };
+        const std::string y { std::string { curve } + "_Y" };
+        if (!lists.contains(x) || !lists.contains(y)) {
+            continue;
+        }
+        if (lists[x].size() != lists[y].size()) {
+            error(curve, "X and Y have different lengths");
+        } else if (lists[x].size() > 32) {
+            error(curve, "at most 32 points are supported");
+        } else if (std::adjacent_find(lists[x].begin(), lists[x].end(), std::greater_equal<double>()) != lists[x].end()) {
+            error(x, "must be strictly increasing");
+        }
+    }
+}
+
+} // namespace
+
+struct EditorApi::Connection {
+    int fd;
+    std::string in;
+    std::string out;
+    bool websocket { false };
+    bool close { false }; // out发送完后关闭
+    uint64_t version { 0 }; // 已推送的状态版本
+};
+
+EditorApi::EditorApi(const std::string& unit, std::shared_ptr<MyRedis> redis, const std::string& ip, int port, const std::string& origin)
+    : m_unit { unit }
+    , m_redis { redis }
+    , m_origin { origin.empty() ? fmt::format("http://{}:{}", ip, port) : origin }
+{
+    if (ip != "0.0.0.0") {
+        m_hosts.emplace_back(fmt::format("{}:{}", ip, port));
+        if (ip == "127.0.0.1") {
+            m_hosts.emplace_back(fmt::format("localhost:{}", port));
+        }
+    }
+    m_listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    m_wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_listenFd == -1 || m_wakeFd == -1) {
+        spdlog::error("Editor API: {}", std::strerror(errno));
+        return;
+    }
+    const int on { 1 };
+    ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1
+        || ::bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1
+        || ::listen(m_listenFd, static_cast<int>(MAX_CONNECTIONS)) == -1) {
+        spdlog::error("Editor API: unable to listen on {}:{}: {}", ip, port, std::strerror(errno));
+        ::close(m_listenFd);
+        m_listenFd = -1;
+        return;
+    }
+
+    m_thread = std::thread([this]() { run(); });
+    spdlog::info("Editor API is listening on {}:{}, accepting origin {}", ip, port, m_origin);
+}
+
+EditorApi::~EditorApi() noexcept
+{
+    m_stop = true;
+    if (m_wakeFd != -1) {
+        const uint64_t one { 1 };
+        [[maybe_unused]] auto n = ::write(m_wakeFd, &one, sizeof(one));
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_listenFd != -1) {
+        ::close(m_listenFd);
+    }
+    if (m_wakeFd != -1) {
+        ::close(m_wakeFd);
+    }
+}
+
+void EditorApi::push_state(const std::string& state)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_state = state;
+        ++m_stateVersion;
+    }
+    const uint64_t one { 1 };
+    [[maybe_unused]] auto n = ::write(m_wakeFd, &one, sizeof(one));
+}
+
+void EditorApi::run()
+{
+    std::vector<Connection> connections;
+    std::vector<pollfd> fds;
+    std::string frame;
+    uint64_t frameVersion { 0 };
+
+    while (!m_stop) {
+        fds.clear();
+        fds.push_back({ m_listenFd, POLLIN, 0 });
+        fds.push_back({ m_wakeFd, POLLIN, 0 });
+        for (const auto& c : connections) {
+            fds.push_back({ c.fd, static_cast<short>(POLLIN | (c.out.empty() ? 0 : POLLOUT)), 0 });
+        }
+        if (::poll(fds.data(), fds.size(), -1) == -1) {
+            if (errno != EINTR) {
+                spdlog::error("Editor API poll: {}", std::strerror(errno));
+                return;
+            }
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t value;
+            [[maybe_unused]] auto n = ::read(m_wakeFd, &value, sizeof(value));
+        }
+
+        for (std::size_t i { 0 }; i < connections.size(); ++i) {
+            Connection& c = connections[i];
+            const short revents { fds[i + 2].revents };
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[4096];
+                ssize_t n;
+                while ((n = ::recv(c.fd, buffer, sizeof(buffer), 0)) > 0) {
+                    c.in.append(buffer, static_cast<std::size_t>(n));
+                }
+                if (n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    c.close = true;
+                    c.out.clear();
+                } else if (c.websocket) {
+                    if (!read_websocket(c)) {
+                        c.close = true;
+                        c.out.clear();
+                    }
+                } else if (!c.close) {
+                    handle_request(c);
+                }
+            }
+            if (!c.out.empty() && (revents & POLLOUT)) {
+                const ssize_t n { ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL) };
+                if (n > 0) {
+                    c.out.erase(0, static_cast<std::size_t>(n));
+                } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    c.close = true;
+                    c.out.clear();
+                }
+            }
+        }
+
+        // 每个客户端只差最新状态, 发送缓冲区未清空的客户端等到清空后再推送最新的一条
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            if (frameVersion != m_stateVersion) {
+                frame = websocket_frame(0x1, m_state);
+                frameVersion = m_stateVersion;
+            }
+        }
+        for (auto& c : connections) {
+            if (c.websocket && !c.close && frameVersion != 0 && c.version != frameVersion && c.out.empty()) {
+                c.out = frame;
+                c.version = frameVersion;
+            } else if (c.out.size() > MAX_PENDING_OUTPUT) {
+                c.close = true;
+                c.out.clear();
+            }
+        }
+
+        std::erase_if(connections, [](const Connection& c) {
+            if (c.close && c.out.empty()) {
+                ::close(c.fd);
+                return true;
+            }
+            return false;
+        });
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                if (connections.size() >= MAX_CONNECTIONS) {
+                    ::close(fd);
+                    continue;
+                }
+                connections.push_back({ fd, {}, {} });
+            }
+        }
+    }
+
+    for (const auto& c : connections) {
+        ::close(c.fd);
+    }
+}
+
+void EditorApi::handle_request(Connection& c)
+{
+    const std::size_t headerEnd { c.in.find("\r\n\r\n") };
+    if (headerEnd == std::string::npos) {
+        if (c.in.size() > MAX_HEADER_SIZE) {
+            c.out = http_response(413, "{\"error\":\"header too large\"}");
+            c.close = true;
+        }
+        return;
+    }
+
+    // 请求行和头部, 头部名称不区分大小写
+    std::string method, path;
+    std::map<std::string, std::string> headers;
+    std::size_t pos { 0 };
+    while (pos < headerEnd) {
+        const std::size_t eol { c.in.find("\r\n", pos) };
+        const std::string line { c.in.substr(pos, eol - pos) };
+        if (pos == 0) {
+            const std::size_t sp1 { line.find(' ') };
+            const std::size_t sp2 { line.find(' ', sp1 + 1) };
+            method = line.substr(0, sp1);
+            path = sp1 == std::string::npos ? "" : line.substr(sp1 + 1, sp2 - sp1 - 1);
+        } else if (const std::size_t colon { line.find(':') }; colon != std::string::npos) {
+            const std::size_t valueStart { line.find_first_not_of(' ', colon + 1) };
+            headers[lower(line.substr(0, colon))] = valueStart == std::string::npos ? "" : line.substr(valueStart);
+        }
+        pos = eol + 2;
+    }
+    path = path.substr(0, path.find('?'));
+
+    std::size_t bodySize { 0 };
+    if (headers.contains("content-length")) {
+        const auto n = parse_number(headers["content-length"]);
+        if (!n || *n < 0 || *n > MAX_BODY_SIZE) {
+            c.out = http_response(413, "{\"error\":\"body too large\"}");
+            c.close = true;
+            return;
+        }
+        bodySize = static_cast<std::size_t>(*n);
+    }
+    if (c.in.size() < headerEnd + 4 + bodySize) {
+        return;
+    }
+    const std::string body { c.in.substr(headerEnd + 4, bodySize) };
+    c.in.clear();
+
+    if (!trusted(headers)) {
+        spdlog::warn("Editor API: rejected {} {} from origin '{}', host '{}'", method, path, headers["origin"], headers["host"]);
+        c.out = http_response(403, "{\"error\":\"origin not allowed\"}");
+        c.close = true;
+        return;
+    }
+
+    if (method == "GET" && path == "/api/live" && lower(headers["upgrade"]) == "websocket" && headers.contains("sec-websocket-key")) {
+        const auto digest = sha1(headers["sec-websocket-key"] + WEBSOCKET_GUID);
+        c.out = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: "
+            + base64(digest.data(), digest.size()) + "\r\n\r\n";
+        c.websocket = true;
+        return;
+    }
+
+    c.close = true;
+    try {
+        int status { 200 };
+        if (method == "GET" && path == "/api/parameters") {
+            const std::string response { get_parameters(status) };
+            c.out = http_response(status, response);
+        } else if (method == "POST" && lower(headers["content-type"].substr(0, headers["content-type"].find(';'))) != "application/json") {
+            c.out = http_response(415, "{\"error\":\"Content-Type must be application/json\"}");
+        } else if (method == "POST" && path == "/api/login") {
+            const std::string response { login(body, status) };
+            c.out = http_response(status, response);
+        } else if (method == "POST" && path == "/api/parameters" && !authorized(headers)) {
+            c.out = http_response(401, "{\"error\":\"login required\"}");
+        } else if (method == "POST" && path == "/api/parameters") {
+            const std::string response { post_parameters(body, status) };
+            c.out = http_response(status, response);
+        } else if (method == "GET" && path == "/api/state") {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            c.out = http_response(200, m_state.empty() ? "{}" : m_state);
+        } else {
+            c.out = http_response(404, "{\"error\":\"not found\"}");
+        }
+    } catch (const std::exception& e) {
+        spdlog::warn("Editor API {} {}: {}", method, path, e.what());
+        c.out = http_response(500, json { { "error", e.what() } }.dump());
+    }
+}
+
+bool EditorApi::trusted(const std::map<std::string, std::string>& headers) const
+{
+    // 同源的GET可能不带Origin, 非浏览器客户端也不带
+    const auto origin = headers.find("origin");
+    if (origin != headers.end() && origin->second != m_origin) {
+        return false;
+    }
+    if (m_hosts.empty()) {
+        return true;
+    }
+    const auto host = headers.find("host");
+    return host != headers.end() && std::find(m_hosts.begin(), m_hosts.end(), lower(host->second)) != m_hosts.end();
+}
+
+bool EditorApi::read_websocket(Connection& c)
+{
+    while (c.in.size() >= 2) {
+        const auto* p = reinterpret_cast<const uint8_t*>(c.in.data());
+        const uint8_t opcode { static_cast<uint8_t>(p[0] & 0x0F) };
+        // 客户端帧必须带掩码
+        if (!(p[1] & 0x80)) {
+            return false;
+        }
+        uint64_t size { static_cast<uint64_t>(p[1] & 0x7F) };
+        std::size_t header { 2 };
+        if (size == 126) {
+            if (c.in.size() < 4) {
+                return true;
+            }
+            size = static_cast<uint64_t>(p[2]) << 8 | p[3];
+            header = 4;
+        } else if (size == 127) {
+            if (c.in.size() < 10) {
+                return true;
+            }
+            size = 0;
+            for (int i { 0 }; i < 8; ++i) {
+                size = size << 8 | p[2 + i];
+            }
+            header = 10;
+        }
+        if (size > MAX_FRAME_SIZE) {
+            return false;
+        }
+        if (c.in.size() < header + 4 + size) {
+            return true;
+        }
+
+        std::string payload { c.in.substr(header + 4, size) };
+        for (std::size_t i { 0 }; i < payload.size(); ++i) {
+            payload[i] = static_cast<char>(payload[i] ^ p[header + i % 4]);
+        }
+        c.in.erase(0, header + 4 + size);
+
+        if (opcode == 0x8) {
+            c.out.append(websocket_frame(0x8, payload.substr(0, 2)));
+            c.close = true;
+            return true;
+        } else if (opcode == 0x9) {
+            c.out.append(websocket_frame(0xA, payload));
+        }
+        // 其余数据帧忽略
+    }
+    return true;
+}
+
+bool EditorApi::authorized(const std::map<std::string, std::string>& headers)
+{
+    const auto header = headers.find("authorization");
+    if (header == headers.end() || !header->second.starts_with("Bearer ")) {
+        return false;
+    }
+    const auto token = m_tokens.find(header->second.substr(7));
+    if (token == m_tokens.end()) {
+        return false;
+    }
+    if (token->second < std::chrono::steady_clock::now()) {
+        m_tokens.erase(token);
+        return false;
+    }
+    return true;
+}
+
+std::string EditorApi::login(const std::string& body, int& status)
+{
+    const json request = json::parse(body, nullptr, false);
+    if (!request.is_object() || !request.contains("username") || !request["username"].is_string()
+        || !request.contains("password") || !request["password"].is_string()) {
+        status = 400;
+        return R"({"error":"username and password are required"})";
+    }
+    // users为{ 用户名: 密码的SHA-256 }, 散列只在服务端比较
+    const std::string text { m_redis->m_hget_string("TS" + m_unit + ":Mechanism:RotorLife", "users") };
+    const json users = json::parse(text, nullptr, false);
+    if (!users.is_object()) {
+        status = 503;
+        return R"({"error":"users are not available"})";
+    }
+    const std::string username { request["username"].get<std::string>() };
+    const auto user = users.find(username);
+    const std::string hash { sha256_hex(request["password"].get<std::string>()) };
+    if (user == users.end() || !user->is_string() || !same_secret(lower(user->get<std::string>()), hash)) {
+        spdlog::warn("Editor API: failed login of user '{}'", username);
+        status = 401;
+        return R"({"error":"incorrect username or password"})";
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    std::erase_if(m_tokens, [&now](const auto& token) { return token.second < now; });
+    if (m_tokens.size() >= MAX_TOKENS) {
+        m_tokens.erase(std::min_element(m_tokens.begin(), m_tokens.end(), [](const auto& a, const auto& b) { return a.second < b.second; }));
+    }
+    const std::string token { random_token() };
+    m_tokens.emplace(token, now + TOKEN_TTL);
+    spdlog::info("Editor API: user '{}' logged in", username);
+    return json { { "token", token } }.dump();
+}
+
+std::string EditorApi::get_parameters(int& status)
+{
+    const auto stored = m_redis->m_hgetall("TS" + m_unit + ":Mechanism:RotorParams");
+    if (!stored) {
+        status = 503;
+        return R"({"error":"Redis is not available"})";
+    }
+    const json rotors = stored->is_object() ? *stored : json::object();
+    const json res = {
+        { "nums", static_cast<long long>(m_redis->m_hget("TS" + m_unit + ":Mechanism:RotorLife", "nums")) },
+        { "rotors", rotors }
+    };
+    return res.dump();
+}
+
+std::string EditorApi::post_parameters(const std::string& body, int& status)
+{
+    json update;
+    try {
+        update = json::parse(body);
+    } catch (const std::exception& e) {
+        status = 400;
+        return json { { "errors", { e.what() } } }.dump();
+    }
+    if (!update.is_object()) {
+        status = 400;
+        return R"({"errors":["body must be an object"]})";
+    }
+
+    const std::string paramsKey { "TS" + m_unit + ":Mechanism:RotorParams" };
+    const auto stored = m_redis->m_hgetall(paramsKey);
+    if (!stored) {
+        status = 503;
+        return R"({"errors":["Redis is not available, nothing was written"]})";
+    }
+    const json current = stored->is_object() ? *stored : json::object();
+    std::vector<std::string> errors;
+    MyRedis::StreamFields records;
+
+    const json rotors = update.value("rotors", json::object());
+    for (const auto& [name, fields] : rotors.items()) {
+        if (!fields.is_object()) {
+            errors.push_back(name + ": must be an object");
+            continue;
+        }
+        // 与已有参数合并后整体校验, 只提交部分字段也不会丢失其他字段
+        json merged = current.contains(name) && current[name].is_object() ? current[name] : json::object();
+        for (const auto& [key, value] : fields.items()) {
+            merged[key] = value.is_string() ? value : json(value.dump());
+        }
+        validate_parameters(name, merged, errors);
+        require_parameters(name, merged, errors);
+        records.emplace_back(name, merged.dump());
+    }
+
+    long long nums { 0 };
+    if (update.contains("nums")) {
+        const json& n = update["nums"];
+        const auto value = n.is_number() ? std::optional<double> { n.get<double>() } : (n.is_string() ? parse_number(n.get<std::string>()) : std::nullopt);
+        if (!value || *value < 1 || std::floor(*value) != *value) {
+            errors.push_back("nums: must be a positive integer");
+        } else {
+            nums = static_cast<long long>(*value);
+        }
+    }
+
+    if (!errors.empty()) {
+        status = 400;
+        return json { { "errors", errors } }.dump();
+    }
+    if (!records.empty() && !m_redis->m_hmset(paramsKey, records)) {
+        status = 503;
+        return R"({"errors":["Redis write failed, nothing was written"]})";
+    }
+    if (nums > 0 && !m_redis->m_hset("TS" + m_unit + ":Mechanism:RotorLife", "nums", std::to_string(nums))) {
+        status = 503;
+        return json { { "errors", { "Redis write of nums failed" } }, { "updated", records.size() } }.dump();
+    }
+    spdlog::info("Editor API updated parameters of {} rotors", records.size());
+    return json { { "updated", records.size() } }.dump();
+}
@@ -0,0 +1,68 @@
+#ifndef EDITORAPI_H
+#define EDITORAPI_H
+
+#include "myRedis.h"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 本机参数编辑器(TSParas)接口, 代替经webdis逐页读写Redis. 独立线程上的最小HTTP/1.1+WebSocket服务:
+//
+// GET  /api/parameters  所有转子参数, 一次HGETALL: { "nums": 2, "rotors": { "1": { "density": "7850", ... }, ... } }
+// POST /api/parameters  批量更新, 格式同上, 各字段可省略. 与已有参数合并并校验(合并后须包含全部必需字段), 全部通过后一次写入,
+//                       否则返回400和错误列表, 不写入任何转子; Redis读写失败时返回503. 服务重启后生效.
+//                       须带Authorization: Bearer <token>, 否则返回401
+// POST /api/login       { "username": ..., "password": ... }, 与Redis中users的SHA-256散列比较, 成功时返回{ "token": ... },
+//                       令牌只在内存中, TOKEN_TTL后或服务重启后失效. 密码散列不经接口读出
+// GET  /api/state       最近一个周期所有转子的状态, 格式同TS<unit>/Rotors
+// GET  /api/live        WebSocket, 每个周期推送一条/api/state的内容
+//
+// 只应监听本机或受信网络, 除修改参数外不做认证. 为防止浏览器中的其它网页借用户的浏览器访问(CSRF, DNS重绑定):
+// 带Origin的请求(包括WebSocket握手)只接受配置的编辑器来源, Host须为监听地址(监听0.0.0.0时不核对),
+// POST须为Content-Type: application/json, 不能由表单直接提交
+class EditorApi {
+private:
+    struct Connection;
+
+    const std::string m_unit;
+    std::shared_ptr<MyRedis> m_redis;
+    const std::string m_origin;
+    std::vector<std::string> m_hosts; // 接受的Host, 为空时不核对
+    int m_listenFd { -1 };
+    int m_wakeFd { -1 };
+    std::atomic<bool> m_stop { false };
+
+    std::mutex m_stateMutex;
+    std::string m_state;
+    uint64_t m_stateVersion { 0 };
+
+    std::map<std::string, std::chrono::steady_clock::time_point> m_tokens; // 令牌 -> 到期时间, 只在服务线程中访问
+
+    std::thread m_thread;
+
+    void run();
+    void handle_request(Connection& c);
+    bool read_websocket(Connection& c);
+    bool trusted(const std::map<std::string, std::string>& headers) const;
+    bool authorized(const std::map<std::string, std::string>& headers);
+    std::string login(const std::string& body, int& status);
+    std::string get_parameters(int& status);
+    std::string post_parameters(const std::string& body, int& status);
+
+public:
+    // origin为编辑器页面的来源(如http://192.168.1.10:8080), 为空时只接受http://<ip>:<port>
+    EditorApi(const std::string& unit, std::shared_ptr<MyRedis> redis, const std::string& ip, int port, const std::string& origin = "");
+    EditorApi(const EditorApi&) = delete;
+    EditorApi& operator=(const EditorApi&) = delete;
+    ~EditorApi() noexcept;
+
+    // 更新/api/state并推送给WebSocket客户端, 只复制一次字符串, 发送在服务线程中进行
+    void push_state(const std::string& state);
+};
+
+#endif // EDITORAPI_H
@@ -0,0 +1,290 @@
+#include "lifeUncertainty.h"
+#include "realtime.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+
+double stress_min(const TempZone& zone)
+{
+    return zone.X.empty() ? 0 : std::fabs(zone.X[0]);
+}
+
+} // namespace
+
+StressHistory::StressHistory(const Parameters& para)
+    : m_floor { STRESS_HISTORY_FLOOR * std::min({ stress_min(para.SN1), stress_min(para.SN2), stress_min(para.SN3) }) }
+{
+}
+
+void StressHistory::record(double time, double stress, double aveTemp)
+{
+    if (!m_started) {
+        m_start = time;
+        m_started = true;
+    }
+    const bool above { stress >= m_floor };
+    if (!above && !m_inCycle) {
+        return;
+    }
+    m_inCycle = above;
+
+    const StressSample sample { time, static_cast<float>(stress), static_cast<float>(aveTemp) };
+    if (m_samples.size() < STRESS_HISTORY_MAX) {
+        m_samples.push_back(sample);
+        return;
+    }
+    m_samples[m_head] = sample;
+    m_head = (m_head + 1) % STRESS_HISTORY_MAX;
+    m_start = m_samples[m_head].time;
+}
+
+std::vector<StressSample> StressHistory::samples() const
+{
+    std::vector<StressSample> res;
+    res.reserve(m_samples.size());
+    res.insert(res.end(), m_samples.begin() + m_head, m_samples.end());
+    res.insert(res.end(), m_samples.begin(), m_samples.begin() + m_head);
+    return res;
+}
+
+LifeUncertainty::SnSet LifeUncertainty::load_sn(const Parameters& para)
+{
+    SnSet set;
+    const TempZone* zones[3] { &para.SN1, &para.SN2, &para.SN3 };
+    for (std::size_t k { 0 }; k < 3; ++k) {
+        SnCurve& c = set.curves[k];
+        const std::size_t n { std::min(zones[k]->X.size(), zones[k]->Y.size()) };
+        c.X.assign(zones[k]->X.begin(), zones[k]->X.begin() + n);
+        c.Y.assign(zones[k]->Y.begin(), zones[k]->Y.begin() + n);
+        c.slope.assign(n, 0);
+        for (std::size_t i { 1 }; i < n; ++i) {
+            c.slope[i] = (c.Y[i] - c.Y[i - 1]) / (c.X[i] - c.X[i - 1]);
+        }
+        c.stressMin = stress_min(*zones[k]);
+    }
+    set.sn = para.sn;
+    return set;
+}
+
+LifeUncertainty::LifeUncertainty(std::size_t rotors, std::size_t samples, std::size_t threads, double duty)
+    : m_rotors { rotors }
+    , m_samples { std::max(UNCERTAINTY_LANES, samples / UNCERTAINTY_LANES * UNCERTAINTY_LANES) }
+    , m_duty { std::clamp(duty, 0.01, 1.0) }
+    , m_bands(rotors)
+{
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency() / 2);
+    }
+    for (std::size_t t { 0 }; t < threads; ++t) {
+        m_threads.emplace_back([this]() { worker(); });
+    }
+    spdlog::info("Life uncertainty: {} samples per rotor, {} background threads", m_samples, threads);
+}
+
+LifeUncertainty::~LifeUncertainty() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_threads) {
+        t.join();
+    }
+}
+
+bool LifeUncertainty::busy()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_job != nullptr;
+}
+
+bool LifeUncertainty::submit(std::vector<UncertaintyInput>&& inputs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_job) {
+        spdlog::debug("Life uncertainty still running, skipping this period");
+        return false;
+    }
+    std::erase_if(inputs, [this](const UncertaintyInput& input) { return input.rotor >= m_rotors || input.para == nullptr; });
+    if (inputs.empty()) {
+        return false;
+    }
+    m_job = std::make_unique<Job>();
+    m_job->consumption.assign(inputs.size(), std::vector<double>(m_samples));
+    m_job->batches = inputs.size() * (m_samples / UNCERTAINTY_LANES);
+    for (const auto& input : inputs) {
+        m_job->sn.emplace_back(load_sn(*input.para));
+    }
+    m_job->inputs = std::move(inputs);
+    m_cv.notify_all();
+    return true;
+}
+
+bool LifeUncertainty::take(std::vector<UncertaintyBand>& bands)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_updated) {
+        return false;
+    }
+    bands = m_bands;
+    m_updated = false;
+    return true;
+}
+
+void LifeUncertainty::worker()
+{
+    set_thread_background();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this]() { return m_stop || (m_job && m_job->next < m_job->batches); });
+        if (m_stop) {
+            return;
+        }
+        Job& job = *m_job;
+        const std::size_t batch { job.next++ };
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        run_batch(job, batch);
+        const auto busy = std::chrono::steady_clock::now() - start;
+
+        lock.lock();
+        if (++job.finished == job.batches) {
+            // 最后完成的线程汇总, 汇总期间job不再被其它线程访问
+            lock.unlock();
+            std::vector<std::pair<std::size_t, UncertaintyBand>> bands;
+            for (std::size_t k { 0 }; k < job.inputs.size(); ++k) {
+                bands.emplace_back(job.inputs[k].rotor, summarize(job.inputs[k], job.sn[k], job.consumption[k]));
+            }
+            lock.lock();
+            for (auto& [rotor, band] : bands) {
+                m_bands[rotor] = band;
+            }
+            m_updated = true;
+            m_job.reset();
+        }
+
+        // 限制占空比: 计算busy后休眠busy * (1 - duty) / duty
+        const auto pause = std::chrono::duration_cast<std::chrono::steady_clock::duration>(busy * ((1 - m_duty) / m_duty));
+        m_cv.wait_for(lock, pause, [this]() { return m_stop; });
+    }
+}
+
+void LifeUncertainty::run_batch(Job& job, std::size_t batch) const
+{
+    const std::size_t perInput { m_samples / UNCERTAINTY_LANES };
+    const std::size_t k { batch / perInput };
+    const std::size_t first { batch % perInput * UNCERTAINTY_LANES };
+    const UncertaintyInput& input = job.inputs[k];
+
+    // 每批一个独立的随机数流, 结果与线程数和执行顺序无关
+    std::seed_seq seq { UNCERTAINTY_SEED, static_cast<uint32_t>(input.rotor), static_cast<uint32_t>(first) };
+    std::mt19937_64 rng(seq);
+    std::normal_distribution<double> normal;
+
+    std::array<double, UNCERTAINTY_LANES> scale;
+    std::array<double, UNCERTAINTY_LANES> factor;
+    for (std::size_t l { 0 }; l < UNCERTAINTY_LANES; ++l) {
+        const double em { std::max(0.0, 1 + UNCERTAINTY_EM_CV * normal(rng)) };
+        const double lec { std::max(0.0, 1 + UNCERTAINTY_LEC_CV * normal(rng)) };
+        scale[l] = em * lec;
+        factor[l] = std::pow(10.0, -UNCERTAINTY_SN_LOG_SIGMA * normal(rng));
+    }
+
+    std::array<double, UNCERTAINTY_LANES> consumption;
+    replay(job.sn[k], input.history, scale, factor, consumption);
+    std::copy(consumption.begin(), consumption.end(), job.consumption[k].begin() + first);
+}
+
+void LifeUncertainty::replay(const SnSet& sn, const std::vector<StressSample>& history,
+    const std::array<double, UNCERTAINTY_LANES>& scale, const std::array<double, UNCERTAINTY_LANES>& factor,
+    std::array<double, UNCERTAINTY_LANES>& consumption)
+{
+    constexpr std::size_t L { UNCERTAINTY_LANES };
+    std::array<double, L> stressMax {};
+    std::array<double, L> closed {};
+    std::array<double, L> y {};
+    consumption.fill(0);
+
+    // 与ThermalKernel::life相同的计数, 各组参数按列排放, 循环内无分支, 可向量化
+    for (const StressSample& sample : history) {
+        const double aveTemp { sample.aveTemp };
+        const SnCurve& c = aveTemp < sn.sn[0] ? sn.curves[0] : (aveTemp > sn.sn[1] ? sn.curves[2] : sn.curves[1]);
+        const double stressMin { c.stressMin };
+
+        double anyClosed { 0 };
+#pragma GCC unroll 8
+        for (std::size_t l { 0 }; l < L; ++l) {
+            const double s { scale[l] * sample.stress };
+            const bool above { s >= stressMin };
+            closed[l] = !above && stressMax[l] > stressMin ? 1.0 : 0.0;
+            stressMax[l] = above ? std::max(stressMax[l], s) : stressMax[l];
+            anyClosed += closed[l];
+        }
+        if (anyClosed == 0 || c.X.empty()) {
+            continue;
+        }
+
+        // 分段线性插值: y = Y0 + sum(slope_i * (clamp(x, X_{i-1}, X_i) - X_{i-1})), 两端外取端点值
+        y.fill(c.Y[0]);
+        for (std::size_t i { 1 }; i < c.X.size(); ++i) {
+            const double x0 { c.X[i - 1] };
+            const double x1 { c.X[i] };
+            const double slope { c.slope[i] };
+#pragma GCC unroll 8
+            for (std::size_t l { 0 }; l < L; ++l) {
+                y[l] += slope * (std::min(std::max(stressMax[l], x0), x1) - x0);
+            }
+        }
+#pragma GCC unroll 8
+        for (std::size_t l { 0 }; l < L; ++l) {
+            const double rate { y[l] > 0 ? factor[l] / y[l] : 0 };
+            consumption[l] += closed[l] * rate;
+            stressMax[l] = closed[l] != 0 ? 0 : stressMax[l];
+        }
+    }
+}
+
+UncertaintyBand LifeUncertainty::summarize(const UncertaintyInput& input, const SnSet& sn, std::vector<double>& consumption) const
+{
+    UncertaintyBand band;
+    if (!(input.window > 0)) {
+        return band;
+    }
+
+    std::array<double, UNCERTAINTY_LANES> ones;
+    ones.fill(1);
+    std::array<double, UNCERTAINTY_LANES> nominal;
+    replay(sn, input.history, ones, ones, nominal);
+    band.valid = true;
+    band.window = input.window;
+    band.nominalConsumption = nominal[0];
+
+    // 历程内没有完成的应力循环时无法按比例估计累计寿命, 只给出名义值
+    const double inf { std::numeric_limits<double>::infinity() };
+    if (nominal[0] <= 0) {
+        band.lifeRatio.fill(input.lifeRatio);
+        band.remainingHours.fill(inf);
+        return band;
+    }
+
+    std::sort(consumption.begin(), consumption.end());
+    constexpr const double P[3] { 0.1, 0.5, 0.9 };
+    for (std::size_t p { 0 }; p < 3; ++p) {
+        const double c { consumption[static_cast<std::size_t>(std::lround(P[p] * (consumption.size() - 1)))] };
+        band.lifeRatio[p] = input.lifeRatio * c / nominal[0];
+    }
+    // 消耗越多剩余越少, 剩余寿命的P10由消耗的P90得到
+    for (std::size_t p { 0 }; p < 3; ++p) {
+        const double lifeRatio { band.lifeRatio[2 - p] };
+        const double c { consumption[static_cast<std::size_t>(std::lround(P[2 - p] * (consumption.size() - 1)))] };
+        band.remainingHours[p] = c > 0 ? std::max(0.0, 1 - lifeRatio) * input.window / c / 3600 : inf;
+    }
+    return band;
+}
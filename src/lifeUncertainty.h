@@ -0,0 +1,143 @@
+#ifndef LIFEUNCERTAINTY_H
+#define LIFEUNCERTAINTY_H
+
+#include "utils.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 寿命不确定性: SN曲线和物性参数只是点估计, lifeRatio没有置信区间. 后台线程把转子记录的应力历程
+// 在大量扰动后的参数样本上重放寿命计数(ThermalKernel::life), 得到寿命消耗率和剩余寿命的P10/P50/P90.
+//
+// 扰动模型, 每个样本独立抽取:
+// - SN曲线的循环次数乘以10^(UNCERTAINTY_SN_LOG_SIGMA * z), 即疲劳寿命的对数正态分散
+// - 热应力乘以(1 + UNCERTAINTY_EM_CV * z1) * (1 + UNCERTAINTY_LEC_CV * z2), 弹性模量与线膨胀系数的分散.
+//   泊松比的影响小于二者, 导热系数/比热影响温度场本身, 需要重算温度场, 均不扰动
+// 历程内名义参数的寿命消耗为c0, 样本为c时, 该样本的累计寿命按lifeRatio * c / c0估计(假设历程代表以往的运行),
+// 剩余寿命按历程内的消耗速率外推为小时数.
+//
+// 计算在独立的低优先级(SCHED_IDLE)线程上进行, 每批样本后按UNCERTAINTY_DUTY休眠, 不影响主循环
+
+constexpr const std::size_t STRESS_HISTORY_MAX { 65536 }; // 每个转子保留的应力样本数
+constexpr const double STRESS_HISTORY_FLOOR { 0.5 }; // 记录阈值, SN曲线最小应力的倍数
+constexpr const std::size_t UNCERTAINTY_SAMPLES { 4096 }; // 每个转子的参数样本数
+constexpr const std::size_t UNCERTAINTY_LANES { 8 }; // 一次重放并行计算的样本数
+constexpr const double UNCERTAINTY_SN_LOG_SIGMA { 0.15 }; // SN曲线循环次数的常用对数的标准差
+constexpr const double UNCERTAINTY_EM_CV { 0.03 }; // 弹性模量的变异系数
+constexpr const double UNCERTAINTY_LEC_CV { 0.05 }; // 线膨胀系数的变异系数
+constexpr const double UNCERTAINTY_DUTY { 0.25 }; // 每个后台线程占用CPU时间的上限比例
+constexpr const uint32_t UNCERTAINTY_SEED { 20240601 }; // 固定种子, 历程不变时结果不变
+
+inline double steady_seconds(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration<double>(t.time_since_epoch()).count();
+}
+
+struct StressSample {
+    double time; // steady_clock, 秒
+    float stress;
+    float aveTemp;
+};
+
+// 转子的应力历程, 只记录可能构成应力循环的样本: 应力不低于阈值的样本, 及其后第一个低于阈值的样本(循环闭合).
+// 应力放大倍数小于1 / STRESS_HISTORY_FLOOR时, 重放结果与逐步计算相同. 环形缓冲, 满时覆盖最早的样本
+class StressHistory {
+private:
+    std::vector<StressSample> m_samples;
+    std::size_t m_head { 0 }; // 下一个写入位置
+    double m_floor;
+    double m_start { 0 }; // 记录开始或最早保留样本的时间
+    bool m_started { false };
+    bool m_inCycle { false };
+
+public:
+    explicit StressHistory(const Parameters& para);
+
+    // 每个计算子步调用一次
+    void record(double time, double stress, double aveTemp);
+    // 按时间顺序复制
+    std::vector<StressSample> samples() const;
+    double start() const { return m_start; }
+};
+
+struct UncertaintyInput {
+    std::size_t rotor;
+    const Parameters* para; // SN曲线
+    std::vector<StressSample> history;
+    double lifeRatio;
+    double window; // 历程时长, 秒
+};
+
+// 百分位为各量自身分布的P10/P50/P90, 剩余寿命的P10对应寿命消耗的P90
+struct UncertaintyBand {
+    bool valid { false };
+    double window { 0 }; // 秒
+    double nominalConsumption { 0 }; // 名义参数下历程内的寿命消耗
+    std::array<double, 3> lifeRatio {};
+    std::array<double, 3> remainingHours {}; // 历程内没有消耗时为无穷大, JSON中为null
+};
+
+class LifeUncertainty {
+private:
+    struct SnCurve {
+        std::vector<double> X;
+        std::vector<double> Y;
+        std::vector<double> slope; // slope[i]为第i-1到第i点的斜率
+        double stressMin { 0 }; // 最小寿命消耗率对应的应力
+    };
+    struct SnSet {
+        std::array<SnCurve, 3> curves;
+        std::array<double, 2> sn;
+    };
+    struct Job {
+        std::vector<UncertaintyInput> inputs;
+        std::vector<SnSet> sn;
+        std::vector<std::vector<double>> consumption; // [输入][样本]
+        std::size_t batches { 0 };
+        std::size_t next { 0 };
+        std::size_t finished { 0 };
+    };
+
+    const std::size_t m_rotors;
+    const std::size_t m_samples;
+    const double m_duty;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop { false };
+    std::unique_ptr<Job> m_job;
+    std::vector<UncertaintyBand> m_bands;
+    bool m_updated { false };
+    std::vector<std::thread> m_threads;
+
+    static SnSet load_sn(const Parameters& para);
+    void worker();
+    void run_batch(Job& job, std::size_t batch) const;
+    UncertaintyBand summarize(const UncertaintyInput& input, const SnSet& sn, std::vector<double>& consumption) const;
+    // 按lanes组参数(应力倍数, 消耗倍数)重放历程, consumption[l]为各组的寿命消耗
+    static void replay(const SnSet& sn, const std::vector<StressSample>& history,
+        const std::array<double, UNCERTAINTY_LANES>& scale, const std::array<double, UNCERTAINTY_LANES>& factor,
+        std::array<double, UNCERTAINTY_LANES>& consumption);
+
+public:
+    // threads为0时取硬件线程数的一半
+    explicit LifeUncertainty(std::size_t rotors, std::size_t samples = UNCERTAINTY_SAMPLES,
+        std::size_t threads = 0, double duty = UNCERTAINTY_DUTY);
+    LifeUncertainty(const LifeUncertainty&) = delete;
+    LifeUncertainty& operator=(const LifeUncertainty&) = delete;
+    ~LifeUncertainty() noexcept;
+
+    // 上一次评估还未完成
+    bool busy();
+    // 开始一次评估, 忙时丢弃并返回false
+    bool submit(std::vector<UncertaintyInput>&& inputs);
+    // 上次调用以来有新完成的评估时复制到bands(按转子序号)并返回true
+    bool take(std::vector<UncertaintyBand>& bands);
+};
+
+#endif // LIFEUNCERTAINTY_H
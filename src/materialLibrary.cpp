@@ -0,0 +1,70 @@
+#include "materialLibrary.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+// FNV-1a, 按位比较, 0.0与-0.0视为不同的曲线
+uint64_t hash_curve(const std::vector<double>& X, const std::vector<double>& Y)
+{
+    uint64_t h { 14695981039346656037ULL };
+    auto mix = [&h](uint64_t v) {
+        for (int i { 0 }; i < 8; ++i) {
+            h ^= (v >> (i * 8)) & 0xff;
+            h *= 1099511628211ULL;
+        }
+    };
+    mix(X.size());
+    for (const double x : X) {
+        mix(std::bit_cast<uint64_t>(x));
+    }
+    mix(Y.size());
+    for (const double y : Y) {
+        mix(std::bit_cast<uint64_t>(y));
+    }
+    return h;
+}
+
+bool same_values(std::span<const double> a, const std::vector<double>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](double x, double y) {
+        return std::bit_cast<uint64_t>(x) == std::bit_cast<uint64_t>(y);
+    });
+}
+
+} // namespace
+
+double* MaterialLibrary::allocate(std::size_t n)
+{
+    if (m_blocks.empty() || m_blockUsed + n > m_blockSize) {
+        m_blockSize = std::max(BLOCK_SIZE, n);
+        m_blocks.emplace_back(std::make_unique<double[]>(m_blockSize));
+        m_blockUsed = 0;
+    }
+    double* p { m_blocks.back().get() + m_blockUsed };
+    m_blockUsed += n;
+    m_stored += n;
+    return p;
+}
+
+TempZone MaterialLibrary::intern(const std::vector<double>& X, const std::vector<double>& Y)
+{
+    m_requested += X.size() + Y.size();
+
+    const uint64_t h { hash_curve(X, Y) };
+    const auto [first, last] = m_index.equal_range(h);
+    for (auto it { first }; it != last; ++it) {
+        if (same_values(it->second.X, X) && same_values(it->second.Y, Y)) {
+            return it->second;
+        }
+    }
+
+    // X和Y相邻存放, 插值时在同一段内存中访问
+    double* p { allocate(X.size() + Y.size()) };
+    std::copy(X.begin(), X.end(), p);
+    std::copy(Y.begin(), Y.end(), p + X.size());
+    const TempZone zone { { p, X.size() }, { p + X.size(), Y.size() } };
+    m_index.emplace(h, zone);
+    return zone;
+}
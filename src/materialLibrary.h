@@ -0,0 +1,47 @@
+#ifndef MATERIALLIBRARY_H
+#define MATERIALLIBRARY_H
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// 材料曲线, 指向MaterialLibrary中的只读数据
+struct TempZone {
+    std::span<const double> X;
+    std::span<const double> Y;
+};
+
+// 去重的材料曲线库. 同一机组的转子多用同一种钢, 各转子的物性曲线和SN曲线大多相同:
+// 加载参数时按内容散列, 相同的曲线只存一份, 依次放在连续的块中, Parameters只保存指向它的TempZone.
+// 块一经分配不再移动, 已返回的TempZone在库的生存期内一直有效, 库须比所有Parameters活得久.
+// 只在启动加载参数时写入, 之后只读, 不加锁
+class MaterialLibrary {
+private:
+    static constexpr std::size_t BLOCK_SIZE { 4096 }; // 每块的double个数, 一台机组的曲线通常一块即可放下
+
+    std::vector<std::unique_ptr<double[]>> m_blocks;
+    std::size_t m_blockSize { 0 };
+    std::size_t m_blockUsed { 0 };
+
+    std::unordered_multimap<uint64_t, TempZone> m_index;
+    std::size_t m_stored { 0 }; // 实际保存的double个数
+    std::size_t m_requested { 0 }; // 去重前的double个数
+
+    double* allocate(std::size_t n);
+
+public:
+    MaterialLibrary() = default;
+    MaterialLibrary(const MaterialLibrary&) = delete;
+    MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+
+    // 返回内容相同的已有曲线, 没有时复制一份
+    TempZone intern(const std::vector<double>& X, const std::vector<double>& Y);
+
+    std::size_t curves() const { return m_index.size(); }
+    std::size_t stored_bytes() const { return m_stored * sizeof(double); }
+    std::size_t requested_bytes() const { return m_requested * sizeof(double); }
+};
+
+#endif // MATERIALLIBRARY_H
@@ -0,0 +1,247 @@
+#include "mqttSpool.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::size_t align_up(std::size_t n)
+{
+    return (n + SPOOL_ALIGN - 1) / SPOOL_ALIGN * SPOOL_ALIGN;
+}
+
+} // namespace
+
+MqttSpool::MqttSpool(const std::string& path, std::size_t size)
+    : m_path { path }
+{
+    const std::size_t capacity { size > sizeof(SpoolHeader) ? (size - sizeof(SpoolHeader)) / SPOOL_ALIGN * SPOOL_ALIGN : 0 };
+    if (capacity == 0) {
+        spdlog::error("MQTT spool size {} is too small", size);
+        return;
+    }
+    // 同机未指定WORKER_ID的多个进程使用同一个名称, 被占用时改用spool/mqtt.1.spool等; 编号固定, 重启后仍能补发
+    const std::filesystem::path base { path };
+    for (int slot { 0 }; slot < SPOOL_SLOTS; ++slot) {
+        if (slot > 0) {
+            m_path = (base.parent_path() / (base.stem().string() + "." + std::to_string(slot) + base.extension().string())).string();
+        }
+        bool busy { false };
+        if (open(capacity, busy)) {
+            const std::size_t pending { bytes() };
+            spdlog::info("MQTT spool {}: {} bytes, {} bytes pending", m_path, capacity, pending);
+            return;
+        }
+        if (!busy) {
+            return;
+        }
+        spdlog::warn("MQTT spool {} is used by another process", m_path);
+    }
+    spdlog::error("No free MQTT spool next to {}, spooling disabled", path);
+}
+
+MqttSpool::~MqttSpool() noexcept
+{
+    if (m_header != nullptr) {
+        ::msync(m_header, m_size, MS_SYNC);
+        ::munmap(m_header, m_size);
+    }
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+}
+
+bool MqttSpool::open(std::size_t capacity, bool& busy)
+{
+    const std::filesystem::path dir { std::filesystem::path(m_path).parent_path() };
+    if (!dir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+    }
+
+    const int fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        spdlog::error("Unable to open MQTT spool {}: {}", m_path, std::strerror(errno));
+        return false;
+    }
+    // 两个进程映射同一个环会互相破坏记录, 进程内的m_mutex不能防止
+    if (::flock(fd, LOCK_EX | LOCK_NB) == -1) {
+        busy = errno == EWOULDBLOCK;
+        if (!busy) {
+            spdlog::error("Unable to lock MQTT spool {}: {}", m_path, std::strerror(errno));
+        }
+        ::close(fd);
+        return false;
+    }
+    struct stat st {};
+    const bool existing { ::fstat(fd, &st) == 0 && st.st_size > 0 };
+    m_size = sizeof(SpoolHeader) + capacity;
+    // 预先分配磁盘空间, 断线期间不会因磁盘满在写映射页时收到SIGBUS
+    const int rc { ::posix_fallocate(fd, 0, static_cast<off_t>(m_size)) };
+    if (rc != 0 || ::ftruncate(fd, static_cast<off_t>(m_size)) == -1) {
+        spdlog::error("Unable to size MQTT spool {}: {}", m_path, std::strerror(rc != 0 ? rc : errno));
+        ::close(fd);
+        return false;
+    }
+    void* addr = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        // mlockall(MCL_FUTURE)之后映射须整体锁定, 超过RLIMIT_MEMLOCK时失败
+        spdlog::error("Unable to map MQTT spool {}: {}{}", m_path, std::strerror(errno),
+            errno == EAGAIN || errno == ENOMEM ? ", reduce MQTT_SPOOL_MB or raise RLIMIT_MEMLOCK" : "");
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    // 实时模式下不把整个队列固定在内存中, 只在断线时访问
+    ::munlock(addr, m_size);
+    m_header = static_cast<SpoolHeader*>(addr);
+    m_data = static_cast<char*>(addr) + sizeof(SpoolHeader);
+
+    // 容量改变或内容不一致时未发送的记录无法恢复
+    const bool usable { std::memcmp(m_header->magic, SPOOL_MAGIC, sizeof(SPOOL_MAGIC)) == 0
+        && m_header->version == SPOOL_VERSION && m_header->headerSize == sizeof(SpoolHeader)
+        && m_header->capacity == capacity && m_header->head <= m_header->tail
+        && m_header->tail - m_header->head <= capacity && m_header->head % SPOOL_ALIGN == 0 };
+    if (!usable) {
+        if (existing) {
+            spdlog::warn("MQTT spool {} has a different layout, pending messages discarded", m_path);
+        }
+        std::memset(m_header, 0, sizeof(SpoolHeader));
+        m_header->version = SPOOL_VERSION;
+        m_header->headerSize = sizeof(SpoolHeader);
+        m_header->capacity = capacity;
+        std::memcpy(m_header->magic, SPOOL_MAGIC, sizeof(SPOOL_MAGIC));
+    }
+    return true;
+}
+
+void MqttSpool::reset()
+{
+    spdlog::error("MQTT spool {} is corrupted, {} pending bytes discarded", m_path, m_header->tail - m_header->head);
+    m_header->head = m_header->tail;
+}
+
+bool MqttSpool::empty()
+{
+    return bytes() == 0;
+}
+
+std::size_t MqttSpool::bytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_header == nullptr ? 0 : m_header->tail - m_header->head;
+}
+
+const SpoolRecord* MqttSpool::front()
+{
+    const uint64_t capacity { m_header->capacity };
+    while (m_header->head != m_header->tail) {
+        const std::size_t pos { m_header->head % capacity };
+        const auto* record = reinterpret_cast<const SpoolRecord*>(m_data + pos);
+        if (record->size == 0) {
+            m_header->head += capacity - pos;
+            continue;
+        }
+        if (record->size % SPOOL_ALIGN != 0 || record->size > capacity - pos || record->size > m_header->tail - m_header->head
+            || sizeof(SpoolRecord) + record->topicSize + record->payloadSize > record->size) {
+            reset();
+            return nullptr;
+        }
+        return record;
+    }
+    return nullptr;
+}
+
+void MqttSpool::drop_front()
+{
+    if (const SpoolRecord* record = front()) {
+        m_header->head += record->size;
+    }
+}
+
+bool MqttSpool::push(const std::string& topic, const std::string& payload, int qos, bool retained)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_header == nullptr) {
+        return false;
+    }
+    const uint64_t capacity { m_header->capacity };
+    const std::size_t size { align_up(sizeof(SpoolRecord) + topic.size() + payload.size()) };
+    if (topic.size() > UINT16_MAX || size > capacity / 2) {
+        spdlog::warn("MQTT message for {} is too large to spool ({} bytes)", topic, size);
+        return false;
+    }
+    if (m_header->head == m_header->tail) {
+        m_warned = false;
+    }
+
+    // 末尾放不下时写回绕标记, 记录从数据区开头写起; 空间不足时丢弃最早的记录
+    std::size_t pos { m_header->tail % capacity };
+    const std::size_t skip { capacity - pos < size ? capacity - pos : 0 };
+    std::size_t dropped { 0 };
+    while (capacity - (m_header->tail - m_header->head) < skip + size && m_header->head != m_header->tail) {
+        drop_front();
+        ++dropped;
+    }
+    if (dropped > 0) {
+        m_header->dropped += dropped;
+        if (!m_warned) {
+            spdlog::warn("MQTT spool {} is full, dropping the oldest messages", m_path);
+            m_warned = true;
+        }
+    }
+    if (skip > 0) {
+        reinterpret_cast<SpoolRecord*>(m_data + pos)->size = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->tail += skip;
+        pos = 0;
+    }
+
+    auto* record = reinterpret_cast<SpoolRecord*>(m_data + pos);
+    record->size = static_cast<uint32_t>(size);
+    record->payloadSize = static_cast<uint32_t>(payload.size());
+    record->topicSize = static_cast<uint16_t>(topic.size());
+    record->qos = static_cast<uint8_t>(qos);
+    record->retained = retained ? 1 : 0;
+    char* body = m_data + pos + sizeof(SpoolRecord);
+    std::memcpy(body, topic.data(), topic.size());
+    std::memcpy(body + topic.size(), payload.data(), payload.size());
+    // 记录写完后才推进tail, 编译器和CPU都不得把tail的写入提前到记录之前
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->tail += size;
+    return true;
+}
+
+bool MqttSpool::peek(SpoolMessage& message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_header == nullptr) {
+        return false;
+    }
+    const SpoolRecord* record = front();
+    if (record == nullptr) {
+        return false;
+    }
+    const char* body = reinterpret_cast<const char*>(record) + sizeof(SpoolRecord);
+    message.offset = m_header->head;
+    message.topic.assign(body, record->topicSize);
+    message.payload.assign(body + record->topicSize, record->payloadSize);
+    message.qos = record->qos;
+    message.retained = record->retained != 0;
+    return true;
+}
+
+void MqttSpool::pop(const SpoolMessage& message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_header != nullptr && m_header->head == message.offset) {
+        drop_front();
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef MQTTSPOOL_H
+#define MQTTSPOOL_H
+
+#include "spdlog/spdlog.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 文件布局: 一个SpoolHeader后接capacity字节的环形数据区.
+// 记录为SpoolRecord + topic + payload, 按8字节对齐; 数据区末尾放不下时写一个size为0的记录表示回绕.
+// head/tail为累计字节偏移, 对capacity取模得到位置; 先写记录再推进tail, 进程异常退出后重新打开仍可继续发送
+constexpr const char SPOOL_MAGIC[8] { 'T', 'S', 'S', 'P', 'O', 'O', 'L', '\0' };
+constexpr const uint32_t SPOOL_VERSION { 1 };
+constexpr const std::size_t SPOOL_ALIGN { 8 };
+constexpr const int SPOOL_SLOTS { 8 }; // 文件被其它进程占用时依次尝试<名称>.1 ... <名称>.7
+
+struct alignas(64) SpoolHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t capacity;
+    uint64_t head; // 最早一条未发送记录
+    uint64_t tail; // 下一条记录写入处
+    uint64_t dropped; // 空间不足时丢弃的最早记录数, 累计
+};
+
+struct SpoolRecord {
+    uint32_t size; // 含本结构和对齐, 0表示回绕
+    uint32_t payloadSize;
+    uint16_t topicSize;
+    uint8_t qos;
+    uint8_t retained;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SpoolRecord) % SPOOL_ALIGN == 0, "records must stay aligned");
+
+struct SpoolMessage {
+    uint64_t offset; // 记录在文件中的累计偏移, pop时核对
+    std::string topic;
+    std::string payload;
+    int qos;
+    bool retained;
+};
+
+// MQTT断线期间的落盘队列, 追加写入内存映射文件, 占用固定大小.
+// 满时丢弃最早的记录并告警; 多线程写入, 一个线程读取. 文件无法创建时记录错误, 之后push返回false.
+// 文件以flock独占, 同机的其它进程改用下一个编号的文件; 映射不计入mlockall锁定的内存
+class MqttSpool {
+private:
+    std::string m_path;
+    int m_fd { -1 }; // 持有flock, 析构时关闭
+    std::size_t m_size { 0 };
+    SpoolHeader* m_header { nullptr };
+    char* m_data { nullptr };
+    std::mutex m_mutex;
+    bool m_warned { false }; // 本次积压已告警过丢弃
+
+    // 文件已被其它进程锁定时返回false, busy为true
+    bool open(std::size_t capacity, bool& busy);
+    void reset();
+    // 跳过head处的回绕标记, 返回head处的记录, 没有记录或记录损坏时返回nullptr
+    const SpoolRecord* front();
+    void drop_front();
+
+public:
+    MqttSpool(const std::string& path, std::size_t size);
+    MqttSpool(const MqttSpool&) = delete;
+    MqttSpool& operator=(const MqttSpool&) = delete;
+    ~MqttSpool() noexcept;
+
+    bool valid() const { return m_header != nullptr; }
+    bool empty();
+    std::size_t bytes();
+    bool push(const std::string& topic, const std::string& payload, int qos, bool retained);
+    // 复制最早的一条记录, 不移除
+    bool peek(SpoolMessage& message);
+    // 移除peek得到的记录; 期间已因空间不足被丢弃时不做任何事
+    void pop(const SpoolMessage& message);
+};
+
+#endif // MQTTSPOOL_H
@@ -9,7 +9,7 @@ void init_logger()
     console_sink->set_level(spdlog::level::info);
 
     spdlog::init_thread_pool(8192, 1);
-    auto async_logger = std::make_shared<spdlog::async_logger>("async_logger", spdlog::sinks_init_list { console_sink, rotating_sink }, spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+    auto async_logger = std::make_shared<spdlog::async_logger>("async_logger", spdlog::sinks_init_list { console_sink, rotating_sink }, spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest); // 队列满时丢弃最旧日志, 不阻塞计算线程
     spdlog::set_default_logger(async_logger);
 
     spdlog::flush_every(std::chrono::seconds(3));
@@ -1,5 +1,58 @@
 #include "myMQTT.h"
 
+namespace {
+
+// 每次异步发布分配一个, 回调后自行释放
+class PublishListener : public mqtt::iaction_listener {
+private:
+    std::function<void(bool)> m_done;
+
+public:
+    explicit PublishListener(std::function<void(bool)> done)
+        : m_done { std::move(done) }
+    {
+    }
+
+    void on_failure(const mqtt::token&) override
+    {
+        m_done(false);
+        delete this;
+    }
+
+    void on_success(const mqtt::token&) override
+    {
+        m_done(true);
+        delete this;
+    }
+};
+
+class ConnectListener : public mqtt::iaction_listener {
+private:
+    std::atomic<bool>& m_connecting;
+
+public:
+    explicit ConnectListener(std::atomic<bool>& connecting)
+        : m_connecting { connecting }
+    {
+    }
+
+    void on_failure(const mqtt::token&) override
+    {
+        spdlog::warn("MQTT reconnect failed.");
+        m_connecting = false;
+        delete this;
+    }
+
+    void on_success(const mqtt::token&) override
+    {
+        spdlog::info("Connected to MQTT broker.");
+        m_connecting = false;
+        delete this;
+    }
+};
+
+} // namespace
+
 mqtt::connect_options MyMQTT::buildConnectOptions(const std::string& username, const std::string& password,
     const std::string& caCerts, const std::string& certfile,
     const std::string& keyFile, const std::string& keyFilePassword) const
@@ -34,42 +87,237 @@ void MyMQTT::disconnect()
 MyMQTT::MyMQTT(const std::string& address, const std::string& clientId,
     const std::string& username, const std::string& password,
     const std::string& caCerts, const std::string& certfile,
-    const std::string& keyFile, const std::string& keyFilePassword)
+    const std::string& keyFile, const std::string& keyFilePassword, const std::string& spoolPath, std::size_t spoolSize)
     : client(address, clientId)
     , connOpts { buildConnectOptions(username, password, caCerts, certfile, keyFile, keyFilePassword) }
 {
-    connect();
-    if (!client.is_connected()) {
-        spdlog::error("MQTT connection is not established.");
-        std::terminate();
+    if (!spoolPath.empty()) {
+        m_spool = std::make_unique<MqttSpool>(spoolPath, spoolSize);
     }
+    client.set_message_callback([this](mqtt::const_message_ptr msg) {
+        std::function<void(const std::string&)> onMessage;
+        {
+            std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+            auto it = m_subscriptions.find(msg->get_topic());
+            if (it == m_subscriptions.end()) {
+                return;
+            }
+            onMessage = it->second.second;
+        }
+        onMessage(msg->get_payload_str());
+    });
+    // clean session下断线会丢失订阅
+    client.set_connected_handler([this](const std::string&) {
+        std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+        for (const auto& [topic, subscription] : m_subscriptions) {
+            try {
+                client.subscribe(topic, subscription.first);
+            } catch (const mqtt::exception& e) {
+                spdlog::warn("Exception from subscribe {}: {}", topic, e.what());
+            }
+        }
+    });
+
+    m_replayThread = std::thread([this]() { replay(); });
 }
 
 MyMQTT::~MyMQTT() noexcept
 {
+    {
+        std::lock_guard<std::mutex> lock(m_replayMutex);
+        m_stop = true;
+    }
+    m_replayCv.notify_all();
+    if (m_replayThread.joinable()) {
+        m_replayThread.join();
+    }
     disconnect();
 }
 
 void MyMQTT::connect()
 {
     try {
-        client.connect(connOpts)->wait_for(TIMEOUT); // 断线重连
-        spdlog::info("Connected to MQTT broker.");
+        if (client.connect(connOpts)->wait_for(TIMEOUT)) {
+            spdlog::info("Connected to MQTT broker.");
+        } else {
+            spdlog::warn("MQTT connect timed out.");
+        }
     } catch (const mqtt::exception& e) {
         spdlog::warn("Exception from MQTT connect: {}", e.what());
     }
 }
 
 void MyMQTT::publish(const std::string& topic, const std::string& payload, int qos, bool retained)
+{
+    send(topic, payload, qos, retained, [](bool) {});
+}
+
+void MyMQTT::publish_async(const std::string& topic, const std::string& payload, int qos, std::function<void(bool)> done)
+{
+    send(topic, payload, qos, false, std::move(done));
+}
+
+void MyMQTT::send(const std::string& topic, const std::string& payload, int qos, bool retained, std::function<void(bool)> done)
 {
     auto msg = mqtt::make_message(topic, payload, qos, retained);
-    try {
-        bool ok = client.publish(msg)->wait_for(TIMEOUT);
-        if (!ok) {
-            spdlog::warn("Publishing message timed out.");
+    uint64_t seq { 0 };
+    bool direct { false };
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        seq = m_sendSeq++;
+        // 有积压或有消息等待写入落盘队列时, 新消息也排在后面, 保证按顺序送达
+        direct = client.is_connected() && m_waiting == 0 && !(m_spool && !m_spool->empty());
+        m_outgoing.emplace(seq, Outgoing { msg, direct });
+        if (!direct) {
+            ++m_waiting;
+            flush_outgoing();
         }
+    }
+    if (!direct) {
+        done(false);
+        return;
+    }
+
+    auto* listener = new PublishListener([this, seq, done](bool ok) {
+        complete(seq, ok);
+        done(ok);
+    });
+    try {
+        client.publish(msg, nullptr, *listener);
     } catch (const mqtt::exception& e) {
         spdlog::warn("Exception from publish: {}", e.what());
-        connect();
+        delete listener;
+        complete(seq, false);
+        done(false);
+    }
+}
+
+void MyMQTT::complete(uint64_t seq, bool ok)
+{
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    const auto it = m_outgoing.find(seq);
+    if (it == m_outgoing.end()) {
+        return;
+    }
+    if (ok) {
+        m_outgoing.erase(it);
+    } else {
+        it->second.inFlight = false;
+        ++m_waiting;
+    }
+    flush_outgoing();
+}
+
+void MyMQTT::flush_outgoing()
+{
+    // 遇到仍在发送的消息为止, 其后的消息等它有结果
+    while (!m_outgoing.empty() && !m_outgoing.begin()->second.inFlight) {
+        const auto& msg = m_outgoing.begin()->second.msg;
+        spool(msg->get_topic(), msg->get_payload_str(), msg->get_qos(), msg->is_retained());
+        m_outgoing.erase(m_outgoing.begin());
+        --m_waiting;
+    }
+}
+
+void MyMQTT::spool(const std::string& topic, const std::string& payload, int qos, bool retained)
+{
+    if (!m_spool || !m_spool->push(topic, payload, qos, retained)) {
+        spdlog::warn("MQTT message for {} dropped", topic);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_replayMutex);
+        m_spooled = true;
+    }
+    m_replayCv.notify_one();
+}
+
+bool MyMQTT::reconnect()
+{
+    if (m_connecting.exchange(true)) {
+        return false;
+    }
+    connect();
+    m_connecting = false;
+    return client.is_connected();
+}
+
+void MyMQTT::replay()
+{
+    const auto interval = std::chrono::microseconds(1000000 / MQTT_REPLAY_RATE);
+    auto backoff = std::chrono::duration_cast<std::chrono::microseconds>(MQTT_RECONNECT_MIN);
+    std::size_t replayed { 0 };
+    SpoolMessage message;
+
+    std::unique_lock<std::mutex> lock(m_replayMutex);
+    while (!m_stop) {
+        m_spooled = false;
+        lock.unlock();
+
+        // 重连和补发都在本线程中同步等待, 不占用计算线程
+        std::chrono::microseconds pause { interval };
+        bool wakeOnSpool { false };
+        if (!client.is_connected() && !reconnect()) {
+            pause = backoff;
+            backoff = std::min(backoff * 2, std::chrono::duration_cast<std::chrono::microseconds>(MQTT_RECONNECT_MAX));
+        } else if (m_spool && m_spool->peek(message)) {
+            backoff = std::chrono::duration_cast<std::chrono::microseconds>(MQTT_RECONNECT_MIN);
+            bool ok { false };
+            try {
+                ok = client.publish(mqtt::make_message(message.topic, message.payload, message.qos, message.retained))->wait_for(TIMEOUT);
+            } catch (const mqtt::exception& e) {
+                spdlog::warn("Exception from replaying spooled message: {}", e.what());
+            }
+            if (ok) {
+                m_spool->pop(message);
+                ++replayed;
+            } else {
+                pause = backoff;
+            }
+        } else {
+            backoff = std::chrono::duration_cast<std::chrono::microseconds>(MQTT_RECONNECT_MIN);
+            if (replayed > 0) {
+                spdlog::info("MQTT spool drained, {} messages replayed", replayed);
+                replayed = 0;
+            }
+            // 空闲时等待新的落盘消息, 并定期检查连接
+            pause = std::chrono::duration_cast<std::chrono::microseconds>(MQTT_RECONNECT_MAX);
+            wakeOnSpool = true;
+        }
+
+        lock.lock();
+        m_replayCv.wait_for(lock, pause, [this, wakeOnSpool]() { return m_stop || (wakeOnSpool && m_spooled); });
+    }
+}
+
+void MyMQTT::reconnect_async()
+{
+    if (m_connecting.exchange(true)) {
+        return;
+    }
+    auto* listener = new ConnectListener(m_connecting);
+    try {
+        client.connect(connOpts, nullptr, *listener);
+    } catch (const mqtt::exception& e) {
+        spdlog::warn("Exception from MQTT connect: {}", e.what());
+        delete listener;
+        m_connecting = false;
+    }
+}
+
+void MyMQTT::subscribe(const std::string& topic, int qos, std::function<void(const std::string&)> onMessage)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_subscriptionMutex);
+        m_subscriptions[topic] = { qos, std::move(onMessage) };
+    }
+    if (!client.is_connected()) {
+        reconnect_async(); // 连接成功后由connected handler订阅
+        return;
+    }
+    try {
+        client.subscribe(topic, qos)->wait_for(TIMEOUT);
+        spdlog::info("Subscribed to {}", topic);
+    } catch (const mqtt::exception& e) {
+        spdlog::warn("Exception from subscribe {}: {}", topic, e.what());
     }
 }
@@ -1,35 +1,82 @@
 #ifndef MYMQTT_H
 #define MYMQTT_H
 
+#include "mqttSpool.h"
 #include "spdlog/async.h"
 #include "spdlog/spdlog.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mqtt/async_client.h>
+#include <mutex>
+#include <thread>
 
 constexpr const auto TIMEOUT { std::chrono::seconds(5) };
+constexpr const std::size_t MQTT_SPOOL_SIZE { 64 * 1024 * 1024 }; // 落盘队列文件的默认大小, 满时丢弃最早的消息
+constexpr const int MQTT_REPLAY_RATE { 200 }; // 补发速率上限, 条/秒, 须高于正常发布速率, 否则积压不会消退
+constexpr const auto MQTT_RECONNECT_MIN { std::chrono::seconds(1) };
+constexpr const auto MQTT_RECONNECT_MAX { std::chrono::seconds(60) }; // 重连失败时间隔加倍, 不超过此值
 
 class MyMQTT {
 private:
     mqtt::async_client client;
     mqtt::connect_options connOpts;
+    std::atomic<bool> m_connecting { false };
+    std::mutex m_subscriptionMutex;
+    std::map<std::string, std::pair<int, std::function<void(const std::string&)>>> m_subscriptions; // topic -> (qos, 回调)
+
+    // 已交给paho的消息和排在其后等待写入m_spool的消息, 按发送序号排列.
+    // 发送失败的消息在更早的消息都有结果后才写入m_spool, 不排到之后发送的消息后面
+    struct Outgoing {
+        mqtt::const_message_ptr msg;
+        bool inFlight;
+    };
+    std::mutex m_sendMutex;
+    uint64_t m_sendSeq { 0 };
+    std::map<uint64_t, Outgoing> m_outgoing;
+    std::size_t m_waiting { 0 }; // m_outgoing中已有结果, 等待写入m_spool的消息数
+
+    // 未连接或已有积压时消息写入m_spool, 由m_replayThread连接并按顺序补发
+    std::unique_ptr<MqttSpool> m_spool;
+    std::mutex m_replayMutex;
+    std::condition_variable m_replayCv;
+    bool m_spooled { false };
+    bool m_stop { false };
+    std::thread m_replayThread;
 
     mqtt::connect_options buildConnectOptions(const std::string& username, const std::string& password,
         const std::string& caCerts, const std::string& certfile,
         const std::string& keyFile, const std::string& keyFilePassword) const;
     void disconnect();
+    void send(const std::string& topic, const std::string& payload, int qos, bool retained, std::function<void(bool)> done);
+    void complete(uint64_t seq, bool ok);
+    // 把m_outgoing开头已有结果的消息写入落盘队列, 调用时持有m_sendMutex
+    void flush_outgoing();
+    void spool(const std::string& topic, const std::string& payload, int qos, bool retained);
+    bool reconnect();
+    void replay();
 
 public:
+    // 不等待连接, 由补发线程连接, 失败时按退避重试. spoolPath为空时不落盘, 未连接期间的消息丢弃
     MyMQTT(const std::string& address, const std::string& clientId,
         const std::string& username, const std::string& password,
         const std::string& caCerts, const std::string& certfile,
-        const std::string& keyFile, const std::string& keyFilePassword);
+        const std::string& keyFile, const std::string& keyFilePassword,
+        const std::string& spoolPath = "", std::size_t spoolSize = MQTT_SPOOL_SIZE);
     MyMQTT(const MyMQTT&) = delete;
     MyMQTT& operator=(const MyMQTT&) = delete;
-    MyMQTT(MyMQTT&&) = default;
-    MyMQTT& operator=(MyMQTT&&) = default;
     ~MyMQTT() noexcept;
 
     void connect();
+    // 不等待确认, 不阻塞调用线程; 未连接, 发送失败或已有积压时写入落盘队列, 重连后按顺序补发
     void publish(const std::string& topic, const std::string& payload, int qos, bool retained = false);
+    // 同publish, 完成后在paho线程中调用done(是否已送达); 写入落盘队列时立即回调false
+    void publish_async(const std::string& topic, const std::string& payload, int qos, std::function<void(bool)> done);
+    void reconnect_async();
+    // 订阅topic(不含通配符), 消息在paho线程中交给onMessage, 回调中不可等待发布完成. 重连后自动重新订阅
+    void subscribe(const std::string& topic, int qos, std::function<void(const std::string&)> onMessage);
 };
 
 #endif // MYMQTT_H
\ No newline at end of file
@@ -1,6 +1,35 @@
 #include "myModbus.h"
 
-std::unique_ptr<modbus_mapping_t, decltype(&modbus_mapping_free)> mb_mapping { nullptr, &modbus_mapping_free };
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const std::size_t MBAP_SIZE { 7 }; // 事务号, 协议号, 长度, 单元号
+constexpr const std::size_t MBAP_LENGTH_MAX { 254 }; // 单元号+PDU, ADU不超过260字节
+constexpr const uint8_t EXCEPTION_ILLEGAL_FUNCTION { 1 };
+constexpr const uint8_t EXCEPTION_ILLEGAL_ADDRESS { 2 };
+constexpr const uint8_t EXCEPTION_ILLEGAL_VALUE { 3 };
+
+uint16_t be16(const uint8_t* p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+void put_be16(uint8_t* p, std::size_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+} // namespace
 
 void MyModbusClient::connect()
 {
@@ -29,7 +58,6 @@ MyModbusClient::MyModbusClient(const std::string ip, int port, int slave_id)
     , m_slave_id { slave_id }
     , ctx { nullptr, &modbus_free }
 {
-    connect();
 }
 
 MyModbusClient::~MyModbusClient() noexcept
@@ -45,6 +73,10 @@ std::vector<uint16_t> MyModbusClient::read_registers(int start_registers, int nb
         return {};
     }
 
+    if (ctx == nullptr) {
+        connect(); // 首次使用时连接, 启动时不逐个阻塞
+    }
+
     std::vector<uint16_t> holding_registers(nb_registers);
 
     int blocks = (nb_registers + MODBUS_MAX_READ_REGISTERS - 1) / MODBUS_MAX_READ_REGISTERS;
@@ -67,126 +99,293 @@ std::vector<uint16_t> MyModbusClient::read_registers(int start_registers, int nb
     return holding_registers;
 }
 
-void MyModbusServer::init()
+MyModbusServer::MyModbusServer(const std::string ip, int port, std::size_t registers)
+    : m_ip { ip }
+    , m_port { port }
+    , m_host(registers, 0)
+    , m_wire(registers, 0)
 {
-    try {
-        ctx.reset(modbus_new_tcp(m_ip.c_str(), m_port));
-        if (ctx == nullptr) {
-            throw std::runtime_error("Failed to allocate modbus context");
-        }
-
-        mb_mapping.reset(modbus_mapping_new_start_address(
-            start_bits, nb_bits,
-            start_input_bits, nb_input_bits,
-            start_registers, nb_registers,
-            start_input_registers, nb_input_registers));
-        if (mb_mapping == nullptr) {
-            spdlog::error("Unable to allocate the mapping: {}", modbus_strerror(errno));
-        }
-
-        for (std::size_t i { 0 }; i < nb_bits / 8; ++i) {
-            mb_mapping->tab_bits[8 * i] = 0xAA;
-        }
+}
 
-        for (std::size_t i { 0 }; i < nb_input_bits / 8; ++i) {
-            mb_mapping->tab_input_bits[8 * i] = 0xAA;
-        }
+MyModbusServer::~MyModbusServer() noexcept
+{
+    for (const auto& c : m_connections) {
+        ::close(c->fd);
+    }
+    if (m_listen != -1) {
+        ::close(m_listen);
+    }
+}
 
-        for (std::size_t i { 0 }; i < nb_input_registers; i++) {
-            mb_mapping->tab_input_registers[i] = i;
-        }
+bool MyModbusServer::listen()
+{
+    m_listen = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listen == -1) {
+        spdlog::error("Unable to create Modbus server socket: {}", std::strerror(errno));
+        return false;
+    }
+    const int on { 1 };
+    ::setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
 
-        for (std::size_t i { 0 }; i < nb_registers; i++) {
-            mb_mapping->tab_registers[i] = i;
-        }
-    } catch (const std::exception& e) {
-        spdlog::warn("Exception from modbus server init: {}", e.what());
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(m_port));
+    if (m_ip.empty()) {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    } else if (::inet_pton(AF_INET, m_ip.c_str(), &addr.sin_addr) != 1) {
+        spdlog::error("Invalid Modbus server address {}", m_ip);
+        return false;
+    }
+    if (::bind(m_listen, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == -1
+        || ::listen(m_listen, static_cast<int>(MODBUS_SERVER_CLIENTS)) == -1) {
+        spdlog::error("Unable to listen on Modbus TCP port {}: {}", m_port, std::strerror(errno));
+        return false;
     }
+    return true;
 }
 
-void MyModbusServer::storeFloatToRegisters(uint16_t* tab_registers, std::size_t& index, float value)
+void MyModbusServer::accept_client()
 {
-    uint32_t valueBits;
-    std::memcpy(&valueBits, &value, sizeof(value));
-    tab_registers[index++] = valueBits & 0xFFFF; // Low 16 bits
-    tab_registers[index++] = (valueBits >> 16) & 0xFFFF; // High 16 bits
+    const int fd { ::accept4(m_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC) };
+    if (fd == -1) {
+        spdlog::warn("Failed to accept Modbus client: {}", std::strerror(errno));
+        return;
+    }
+    if (m_connections.size() >= MODBUS_SERVER_CLIENTS) {
+        spdlog::warn("Too many Modbus clients, connection refused");
+        ::close(fd);
+        return;
+    }
+    // 应答是小包, 不等待合并
+    const int on { 1 };
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    auto c = std::make_unique<Connection>();
+    c->fd = fd;
+    m_connections.push_back(std::move(c));
+    spdlog::info("Modbus client connected, {} connections", m_connections.size());
 }
 
-MyModbusServer::MyModbusServer(const std::string ip, int port)
-    : m_ip { ip }
-    , m_port { port }
-    , query { std::make_unique<uint8_t[]>(MODBUS_TCP_MAX_ADU_LENGTH) }
-    , ctx { nullptr, &modbus_free }
+void MyModbusServer::run()
 {
-    init();
+    if (!listen()) {
+        return;
+    }
+    spdlog::info("Modbus server is running: {} registers", m_wire.size());
+
+    std::vector<pollfd> fds;
+    while (true) {
+        fds.clear();
+        fds.push_back({ m_listen, POLLIN, 0 });
+        for (const auto& c : m_connections) {
+            fds.push_back({ c->fd, static_cast<short>(c->pending.empty() ? POLLIN : POLLOUT), 0 });
+        }
+        if (::poll(fds.data(), fds.size(), -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            spdlog::error("Modbus server poll failed: {}", std::strerror(errno));
+            return;
+        }
+
+        // 倒序处理, 关闭连接时前面的下标不变
+        for (std::size_t k { m_connections.size() }; k-- > 0;) {
+            const short events { fds[k + 1].revents };
+            if (events == 0) {
+                continue;
+            }
+            Connection& c = *m_connections[k];
+            const bool ok { (events & (POLLERR | POLLNVAL)) == 0 && (c.pending.empty() ? receive(c) : flush(c)) };
+            if (!ok) {
+                ::close(c.fd);
+                m_connections.erase(m_connections.begin() + static_cast<std::ptrdiff_t>(k));
+                spdlog::info("Modbus client disconnected, {} connections", m_connections.size());
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            accept_client();
+        }
+    }
 }
 
-MyModbusServer::~MyModbusServer() noexcept
+bool MyModbusServer::receive(Connection& c)
 {
-    if (ctx) {
-        modbus_close(ctx.get());
+    const ssize_t n { ::recv(c.fd, c.in.data() + c.inLen, c.in.size() - c.inLen, 0) };
+    if (n == 0) {
+        return false;
     }
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    c.inLen += static_cast<std::size_t>(n);
+    return process(c);
 }
 
-void MyModbusServer::run()
+bool MyModbusServer::process(Connection& c)
 {
-    int rc;
-    listen_sock = modbus_tcp_listen(ctx.get(), 5);
-    if (listen_sock == -1) {
-        spdlog::error("Unable to listen on Modbus TCP port: {}", modbus_strerror(errno));
+    std::size_t offset { 0 };
+    std::array<Reply, MODBUS_SERVER_BATCH> replies;
+    // 缓冲中的完整请求按批应答, 不完整的留到下次recv
+    while (c.pending.empty()) {
+        std::size_t count { 0 };
+        while (count < replies.size() && c.inLen - offset >= MBAP_SIZE + 1) {
+            const uint8_t* frame { c.in.data() + offset };
+            const std::size_t length { be16(frame + 4) };
+            if (be16(frame + 2) != 0 || length < 2 || length > MBAP_LENGTH_MAX) {
+                spdlog::warn("Invalid Modbus TCP frame, closing connection");
+                return false;
+            }
+            const std::size_t size { 6 + length };
+            if (c.inLen - offset < size) {
+                break;
+            }
+            if (trace_enabled(TraceLevel::verbose)) {
+                FramePayload payload {};
+                payload.length = static_cast<uint16_t>(size);
+                std::memcpy(payload.data, frame, std::min(size, sizeof(payload.data)));
+                trace(TraceLevel::verbose, TraceEvent::modbus_request, payload);
+            }
+            prepare(frame, size, replies[count++]);
+            offset += size;
+        }
+        if (count == 0) {
+            break;
+        }
+        if (!respond(c, replies.data(), count)) {
+            return false;
+        }
     }
+    std::memmove(c.in.data(), c.in.data() + offset, c.inLen - offset);
+    c.inLen -= offset;
+    return true;
+}
 
-    client_sock = modbus_tcp_accept(ctx.get(), &listen_sock);
-    if (client_sock == -1) {
-        spdlog::warn("Failed to accept Modbus client: {}", modbus_strerror(errno));
-    }
+void MyModbusServer::prepare(const uint8_t* frame, std::size_t len, Reply& reply) const
+{
+    const uint8_t* pdu { frame + MBAP_SIZE };
+    const std::size_t pduLen { len - MBAP_SIZE };
+    const uint8_t function { pdu[0] };
+    // 事务号, 协议号, 单元号原样返回
+    std::memcpy(reply.head.data(), frame, MBAP_SIZE);
+    reply.head[MBAP_SIZE] = function;
+    reply.readCount = 0;
+    reply.writeData = nullptr;
+    reply.writeCount = 0;
 
-    spdlog::info("Modbus server is running.");
+    auto exception = [&reply, function](uint8_t code) {
+        reply.head[MBAP_SIZE] = static_cast<uint8_t>(function | 0x80);
+        reply.head[MBAP_SIZE + 1] = code;
+        reply.headLen = MBAP_SIZE + 2;
+        put_be16(&reply.head[4], 3);
+    };
 
-    while (1) {
-        rc = modbus_receive(ctx.get(), query.get());
-        if (rc == -1) {
-            spdlog::warn("Modbus server receive failed.");
-            client_sock = modbus_tcp_accept(ctx.get(), &listen_sock);
-            if (client_sock == -1) {
-                spdlog::warn("Failed to accept Modbus client: {}", modbus_strerror(errno));
-            }
+    if (function == 3 || function == 4) {
+        if (pduLen != 5) {
+            exception(EXCEPTION_ILLEGAL_VALUE);
+            return;
+        }
+        const std::size_t addr { be16(pdu + 1) };
+        const std::size_t count { be16(pdu + 3) };
+        if (count < 1 || count > MODBUS_MAX_READ_REGISTERS) {
+            exception(EXCEPTION_ILLEGAL_VALUE);
+        } else if (addr + count > m_wire.size()) {
+            exception(EXCEPTION_ILLEGAL_ADDRESS);
         } else {
-            std::cout << "Received Modbus request (length=" << rc << "): ";
-            std::cout << std::hex;
-            for (int i { 0 }; i < rc; ++i) {
-                std::cout << std::setw(2) << std::setfill('0') << static_cast<int>(query[i]) << " ";
-            }
-            std::cout << std::dec << '\n';
+            reply.head[MBAP_SIZE + 1] = static_cast<uint8_t>(2 * count);
+            reply.headLen = MBAP_SIZE + 2;
+            put_be16(&reply.head[4], 3 + 2 * count);
+            reply.addr = addr;
+            reply.readCount = count;
+        }
+    } else if (function == 16) {
+        if (pduLen < 6) {
+            exception(EXCEPTION_ILLEGAL_VALUE);
+            return;
+        }
+        const std::size_t addr { be16(pdu + 1) };
+        const std::size_t count { be16(pdu + 3) };
+        if (count < 1 || count > MODBUS_MAX_WRITE_REGISTERS || pdu[5] != 2 * count || pduLen != 6 + 2 * count) {
+            exception(EXCEPTION_ILLEGAL_VALUE);
+        } else if (addr + count > m_wire.size()) {
+            exception(EXCEPTION_ILLEGAL_ADDRESS);
+        } else {
+            std::memcpy(&reply.head[MBAP_SIZE + 1], pdu + 1, 4);
+            reply.headLen = MBAP_SIZE + 5;
+            put_be16(&reply.head[4], 6);
+            reply.addr = addr;
+            reply.writeData = pdu + 6;
+            reply.writeCount = count;
+        }
+    } else {
+        exception(EXCEPTION_ILLEGAL_FUNCTION);
+    }
+}
 
-            rc = modbus_reply(ctx.get(), query.get(), rc, mb_mapping.get());
-            if (rc == -1) {
-                spdlog::error("Failed to process Modbus request: {}", modbus_strerror(errno));
+bool MyModbusServer::respond(Connection& c, const Reply* replies, std::size_t count)
+{
+    std::array<iovec, 2 * MODBUS_SERVER_BATCH> iov;
+    std::size_t n { 0 };
+    std::size_t total { 0 };
+
+    std::lock_guard<std::mutex> lock(m_mappingMutex);
+    for (std::size_t k { 0 }; k < count; ++k) {
+        const Reply& r = replies[k];
+        if (r.writeCount > 0) {
+            std::memcpy(&m_wire[r.addr], r.writeData, 2 * r.writeCount);
+            for (std::size_t i { r.addr }; i < r.addr + r.writeCount; ++i) {
+                m_host[i] = ntohs(m_wire[i]);
             }
         }
+        iov[n++] = { const_cast<uint8_t*>(r.head.data()), r.headLen };
+        total += r.headLen;
+        if (r.readCount > 0) {
+            iov[n++] = { &m_wire[r.addr], 2 * r.readCount };
+            total += 2 * r.readCount;
+        }
+    }
+
+    // 非阻塞发送, 持锁时间只有一次系统调用; 发不完的部分复制出来, 等可写时再发
+    msghdr msg {};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = n;
+    ssize_t sent { ::sendmsg(c.fd, &msg, MSG_NOSIGNAL) };
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        }
+        sent = 0;
+    }
+    std::size_t skip { static_cast<std::size_t>(sent) };
+    for (std::size_t k { 0 }; k < n && static_cast<std::size_t>(sent) < total; ++k) {
+        const auto* base = static_cast<const uint8_t*>(iov[k].iov_base);
+        if (skip >= iov[k].iov_len) {
+            skip -= iov[k].iov_len;
+            continue;
+        }
+        c.pending.insert(c.pending.end(), base + skip, base + iov[k].iov_len);
+        skip = 0;
     }
+    return true;
 }
 
-void MyModbusServer::update(json& j, const std::string& name)
+bool MyModbusServer::flush(Connection& c)
 {
-    std::size_t index = 37 * (std::stoi(name) - 1);
+    const ssize_t sent { ::send(c.fd, c.pending.data(), c.pending.size(), MSG_NOSIGNAL) };
+    if (sent < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    c.pending.erase(c.pending.begin(), c.pending.begin() + sent);
+    // 发完后继续处理缓冲中积压的请求
+    return c.pending.empty() ? process(c) : true;
+}
 
-    try {
-        mb_mapping->tab_registers[index++] = j["alert"];
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["centerThermalStress"]);
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["lifeRatio"]);
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["overhaulLifeRatio"]);
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["surfaceThermalStress"]);
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["t0"]);
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["thermalStress"]);
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["thermalStressMargin"]);
-        storeFloatToRegisters(mb_mapping->tab_registers, index, j["ts"]);
-
-        const auto& temperatures = j["temperature"];
-        for (const auto& temp : temperatures) {
-            storeFloatToRegisters(mb_mapping->tab_registers, index, temp);
-        }
-    } catch (const std::exception& e) {
-        spdlog::error("Error occurred during updating tab_registers: {}", e.what());
+void MyModbusServer::update(const RegisterMap& map, const std::vector<RegisterValues>& values)
+{
+    if (values.size() < map.rotors() || map.registers() > m_host.size()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mappingMutex);
+    map.write(m_host.data(), values.data());
+    for (std::size_t i { 0 }; i < m_host.size(); ++i) {
+        m_wire[i] = htons(m_host[i]);
     }
 }
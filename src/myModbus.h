@@ -9,9 +9,14 @@
 #include "spdlog/spdlog.h"
 #include <modbus/modbus.h>
 
-using json = nlohmann::json;
+#include "myTrace.h"
+#include "registerMap.h"
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
 
-extern std::unique_ptr<modbus_mapping_t, decltype(&modbus_mapping_free)> mb_mapping;
+using json = nlohmann::json;
 
 class MyModbusClient {
 private:
@@ -33,35 +38,61 @@ public:
     std::vector<uint16_t> read_registers(int start_registers, int nb_registers);
 };
 
+constexpr const std::size_t MODBUS_REGISTER_MAX { 10000 }; // 寄存器映射允许的最大地址+1
+constexpr const std::size_t MODBUS_SERVER_CLIENTS { 16 }; // 同时连接的客户端上限
+constexpr const std::size_t MODBUS_SERVER_BUFFER { 4096 }; // 每个连接的接收缓冲, 一次recv可取到多个流水线请求
+constexpr const std::size_t MODBUS_SERVER_BATCH { 32 }; // 一次sendmsg合并的应答数上限
+
+// Modbus TCP服务端, 只处理功能码3/4(读保持/输入寄存器, 同一寄存器映像)和16(写多个寄存器), 其余回应非法功能.
+// 请求在接收缓冲中原地解析; 寄存器映像按网络字节序保存, 应答的寄存器数据直接引用映像, 与头部一起由sendmsg发出.
+// 单线程poll处理所有连接
 class MyModbusServer {
 private:
+    struct Connection {
+        int fd { -1 };
+        std::array<uint8_t, MODBUS_SERVER_BUFFER> in;
+        std::size_t inLen { 0 };
+        std::vector<uint8_t> pending; // 未能立即发出的应答, 发完前不再处理该连接的请求
+    };
+
+    // 一条应答: 头部为MBAP+功能码及其后的固定字段, 读请求的数据在映像中, 写请求的数据在接收缓冲中
+    struct Reply {
+        std::array<uint8_t, 12> head;
+        std::size_t headLen { 0 };
+        std::size_t addr { 0 };
+        std::size_t readCount { 0 };
+        const uint8_t* writeData { nullptr };
+        std::size_t writeCount { 0 };
+    };
+
     const std::string m_ip;
-    int m_port;
-    std::unique_ptr<uint8_t[]> query;
-    std::unique_ptr<modbus_t, decltype(&modbus_free)> ctx;
-    int listen_sock, client_sock;
-    unsigned int start_bits = 0;
-    unsigned int start_input_bits = 0;
-    unsigned int start_input_registers = 0;
-    unsigned int start_registers = 0;
-    unsigned int nb_bits = 100; // 线圈读写个数
-    unsigned int nb_input_bits = 10000; // 离散量读个数
-    unsigned int nb_input_registers = 10000; // 输入寄存器读个数
-    unsigned int nb_registers = 10000; // 保持寄存器读写个数
-
-    void init();
-    void storeFloatToRegisters(uint16_t* tab_registers, std::size_t& index, float value);
+    const int m_port;
+    int m_listen { -1 };
+    std::vector<std::unique_ptr<Connection>> m_connections;
+    std::vector<uint16_t> m_host; // 主机字节序, RegisterMap写入
+    std::vector<uint16_t> m_wire; // 网络字节序, 应答直接引用
+    std::mutex m_mappingMutex; // 保证客户端读到的多寄存器值来自同一周期
+
+    bool listen();
+    void accept_client();
+    // 返回false时关闭连接
+    bool receive(Connection& c);
+    bool process(Connection& c);
+    bool respond(Connection& c, const Reply* replies, std::size_t count);
+    bool flush(Connection& c);
+    void prepare(const uint8_t* frame, std::size_t len, Reply& reply) const;
 
 public:
-    MyModbusServer(const std::string ip, int port);
+    // registers为映射实际用到的寄存器数(RegisterMap::registers())
+    MyModbusServer(const std::string ip, int port, std::size_t registers);
     MyModbusServer(const MyModbusServer&) = delete;
     MyModbusServer& operator=(const MyModbusServer&) = delete;
-    MyModbusServer(MyModbusServer&&) = default;
-    MyModbusServer& operator=(MyModbusServer&&) = default;
     ~MyModbusServer() noexcept;
 
     void run();
-    void update(json& j, const std::string& name);
+    std::size_t register_count() const { return m_wire.size(); }
+    // 按编译好的映射一次写入所有转子, values[i]对应映射编译时的第i个转子
+    void update(const RegisterMap& map, const std::vector<RegisterValues>& values);
 };
 
 #endif // MYMODBUS_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "myRedis.h"
 
+#include <thread>
+
 sw::redis::ConnectionOptions MyRedis::makeConnectionOptions(const std::string& ip, int port, int db, const std::string& user, const std::string& password)
 {
     sw::redis::ConnectionOptions opts;
@@ -50,16 +52,75 @@ double MyRedis::m_hget(const std::string& key, const std::string& field)
     return res;
 }
 
-void MyRedis::m_hset(const std::string& hash, const std::string& key, const std::string& value)
+std::vector<double> MyRedis::m_hmget(const std::string& key, const std::vector<std::string>& fields)
+{
+    std::vector<double> res(fields.size(), 0);
+    try {
+        std::vector<sw::redis::OptionalString> values;
+        values.reserve(fields.size());
+        m_redis.hmget(key, fields.begin(), fields.end(), std::back_inserter(values));
+        for (std::size_t i { 0 }; i < values.size() && i < res.size(); ++i) {
+            try {
+                res[i] = std::stod(values[i].value_or("0"));
+            } catch (const std::exception& e) {
+                spdlog::warn("Exception from m_hmget {}: {}", fields[i], e.what());
+            }
+        }
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from m_hmget: {}", e.what());
+    }
+    return res;
+}
+
+std::string MyRedis::m_hget_string(const std::string& key, const std::string& field)
+{
+    try {
+        return m_redis.hget(key, field).value_or("");
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from m_hget_string: {}", e.what());
+    }
+    return {};
+}
+
+std::vector<std::string> MyRedis::m_hmget_strings(const std::string& key, const std::vector<std::string>& fields)
+{
+    std::vector<std::string> res(fields.size());
+    try {
+        std::vector<sw::redis::OptionalString> values;
+        values.reserve(fields.size());
+        m_redis.hmget(key, fields.begin(), fields.end(), std::back_inserter(values));
+        for (std::size_t i { 0 }; i < values.size() && i < res.size(); ++i) {
+            res[i] = values[i].value_or("");
+        }
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from m_hmget_strings: {}", e.what());
+    }
+    return res;
+}
+
+bool MyRedis::m_hmset(const std::string& key, const std::vector<std::pair<std::string, std::string>>& fields)
+{
+    try {
+        m_redis.hmset(key, fields.begin(), fields.end());
+        return true;
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from m_hmset: {}", e.what());
+        return false;
+    }
+}
+
+bool MyRedis::m_hset(const std::string& hash, const std::string& key, const std::string& value)
 {
     try {
         m_redis.hset(hash, key, value);
+        return true;
     } catch (const std::exception& e) {
         spdlog::warn("Exception from m_hset: {}", e.what());
+        return false;
     }
 }
 
-json MyRedis::m_hgetall(const std::string& key)
+std::optional<json> MyRedis::m_hgetall(const std::string& key)
 {
     std::unordered_map<std::string, std::string> hash;
     json res;
@@ -70,6 +131,66 @@ json MyRedis::m_hgetall(const std::string& key)
         }
     } catch (const std::exception& e) {
         spdlog::warn("Exception from hgetall: {}", e.what());
+        return std::nullopt;
     }
     return res;
 }
+
+void MyRedis::m_xadd_batch(const std::string& key, const StreamFields* first, const StreamFields* last, long long maxLen)
+{
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
+    try {
+        if (!m_pipeline) {
+            m_pipeline = std::make_unique<sw::redis::Pipeline>(m_redis.pipeline());
+        }
+        for (const StreamFields* fields { first }; fields != last; ++fields) {
+            m_pipeline->xadd(key, "*", fields->begin(), fields->end(), maxLen, true);
+        }
+        m_pipeline->exec();
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from m_xadd_batch: {}", e.what());
+        m_pipeline.reset(); // 连接状态未知, 下次重建
+    }
+}
+
+void MyRedis::m_publish(const std::string& channel, const std::string& message)
+{
+    try {
+        m_redis.publish(channel, message);
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from m_publish: {}", e.what());
+    }
+}
+
+std::vector<std::string> MyRedis::m_eval(const std::string& script, const std::vector<std::string>& keys, const std::vector<std::string>& args)
+{
+    std::vector<std::string> res;
+    try {
+        m_redis.eval(script, keys.begin(), keys.end(), args.begin(), args.end(), std::back_inserter(res));
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from m_eval: {}", e.what());
+        res.clear();
+    }
+    return res;
+}
+
+void MyRedis::m_subscribe(const std::string& channel, const std::function<void(const std::string&)>& onMessage, const std::atomic<bool>& stop)
+{
+    while (!stop) {
+        try {
+            auto subscriber = m_redis.subscriber();
+            subscriber.on_message([&onMessage](std::string, std::string message) { onMessage(message); });
+            subscriber.subscribe(channel);
+            while (!stop) {
+                try {
+                    subscriber.consume();
+                } catch (const sw::redis::TimeoutError&) {
+                    // socket_timeout到期, 只用于检查stop
+                }
+            }
+        } catch (const std::exception& e) {
+            spdlog::warn("Exception from m_subscribe {}: {}", channel, e.what());
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+}
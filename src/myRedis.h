@@ -4,24 +4,52 @@
 #include "nlohmann/json.hpp"
 #include "spdlog/async.h"
 #include "spdlog/spdlog.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sw/redis++/redis++.h>
+#include <utility>
+#include <vector>
 
 using json = nlohmann::json;
 
 class MyRedis {
 private:
     sw::redis::Redis m_redis;
+    std::mutex m_pipelineMutex;
+    std::unique_ptr<sw::redis::Pipeline> m_pipeline; // 独占一个连接, 首次使用时创建, 出错后重建
 
     sw::redis::ConnectionOptions makeConnectionOptions(const std::string& ip, int port, int db, const std::string& user, const std::string& password);
     sw::redis::ConnectionPoolOptions makePoolOptions();
 
 public:
+    using StreamFields = std::vector<std::pair<std::string, std::string>>;
+
     MyRedis(const std::string& ip, int port, int db, const std::string& user, const std::string& password);
     MyRedis(const std::string& unixSocket);
 
     double m_hget(const std::string& key, const std::string& field);
-    void m_hset(const std::string& hash, const std::string& key, const std::string& value);
-    json m_hgetall(const std::string& key);
+    // 一次往返读取多个字段, 不存在或出错的字段为0
+    std::vector<double> m_hmget(const std::string& key, const std::vector<std::string>& fields);
+    // 字段不存在或出错时返回空串
+    std::string m_hget_string(const std::string& key, const std::string& field);
+    // 一次往返读取多个字段, 不存在或出错的字段为空串
+    std::vector<std::string> m_hmget_strings(const std::string& key, const std::vector<std::string>& fields);
+    // 出错时返回false
+    bool m_hset(const std::string& hash, const std::string& key, const std::string& value);
+    // 一次往返写入多个字段, 出错时返回false
+    bool m_hmset(const std::string& key, const std::vector<std::pair<std::string, std::string>>& fields);
+    // 各字段的值按JSON解析. 出错或有字段不是JSON时返回空, 不返回部分结果; key不存在时为null
+    std::optional<json> m_hgetall(const std::string& key);
+    // 一次往返向同一个流追加多条记录(ID为*), 并以MAXLEN ~ maxLen近似裁剪
+    void m_xadd_batch(const std::string& key, const StreamFields* first, const StreamFields* last, long long maxLen);
+    void m_publish(const std::string& channel, const std::string& message);
+    // 执行Lua脚本, 返回值须为字符串数组. 出错时返回空
+    std::vector<std::string> m_eval(const std::string& script, const std::vector<std::string>& keys, const std::vector<std::string>& args);
+    // 在调用线程上订阅channel, 每条消息调用onMessage, 直到stop为true. 连接出错后重新订阅
+    void m_subscribe(const std::string& channel, const std::function<void(const std::string&)>& onMessage, const std::atomic<bool>& stop);
 };
 
 #endif // MYREDIS_H
\ No newline at end of file
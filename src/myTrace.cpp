@@ -0,0 +1,371 @@
+#include "myTrace.h"
+
+#include "spdlog/spdlog.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+std::atomic<uint8_t> g_traceLevel { static_cast<uint8_t>(TraceLevel::off) };
+
+namespace {
+
+constexpr const std::size_t TRACE_RING_SIZE { 1024 }; // 2的幂
+constexpr const std::size_t TRACE_MAX_RINGS { 512 };
+constexpr const auto TRACE_DRAIN_INTERVAL { std::chrono::milliseconds(20) };
+
+struct TraceRing {
+    std::array<TraceRecord, TRACE_RING_SIZE> records;
+    alignas(64) std::atomic<uint64_t> head { 0 }; // 仅生产线程写
+    alignas(64) std::atomic<uint64_t> tail { 0 }; // 仅后台线程写
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<bool> owned { false };
+};
+
+// 环形缓冲区只增不减, 线程退出后归还给后续线程复用(std::async每周期都会新建线程)
+std::array<std::atomic<TraceRing*>, TRACE_MAX_RINGS> g_rings {};
+std::atomic<std::size_t> g_ringCount { 0 };
+std::mutex g_ringsMutex;
+std::atomic<uint64_t> g_unbuffered { 0 }; // 没有可用缓冲区时丢弃的记录
+
+TraceRing* claim_ring(bool drainedOnly)
+{
+    const std::size_t count = g_ringCount.load(std::memory_order_acquire);
+    for (std::size_t i { 0 }; i < count; ++i) {
+        TraceRing* ring = g_rings[i].load(std::memory_order_acquire);
+        if (drainedOnly && ring->head.load(std::memory_order_acquire) != ring->tail.load(std::memory_order_acquire)) {
+            continue;
+        }
+        bool expected { false };
+        if (ring->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return ring;
+        }
+    }
+    return nullptr;
+}
+
+TraceRing* acquire_ring()
+{
+    // 优先复用已清空的缓冲区, 其次新建, 达到上限后复用任意空闲缓冲区
+    if (TraceRing* ring = claim_ring(true)) {
+        return ring;
+    }
+
+    std::lock_guard<std::mutex> lock(g_ringsMutex);
+    const std::size_t index = g_ringCount.load(std::memory_order_relaxed);
+    if (index == TRACE_MAX_RINGS) {
+        return claim_ring(false);
+    }
+    auto* ring = new TraceRing();
+    ring->owned.store(true, std::memory_order_relaxed);
+    g_rings[index].store(ring, std::memory_order_release);
+    g_ringCount.store(index + 1, std::memory_order_release);
+    return ring;
+}
+
+struct ThreadRing {
+    TraceRing* ring { nullptr };
+    uint32_t tid { static_cast<uint32_t>(::syscall(SYS_gettid)) };
+
+    ~ThreadRing()
+    {
+        if (ring) {
+            ring->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRing t_ring;
+
+class TraceFile {
+private:
+    const std::string m_path;
+    const std::size_t m_capacity;
+    const std::size_t m_maxFiles;
+    int m_fd { -1 };
+    std::size_t m_size { 0 };
+    TraceFileHeader* m_header { nullptr };
+    TraceRecord* m_records { nullptr };
+
+    std::string file_name(std::size_t index) const
+    {
+        return index == 0 ? m_path : m_path + "." + std::to_string(index);
+    }
+
+    void rotate_files() const
+    {
+        std::remove(file_name(m_maxFiles - 1).c_str());
+        for (std::size_t i { m_maxFiles - 1 }; i > 0; --i) {
+            std::rename(file_name(i - 1).c_str(), file_name(i).c_str());
+        }
+    }
+
+    bool open_file()
+    {
+        m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd == -1 || ::ftruncate(m_fd, static_cast<off_t>(m_size)) == -1) {
+            spdlog::error("Unable to create trace file {}: {}", m_path, std::strerror(errno));
+            close_file();
+            return false;
+        }
+        void* addr = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (addr == MAP_FAILED) {
+            spdlog::error("Unable to map trace file {}: {}", m_path, std::strerror(errno));
+            close_file();
+            return false;
+        }
+        m_header = static_cast<TraceFileHeader*>(addr);
+        m_records = reinterpret_cast<TraceRecord*>(m_header + 1);
+
+        std::memset(m_header, 0, sizeof(TraceFileHeader));
+        std::memcpy(m_header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        m_header->version = TRACE_VERSION;
+        m_header->recordSize = sizeof(TraceRecord);
+        m_header->capacity = m_capacity;
+        m_header->createdNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+        return true;
+    }
+
+    void close_file()
+    {
+        if (m_header) {
+            ::msync(m_header, m_size, MS_ASYNC);
+            ::munmap(m_header, m_size);
+            m_header = nullptr;
+            m_records = nullptr;
+        }
+        if (m_fd != -1) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+public:
+    TraceFile(const std::string& path, std::size_t fileSize, std::size_t maxFiles)
+        : m_path { path }
+        , m_capacity { fileSize > sizeof(TraceFileHeader) ? (fileSize - sizeof(TraceFileHeader)) / sizeof(TraceRecord) : 1 }
+        , m_maxFiles { maxFiles == 0 ? 1 : maxFiles }
+        , m_size { sizeof(TraceFileHeader) + m_capacity * sizeof(TraceRecord) }
+    {
+        // 保留上次运行的跟踪文件
+        rotate_files();
+        open_file();
+    }
+    TraceFile(const TraceFile&) = delete;
+    TraceFile& operator=(const TraceFile&) = delete;
+
+    ~TraceFile() noexcept
+    {
+        close_file();
+    }
+
+    void append(const TraceRecord& record)
+    {
+        if (m_header && m_header->count == m_capacity) {
+            close_file();
+            rotate_files();
+            open_file();
+        }
+        if (!m_header) {
+            return;
+        }
+        m_records[m_header->count] = record;
+        ++m_header->count;
+    }
+};
+
+std::unique_ptr<TraceFile> g_file;
+std::thread g_drainer;
+std::mutex g_drainMutex;
+std::condition_variable g_drainCv;
+bool g_stop { false };
+
+void drain_once()
+{
+    const std::size_t count = g_ringCount.load(std::memory_order_acquire);
+    for (std::size_t i { 0 }; i < count; ++i) {
+        TraceRing* ring = g_rings[i].load(std::memory_order_acquire);
+        const uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            g_file->append(ring->records[tail & (TRACE_RING_SIZE - 1)]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+}
+
+void drain_loop()
+{
+    uint64_t reported { 0 };
+    std::unique_lock<std::mutex> lock(g_drainMutex);
+    while (!g_stop) {
+        g_drainCv.wait_for(lock, TRACE_DRAIN_INTERVAL);
+        drain_once();
+
+        const uint64_t dropped = trace_dropped();
+        if (dropped != reported) {
+            spdlog::warn("Trace buffer overflow, {} records dropped in total.", dropped);
+            reported = dropped;
+        }
+    }
+    drain_once();
+}
+
+void on_level_signal(int sig)
+{
+    // 只修改原子变量, 可在信号处理函数中安全调用
+    uint8_t level = g_traceLevel.load(std::memory_order_relaxed);
+    if (sig == SIGUSR1 && level < static_cast<uint8_t>(TraceLevel::verbose)) {
+        g_traceLevel.store(level + 1, std::memory_order_relaxed);
+    } else if (sig == SIGUSR2 && level > static_cast<uint8_t>(TraceLevel::off)) {
+        g_traceLevel.store(level - 1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+void init_trace(const std::string& path, std::size_t fileSize, std::size_t maxFiles, TraceLevel level)
+{
+    g_file = std::make_unique<TraceFile>(path, fileSize, maxFiles);
+    g_drainer = std::thread(drain_loop);
+    set_trace_level(level);
+
+    // 运行时切换级别: kill -USR1 提高, kill -USR2 降低
+    std::signal(SIGUSR1, on_level_signal);
+    std::signal(SIGUSR2, on_level_signal);
+}
+
+void shutdown_trace()
+{
+    if (!g_drainer.joinable()) {
+        return;
+    }
+    set_trace_level(TraceLevel::off);
+    {
+        std::lock_guard<std::mutex> lock(g_drainMutex);
+        g_stop = true;
+    }
+    g_drainCv.notify_one();
+    g_drainer.join();
+    g_file.reset();
+}
+
+void set_trace_level(TraceLevel level)
+{
+    g_traceLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+TraceLevel parse_trace_level(const char* str)
+{
+    const std::string s { str ? str : "" };
+    if (s == "info") {
+        return TraceLevel::info;
+    } else if (s == "debug") {
+        return TraceLevel::debug;
+    } else if (s == "verbose") {
+        return TraceLevel::verbose;
+    }
+    return TraceLevel::off;
+}
+
+uint64_t trace_dropped()
+{
+    uint64_t dropped = g_unbuffered.load(std::memory_order_relaxed);
+    const std::size_t count = g_ringCount.load(std::memory_order_acquire);
+    for (std::size_t i { 0 }; i < count; ++i) {
+        dropped += g_rings[i].load(std::memory_order_acquire)->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void trace_write(TraceLevel level, TraceEvent event, const void* payload, std::size_t length)
+{
+    if (!t_ring.ring) {
+        t_ring.ring = acquire_ring();
+        if (!t_ring.ring) {
+            g_unbuffered.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    TraceRing* ring = t_ring.ring;
+
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= TRACE_RING_SIZE) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceRecord& record = ring->records[head & (TRACE_RING_SIZE - 1)];
+    record.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+    record.tid = t_ring.tid;
+    record.event = static_cast<uint16_t>(event);
+    record.level = static_cast<uint8_t>(level);
+    record.length = static_cast<uint8_t>(length < TRACE_PAYLOAD_SIZE ? length : TRACE_PAYLOAD_SIZE);
+    std::memcpy(record.payload, payload, record.length);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+std::string trace_format(const TraceRecord& record)
+{
+    const auto seconds = static_cast<std::time_t>(record.timeNs / 1000000000);
+    std::tm tm {};
+    localtime_r(&seconds, &tm);
+    char time[32];
+    std::strftime(time, sizeof(time), "%F %T", &tm);
+
+    std::string res { fmt::format("[{}.{:06}] [{}] ", time, record.timeNs % 1000000000 / 1000, record.tid) };
+
+    switch (static_cast<TraceEvent>(record.event)) {
+    case TraceEvent::loop_time: {
+        LoopTimePayload p {};
+        std::memcpy(&p, record.payload, std::min<std::size_t>(record.length, sizeof(p)));
+        res += fmt::format("Loop {} time used: {} microseconds", p.count, p.elapsedUs);
+        break;
+    }
+    case TraceEvent::surface_registers: {
+        RegistersPayload p {};
+        std::memcpy(&p, record.payload, std::min<std::size_t>(record.length, sizeof(p)));
+        res += fmt::format("Rotor {} registers {}+{}:", std::string(p.name, strnlen(p.name, sizeof(p.name))), p.start, p.count);
+        for (std::size_t i { 0 }; i < std::min<std::size_t>(p.count, std::size(p.registers)); ++i) {
+            res += fmt::format(" {}", p.registers[i]);
+        }
+        break;
+    }
+    case TraceEvent::modbus_request: {
+        FramePayload p {};
+        std::memcpy(&p, record.payload, std::min<std::size_t>(record.length, sizeof(p)));
+        res += fmt::format("Received Modbus request (length={}):", p.length);
+        for (std::size_t i { 0 }; i < std::min<std::size_t>(p.length, sizeof(p.data)); ++i) {
+            res += fmt::format(" {:02x}", p.data[i]);
+        }
+        break;
+    }
+    case TraceEvent::cycle_latency: {
+        CycleLatencyPayload p {};
+        std::memcpy(&p, record.payload, std::min<std::size_t>(record.length, sizeof(p)));
+        res += fmt::format("Loop {} wake latency: {} us, cycle: {} us, step max: {} ns", p.count, p.wakeUs, p.cycleUs, p.stepMaxNs);
+        break;
+    }
+    case TraceEvent::cycle_overrun: {
+        CycleOverrunPayload p {};
+        std::memcpy(&p, record.payload, std::min<std::size_t>(record.length, sizeof(p)));
+        res += fmt::format("Loop {} overrun: {} microseconds, {} cycles skipped", p.count, p.elapsedUs, p.skipped);
+        break;
+    }
+    default:
+        res += fmt::format("Unknown event {} ({} bytes)", record.event, record.length);
+    }
+    return res;
+}
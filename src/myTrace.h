@@ -0,0 +1,119 @@
+#ifndef MYTRACE_H
+#define MYTRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// 热路径二进制跟踪: 定长记录写入每线程无锁环形缓冲区, 后台线程写入内存映射的滚动文件,
+// 缓冲区满时丢弃并计数, 从不阻塞调用线程. 离线用tools/trace_decode解码.
+
+enum class TraceLevel : uint8_t {
+    off = 0,
+    info,
+    debug,
+    verbose
+};
+
+enum class TraceEvent : uint16_t {
+    loop_time = 1,
+    surface_registers,
+    modbus_request,
+    cycle_latency,
+    cycle_overrun
+};
+
+constexpr const std::size_t TRACE_PAYLOAD_SIZE { 48 };
+
+struct TraceRecord {
+    uint64_t timeNs; // system_clock, 纳秒
+    uint32_t tid;
+    uint16_t event;
+    uint8_t level;
+    uint8_t length; // payload有效字节数
+    uint8_t payload[TRACE_PAYLOAD_SIZE];
+};
+static_assert(sizeof(TraceRecord) == 64, "TraceRecord must stay 64 bytes");
+
+struct TraceFileHeader {
+    char magic[8]; // "TSTRACE"
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity; // 记录条数上限
+    uint64_t count; // 已写入记录条数
+    uint64_t createdNs;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(TraceFileHeader) == 64, "TraceFileHeader must stay 64 bytes");
+
+constexpr const char TRACE_MAGIC[8] { 'T', 'S', 'T', 'R', 'A', 'C', 'E', '\0' };
+constexpr const uint32_t TRACE_VERSION { 1 };
+
+// 各事件的payload布局
+struct LoopTimePayload {
+    int64_t count;
+    int64_t elapsedUs;
+};
+
+struct CycleLatencyPayload {
+    int64_t count;
+    int64_t wakeUs; // 实际唤醒与计划时刻之差
+    int64_t cycleUs;
+    int64_t stepMaxNs; // 本统计窗口内单转子计算最大耗时
+};
+
+struct CycleOverrunPayload {
+    int64_t count;
+    int64_t elapsedUs;
+    int64_t skipped; // 放弃的周期边界数
+};
+
+struct RegistersPayload {
+    char name[8];
+    uint16_t start;
+    uint16_t count; // 实际读到的寄存器数, 超过18个只保存前18个
+    uint16_t registers[18];
+};
+
+struct FramePayload {
+    uint16_t length; // 原始帧长度, 超过46字节只保存前46字节
+    uint8_t data[46];
+};
+
+extern std::atomic<uint8_t> g_traceLevel;
+
+inline bool trace_enabled(TraceLevel level)
+{
+    return static_cast<uint8_t>(level) <= g_traceLevel.load(std::memory_order_relaxed);
+}
+
+void init_trace(const std::string& path, std::size_t fileSize, std::size_t maxFiles, TraceLevel level);
+void shutdown_trace();
+
+// 作用域结束时停止跟踪线程, 避免提前返回时析构仍可join的std::thread
+struct TraceGuard {
+    TraceGuard() = default;
+    TraceGuard(const TraceGuard&) = delete;
+    TraceGuard& operator=(const TraceGuard&) = delete;
+    ~TraceGuard() noexcept { shutdown_trace(); }
+};
+void set_trace_level(TraceLevel level);
+TraceLevel parse_trace_level(const char* str);
+uint64_t trace_dropped();
+
+void trace_write(TraceLevel level, TraceEvent event, const void* payload, std::size_t length);
+
+template <typename T>
+void trace(TraceLevel level, TraceEvent event, const T& payload)
+{
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= TRACE_PAYLOAD_SIZE, "Invalid trace payload");
+    if (trace_enabled(level)) {
+        trace_write(level, event, &payload, sizeof(T));
+    }
+}
+
+std::string trace_format(const TraceRecord& record);
+
+#endif // MYTRACE_H
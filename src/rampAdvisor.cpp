@@ -0,0 +1,105 @@
+#include "rampAdvisor.h"
+
+#include <algorithm>
+#include <latch>
+#include <limits>
+#include <thread>
+
+RampAdvisor::RampAdvisor(double marginLimit, double maxRate, double targetTemp, double horizon, int iterations)
+    : m_marginLimit { marginLimit }
+    , m_maxRate { maxRate }
+    , m_targetTemp { targetTemp }
+    , m_horizon { horizon }
+    , m_iterations { iterations }
+    , m_pool { std::make_unique<ThreadPool>(std::thread::hardware_concurrency()) }
+{
+}
+
+RampAdvice RampAdvisor::simulate(const RampInput& input, double rate) const
+{
+    RampAdvice res;
+    res.rampRate = rate;
+    res.minMargin = std::numeric_limits<double>::max();
+
+    // 在具体的内核实例上推演, 循环内无分派
+    std::visit([&](const auto& kernel) {
+        auto thermal { kernel };
+        LifeState lifeState { input.life };
+
+        // 与Rotor::run的计算顺序一致: 先用上一周期的边界温度推进温度场, 再更新边界温度
+        const double scanCycle { thermal.scan_cycle() };
+        const double startTemp { thermal.surface_temp() };
+        const double endTemp { std::max(startTemp, m_targetTemp) };
+        const int steps { static_cast<int>(std::ceil(m_horizon / scanCycle)) };
+
+        for (int k { 1 }; k <= steps; ++k) {
+            thermal.temp_field();
+            const StressState stress { thermal.thermal_stress() };
+            thermal.life(stress.thermalStress, lifeState);
+            res.minMargin = std::min(res.minMargin, stress.thermalStressMargin);
+
+            thermal.set_surface_temp(std::min(startTemp + rate * k * scanCycle / 60, endTemp));
+        }
+        // 推演结束时未闭合的应力循环也计入寿命消耗
+        thermal.life(0, lifeState);
+        res.lifeConsumption = lifeState.lifeRatio - input.life.lifeRatio;
+    },
+        input.thermal.kernel());
+    return res;
+}
+
+RampAdvice RampAdvisor::advise(const RampInput& input) const
+{
+    RampAdvice hold { simulate(input, 0) };
+    hold.feasible = hold.minMargin >= m_marginLimit;
+    if (!hold.feasible) {
+        return hold;
+    }
+
+    RampAdvice fastest { simulate(input, m_maxRate) };
+    if (fastest.minMargin >= m_marginLimit) {
+        fastest.feasible = true;
+        return fastest;
+    }
+
+    // 二分: best始终为满足限值的速率
+    RampAdvice best { hold };
+    double lo { 0 }, hi { m_maxRate };
+    for (int i { 0 }; i < m_iterations; ++i) {
+        const double mid { (lo + hi) / 2 };
+        RampAdvice candidate { simulate(input, mid) };
+        if (candidate.minMargin >= m_marginLimit) {
+            lo = mid;
+            best = candidate;
+        } else {
+            hi = mid;
+        }
+    }
+    best.feasible = true;
+    return best;
+}
+
+const std::vector<RampAdvice>& RampAdvisor::run()
+{
+    const std::size_t len { m_inputs.size() };
+    m_advice.resize(len);
+    if (len == 0) {
+        return m_advice;
+    }
+
+    const std::size_t workers { std::min(m_pool->size(), len) };
+    const std::size_t chunk { (len + workers - 1) / workers };
+
+    std::latch done { static_cast<std::ptrdiff_t>((len + chunk - 1) / chunk) };
+    for (std::size_t begin { 0 }; begin < len; begin += chunk) {
+        const std::size_t end { std::min(begin + chunk, len) };
+        m_pool->submit([this, begin, end, &done]() {
+            for (std::size_t i { begin }; i < end; ++i) {
+                m_advice[i] = advise(m_inputs[i]);
+            }
+            done.count_down();
+        });
+    }
+    done.wait();
+    return m_advice;
+}
@@ -0,0 +1,56 @@
+#ifndef RAMPADVISOR_H
+#define RAMPADVISOR_H
+
+#include "reactor.h"
+#include "thermalModel.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// 启动升温速率建议: 以转子当前温度场为初值, 对候选升温速率做前向推演,
+// 二分查找推演期内热应力裕度不低于限值的最大升温速率
+
+constexpr const double RAMP_MARGIN_LIMIT { 20.0 }; // 热应力裕度下限, %
+constexpr const double RAMP_MAX_RATE { 10.0 }; // 升温速率上限, °C/min
+constexpr const double RAMP_TARGET_TEMP { 600.0 }; // 升温终点, °C
+constexpr const double RAMP_HORIZON { 3600.0 }; // 推演时长, s
+constexpr const int RAMP_ITERATIONS { 12 }; // 二分次数, 分辨率RAMP_MAX_RATE / 2^12
+
+struct RampInput {
+    ThermalModel thermal;
+    LifeState life;
+};
+
+struct RampAdvice {
+    double rampRate { 0 }; // 建议升温速率, °C/min
+    double lifeConsumption { 0 }; // 按建议速率推演期内的寿命消耗
+    double minMargin { 0 }; // 按建议速率推演期内的最小热应力裕度
+    bool feasible { false }; // 保温(速率为0)时裕度是否满足限值
+};
+
+class RampAdvisor {
+private:
+    const double m_marginLimit;
+    const double m_maxRate;
+    const double m_targetTemp;
+    const double m_horizon;
+    const int m_iterations;
+    std::vector<RampInput> m_inputs;
+    std::vector<RampAdvice> m_advice;
+    // 构造时创建, 不继承实时模式下计算线程的SCHED_FIFO和绑核
+    std::unique_ptr<ThreadPool> m_pool;
+
+    RampAdvice simulate(const RampInput& input, double rate) const;
+    RampAdvice advise(const RampInput& input) const;
+
+public:
+    RampAdvisor(double marginLimit = RAMP_MARGIN_LIMIT, double maxRate = RAMP_MAX_RATE,
+        double targetTemp = RAMP_TARGET_TEMP, double horizon = RAMP_HORIZON, int iterations = RAMP_ITERATIONS);
+
+    // 快照缓冲区, 容量在首个周期后不再变化
+    std::vector<RampInput>& inputs() { return m_inputs; }
+    // 按线程池大小分块并行计算全部输入, 等待全部完成
+    const std::vector<RampAdvice>& run();
+};
+
+#endif // RAMPADVISOR_H
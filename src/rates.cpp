@@ -0,0 +1,144 @@
+#include "rates.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace {
+
+constexpr const double DEFAULT_PERIOD { TASK_INTERVAL / 1e6 };
+constexpr const double DEFAULT_PUBLISH_PERIOD { DEFAULT_PERIOD * MQTT_SEND_PERIOD };
+
+struct Periods {
+    double period;
+    double publish;
+    double life;
+    double control;
+};
+
+std::optional<Stage> parse_stage(const std::string& name)
+{
+    for (std::size_t i { 0 }; i < STAGE_NUM; ++i) {
+        const Stage stage { static_cast<Stage>(i) };
+        if (stage != Stage::rotor_message && name == CycleScheduler::stage_name(stage)) {
+            return stage;
+        }
+    }
+    return std::nullopt;
+}
+
+// 向上取整到base的倍数
+uint64_t round_up(uint64_t n, uint64_t base)
+{
+    return (n + base - 1) / base * base;
+}
+
+} // namespace
+
+Rate::Rate(uint64_t every, uint64_t phase)
+    : m_every { every }
+    , m_phase { every == 0 ? 0 : phase % every }
+    , m_next { every == 0 ? 0 : phase % every }
+{
+}
+
+bool Rate::due(uint64_t tick)
+{
+    if (m_every == 0 || tick < m_next) {
+        return false;
+    }
+    // 大于tick的第一个满足 t % every == phase 的节拍
+    m_next = tick + m_every - (tick + m_every - m_phase) % m_every;
+    return true;
+}
+
+json RateTable::default_config()
+{
+    return { { "default", { { "period", DEFAULT_PERIOD }, { "publishPeriod", DEFAULT_PUBLISH_PERIOD }, { "lifePeriod", 0 }, { "controlPeriod", CONTROL_PERIOD } } } };
+}
+
+std::optional<RateTable> RateTable::compile(const json& config, const std::vector<std::string>& names)
+{
+    RateTable table;
+
+    try {
+        const json defaults = config.value("default", json::object());
+        const Periods fallback {
+            defaults.value("period", DEFAULT_PERIOD),
+            defaults.value("publishPeriod", DEFAULT_PUBLISH_PERIOD),
+            defaults.value("lifePeriod", 0.0),
+            defaults.value("controlPeriod", CONTROL_PERIOD)
+        };
+
+        std::vector<Periods> periods;
+        double minPeriod { fallback.period };
+        for (std::size_t i { 0 }; i < names.size(); ++i) {
+            json rotor = json::object();
+            if (config.contains("rotors") && config["rotors"].contains(names[i])) {
+                rotor = config["rotors"][names[i]];
+            }
+            const Periods p {
+                rotor.value("period", fallback.period),
+                rotor.value("publishPeriod", fallback.publish),
+                rotor.value("lifePeriod", fallback.life),
+                rotor.value("controlPeriod", fallback.control)
+            };
+            if (!(p.period > 0) || !(p.publish > 0) || !(p.life >= 0) || !(p.control >= 0)) {
+                spdlog::error("Rates: invalid period of rotor {}", names[i]);
+                return std::nullopt;
+            }
+            minPeriod = i == 0 ? p.period : std::min(minPeriod, p.period);
+            periods.push_back(p);
+        }
+
+        const double tick { config.value("tick", minPeriod) };
+        if (!(tick > 0)) {
+            spdlog::error("Rates: invalid tick {}", tick);
+            return std::nullopt;
+        }
+        table.m_tick = std::chrono::microseconds(std::llround(tick * 1e6));
+
+        auto ticks = [tick](double period) {
+            return std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(period / tick - 1e-9)));
+        };
+
+        // 同一计算周期的转子依次错开一个节拍
+        std::map<uint64_t, uint64_t> phases;
+        for (std::size_t i { 0 }; i < names.size(); ++i) {
+            const uint64_t every { ticks(periods[i].period) };
+            const uint64_t phase { phases[every]++ % every };
+            const uint64_t lifeEvery { periods[i].life > 0 ? round_up(ticks(periods[i].life), every) : every };
+            const uint64_t controlEvery { periods[i].control > 0 ? round_up(ticks(periods[i].control), every) : 0 };
+            table.m_rotors.push_back({ Rate { every, phase }, Rate { round_up(ticks(periods[i].publish), every), phase },
+                Rate { lifeEvery, phase }, Rate { controlEvery, phase } });
+            if (std::fabs(every * tick - periods[i].period) > 1e-6) {
+                spdlog::warn("Rates: period {} of rotor {} rounded to {}", periods[i].period, names[i], every * tick);
+            }
+        }
+
+        table.m_stages[static_cast<std::size_t>(Stage::stream)] = Rate { ticks(fallback.period), 0 };
+        table.m_stages[static_cast<std::size_t>(Stage::archive)] = Rate { ticks(fallback.period), 0 };
+        table.m_stages[static_cast<std::size_t>(Stage::ramp_advice)] = Rate { ticks(fallback.period), 0 };
+        table.m_stages[static_cast<std::size_t>(Stage::uncertainty)] = Rate { ticks(UNCERTAINTY_PERIOD), 0 };
+        table.m_stages[static_cast<std::size_t>(Stage::unit_message)] = Rate { ticks(fallback.publish), 0 };
+        const json stages = config.value("stages", json::object());
+        for (const auto& [name, value] : stages.items()) {
+            const auto stage = parse_stage(name);
+            if (!stage) {
+                spdlog::error("Rates: unknown stage {}", name);
+                return std::nullopt;
+            }
+            const double period { value.get<double>() };
+            if (!(period > 0)) {
+                spdlog::error("Rates: invalid period of stage {}", name);
+                return std::nullopt;
+            }
+            table.m_stages[static_cast<std::size_t>(*stage)] = Rate { ticks(period), 0 };
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Rates: {}", e.what());
+        return std::nullopt;
+    }
+
+    return table;
+}
@@ -0,0 +1,70 @@
+#ifndef RATES_H
+#define RATES_H
+
+#include "scheduler.h"
+#include "utils.h"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+constexpr const long long TASK_INTERVAL { 5000000 }; // 默认采集/计算周期, 微秒
+constexpr const int MQTT_SEND_PERIOD { 20 }; // 默认发布周期, TASK_INTERVAL的倍数
+constexpr const double CONTROL_PERIOD { 60 }; // 默认控制字轮询周期, 秒
+constexpr const double UNCERTAINTY_PERIOD { 3600 }; // 默认寿命不确定性评估周期, 秒
+
+// 多速率调度. 主循环以基本节拍运行, 每个转子的采集/计算, 消息发布, 寿命保存以及汇总阶段
+// 各自以节拍的整数倍运行. 由可选的rates.json描述, 周期单位为秒, 均可省略:
+// {
+//     "tick": 1,                                                // 基本节拍, 默认取各转子计算周期的最小值
+//     "default": { "period": 5, "publishPeriod": 100, "lifePeriod": 0, "controlPeriod": 60 },
+//     "rotors": { "HP": { "period": 1, "publishPeriod": 10 } },
+//     "stages": { "stream": 5, "archive": 5, "rampAdvice": 5, "lifeUncertainty": 3600, "unitMessage": 100 }
+// }
+// period为读表面温度/推进温度场的周期; publishPeriod为TS<unit>/Rotor<name>的发布周期;
+// lifePeriod为寿命写回Redis的最短间隔, 0表示寿命每次变化都立即保存, 进程退出时最多丢失一个间隔的寿命累加;
+// controlPeriod为控制字轮询周期, 到期时与表面温度合并读取, 0表示不轮询, 只接受控制面(controlPlane.h)的命令.
+// 周期向上取整为节拍的倍数, 其余周期再取整为period的倍数, 保证发布和保存的都是本节拍刚计算的结果.
+// 同周期的转子按序号错开相位, 分散到不同节拍. stages中的键为Stage名, rotorMessage由各转子的publishPeriod决定
+
+// 以节拍计的周期, every为0时从不到期. 错过的节拍(周期超时)不补执行, 之后第一个节拍即到期
+class Rate {
+private:
+    uint64_t m_every { 1 };
+    uint64_t m_phase { 0 };
+    uint64_t m_next { 0 };
+
+public:
+    Rate() = default;
+    Rate(uint64_t every, uint64_t phase);
+
+    // 到期返回true并推进到下一个到期节拍
+    bool due(uint64_t tick);
+    uint64_t every() const { return m_every; }
+};
+
+struct RotorRates {
+    Rate step;
+    Rate publish;
+    Rate life; // 以下只在step到期的节拍上判断
+    Rate control;
+};
+
+class RateTable {
+private:
+    std::chrono::microseconds m_tick { TASK_INTERVAL };
+    std::vector<RotorRates> m_rotors;
+    std::array<Rate, STAGE_NUM> m_stages {};
+
+public:
+    static json default_config();
+    // 配置非法(周期非正, 未知阶段)时记录错误并返回空
+    static std::optional<RateTable> compile(const json& config, const std::vector<std::string>& names);
+
+    std::chrono::microseconds tick() const { return m_tick; }
+    RotorRates& rotor(std::size_t i) { return m_rotors[i]; }
+    bool stage_due(Stage stage, uint64_t tick) { return m_stages[static_cast<std::size_t>(stage)].due(tick); }
+};
+
+#endif // RATES_H
@@ -0,0 +1,245 @@
+#include "reactor.h"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+ThreadPool::ThreadPool(std::size_t size)
+{
+    for (std::size_t i { 0 }; i < std::max<std::size_t>(size, 1); ++i) {
+        m_workers.emplace_back([this]() {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cv.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+                    if (m_stop && m_jobs.empty()) {
+                        return;
+                    }
+                    job = std::move(m_jobs.front());
+                    m_jobs.pop_front();
+                }
+                job();
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.emplace_back(std::move(job));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn)
+{
+    // 工作线程可能在返回后才取出多余的任务, 计数放在堆上; 这些任务领取不到序号, 不会调用fn
+    struct Progress {
+        std::atomic<std::size_t> next { 0 };
+        std::atomic<std::size_t> done { 0 };
+    };
+    auto progress = std::make_shared<Progress>();
+    auto work = [progress, n, &fn]() {
+        for (std::size_t i { progress->next++ }; i < n; i = progress->next++) {
+            fn(i);
+            if (++progress->done == n) {
+                progress->done.notify_all();
+            }
+        }
+    };
+    for (std::size_t k { 1 }; k < std::min(n, m_workers.size() + 1); ++k) {
+        submit(work);
+    }
+    work();
+    for (std::size_t done { progress->done }; done < n; done = progress->done) {
+        progress->done.wait(done);
+    }
+}
+
+void ThreadPool::for_each_worker(const std::function<void(std::size_t)>& fn)
+{
+    // 每个工作线程各领取一个任务, 全部领取前互相等待, 保证fn在每个线程上恰好执行一次
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t arrived { 0 }, finished { 0 };
+    const std::size_t n { m_workers.size() };
+
+    for (std::size_t i { 0 }; i < n; ++i) {
+        submit([&, i]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++arrived;
+            cv.notify_all();
+            cv.wait(lock, [&]() { return arrived == n; });
+            lock.unlock();
+            fn(i);
+            lock.lock();
+            ++finished;
+            cv.notify_all();
+        });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() { return finished == n; });
+}
+
+Reactor::Reactor()
+    : m_epoll { ::epoll_create1(EPOLL_CLOEXEC) }
+    , m_wakeFd { ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) }
+{
+    if (m_epoll == -1 || m_wakeFd == -1) {
+        spdlog::error("Unable to create reactor: {}", std::strerror(errno));
+        std::terminate();
+    }
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &ev);
+}
+
+Reactor::~Reactor() noexcept
+{
+    ::close(m_wakeFd);
+    ::close(m_epoll);
+}
+
+void Reactor::arm(Waiter& waiter, uint32_t events, std::optional<Clock::duration> timeout)
+{
+    if (waiter.fd != -1) {
+        epoll_event ev {};
+        ev.events = events | EPOLLONESHOT;
+        ev.data.ptr = &waiter;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_MOD, waiter.fd, &ev) == -1
+            && (errno != ENOENT || ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, waiter.fd, &ev) == -1)) {
+            spdlog::warn("Unable to watch fd {}: {}", waiter.fd, std::strerror(errno));
+            post([&waiter]() { waiter.handle.resume(); });
+            return;
+        }
+    }
+    if (timeout) {
+        waiter.timerId = ++m_nextTimerId;
+        m_timers.push({ Clock::now() + *timeout, waiter.timerId });
+        m_timerWaiters[waiter.timerId] = &waiter;
+    }
+}
+
+void Reactor::disarm_fd(int fd)
+{
+    ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+Reactor::IoAwaiter Reactor::readable(int fd, std::optional<Clock::duration> timeout)
+{
+    return IoAwaiter { *this, fd, EPOLLIN | EPOLLRDHUP, timeout };
+}
+
+Reactor::IoAwaiter Reactor::writable(int fd, std::optional<Clock::duration> timeout)
+{
+    return IoAwaiter { *this, fd, EPOLLOUT, timeout };
+}
+
+Reactor::IoAwaiter Reactor::sleep_for(Clock::duration duration)
+{
+    return IoAwaiter { *this, -1, 0, duration };
+}
+
+void Reactor::post(std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        m_posted.emplace_back(std::move(fn));
+    }
+    const uint64_t one { 1 };
+    [[maybe_unused]] auto rc = ::write(m_wakeFd, &one, sizeof(one));
+}
+
+void Reactor::stop()
+{
+    post([this]() { m_stop = true; });
+}
+
+void Reactor::run_posted()
+{
+    std::vector<std::function<void()>> posted;
+    {
+        std::lock_guard<std::mutex> lock(m_postMutex);
+        posted.swap(m_posted);
+    }
+    for (auto& fn : posted) {
+        fn();
+    }
+}
+
+void Reactor::run_timers()
+{
+    const auto now = Clock::now();
+    while (!m_timers.empty() && m_timers.top().deadline <= now) {
+        const uint64_t id { m_timers.top().id };
+        m_timers.pop();
+        auto it = m_timerWaiters.find(id);
+        if (it == m_timerWaiters.end()) {
+            continue; // fd已先就绪
+        }
+        Waiter* waiter = it->second;
+        m_timerWaiters.erase(it);
+        if (waiter->fd != -1) {
+            disarm_fd(waiter->fd);
+        }
+        waiter->ready = waiter->fd == -1; // 定时等待视为就绪, fd等待视为超时
+        waiter->handle.resume();
+    }
+}
+
+int Reactor::next_timeout() const
+{
+    if (m_timers.empty()) {
+        return -1;
+    }
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(m_timers.top().deadline - Clock::now());
+    return static_cast<int>(std::max<long long>(wait.count(), 0));
+}
+
+void Reactor::run()
+{
+    std::array<epoll_event, 256> events;
+
+    while (!m_stop) {
+        const int n = ::epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()), next_timeout());
+        if (n == -1 && errno != EINTR) {
+            spdlog::error("Reactor epoll_wait failed: {}", std::strerror(errno));
+            break;
+        }
+        for (int i { 0 }; i < n; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                uint64_t value;
+                [[maybe_unused]] auto rc = ::read(m_wakeFd, &value, sizeof(value));
+                continue;
+            }
+            auto* waiter = static_cast<Waiter*>(events[i].data.ptr);
+            if (waiter->timerId != 0) {
+                m_timerWaiters.erase(waiter->timerId);
+            }
+            waiter->ready = true;
+            waiter->handle.resume();
+        }
+        run_timers();
+        run_posted();
+    }
+}
@@ -0,0 +1,405 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "spdlog/spdlog.h"
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 单线程epoll反应器与C++20协程. 所有协程在反应器线程上恢复, 阻塞或计算工作通过offload交给线程池
+
+template <typename T = void>
+class Coro;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+        {
+            auto c = h.promise().continuation;
+            return c ? c : std::noop_coroutine();
+        }
+        void await_resume() noexcept { }
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Coro<T> get_return_object();
+    void return_value(T v) { value = std::move(v); }
+    T result()
+    {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Coro<void> get_return_object();
+    void return_void() { }
+    void result()
+    {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+} // namespace detail
+
+// 惰性协程, 被co_await时开始执行, 结束后恢复等待者
+template <typename T>
+class Coro {
+public:
+    using promise_type = detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit Coro(handle_type h)
+        : m_handle { h }
+    {
+    }
+    Coro(const Coro&) = delete;
+    Coro& operator=(const Coro&) = delete;
+    Coro(Coro&& other) noexcept
+        : m_handle { std::exchange(other.m_handle, nullptr) }
+    {
+    }
+    Coro& operator=(Coro&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+    ~Coro()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> c) noexcept
+    {
+        m_handle.promise().continuation = c;
+        return m_handle;
+    }
+    T await_resume() { return m_handle.promise().result(); }
+
+private:
+    handle_type m_handle;
+};
+
+namespace detail {
+
+template <typename T>
+Coro<T> Promise<T>::get_return_object()
+{
+    return Coro<T> { std::coroutine_handle<Promise<T>>::from_promise(*this) };
+}
+
+inline Coro<void> Promise<void>::get_return_object()
+{
+    return Coro<void> { std::coroutine_handle<Promise<void>>::from_promise(*this) };
+}
+
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept { }
+        void unhandled_exception() noexcept { }
+    };
+};
+
+} // namespace detail
+
+// 在当前线程启动协程且不等待其结果, 异常记录日志后丢弃
+inline detail::Detached spawn(Coro<void> task)
+{
+    try {
+        co_await task;
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from coroutine: {}", e.what());
+    }
+}
+
+class ThreadPool {
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop { false };
+
+public:
+    explicit ThreadPool(std::size_t size);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool() noexcept;
+
+    void submit(std::function<void()> job);
+    std::size_t size() const { return m_workers.size(); }
+    // 在调用线程和工作线程上执行fn(0), ..., fn(n - 1), 全部完成后返回.
+    // 调用线程也领取任务且不等待未开始的任务, 可以在工作线程上调用
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn);
+    // 对每个工作线程执行一次fn(index), 用于绑核/调度策略设置
+    void for_each_worker(const std::function<void(std::size_t)>& fn);
+};
+
+class Reactor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        int fd { -1 };
+        uint64_t timerId { 0 };
+        bool ready { false };
+    };
+
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t id;
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    int m_epoll { -1 };
+    int m_wakeFd { -1 };
+    bool m_stop { false };
+
+    std::mutex m_postMutex;
+    std::vector<std::function<void()>> m_posted;
+
+    uint64_t m_nextTimerId { 0 };
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    std::unordered_map<uint64_t, Waiter*> m_timerWaiters;
+
+    void arm(Waiter& waiter, uint32_t events, std::optional<Clock::duration> timeout);
+    void disarm_fd(int fd);
+    void run_posted();
+    void run_timers();
+    int next_timeout() const;
+
+public:
+    Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+    ~Reactor() noexcept;
+
+    void run();
+    // 可在任意线程调用
+    void stop();
+    void post(std::function<void()> fn);
+
+    // co_await后返回true表示fd就绪, false表示超时
+    class IoAwaiter {
+    private:
+        Reactor& m_reactor;
+        uint32_t m_events;
+        std::optional<Clock::duration> m_timeout;
+        Waiter m_waiter;
+
+    public:
+        IoAwaiter(Reactor& reactor, int fd, uint32_t events, std::optional<Clock::duration> timeout)
+            : m_reactor { reactor }
+            , m_events { events }
+            , m_timeout { timeout }
+        {
+            m_waiter.fd = fd;
+        }
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            m_waiter.handle = h;
+            m_reactor.arm(m_waiter, m_events, m_timeout);
+        }
+        bool await_resume() const noexcept { return m_waiter.ready; }
+    };
+
+    IoAwaiter readable(int fd, std::optional<Clock::duration> timeout = std::nullopt);
+    IoAwaiter writable(int fd, std::optional<Clock::duration> timeout = std::nullopt);
+    IoAwaiter sleep_for(Clock::duration duration);
+    // fd关闭前调用, 从epoll中移除
+    void forget(int fd) { disarm_fd(fd); }
+
+    // 把基于回调的异步接口包装为可co_await的对象, 回调可在任意线程调用, 协程在反应器线程恢复
+    template <typename T>
+    class CallbackAwaiter {
+    private:
+        Reactor& m_reactor;
+        std::function<void(std::function<void(T)>)> m_start;
+        std::optional<T> m_value;
+
+    public:
+        CallbackAwaiter(Reactor& reactor, std::function<void(std::function<void(T)>)> start)
+            : m_reactor { reactor }
+            , m_start { std::move(start) }
+        {
+        }
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            m_start([this, h](T value) {
+                m_reactor.post([this, h, value = std::move(value)]() mutable {
+                    m_value = std::move(value);
+                    h.resume();
+                });
+            });
+        }
+        T await_resume() { return std::move(*m_value); }
+    };
+
+    template <typename T>
+    CallbackAwaiter<T> await_callback(std::function<void(std::function<void(T)>)> start)
+    {
+        return CallbackAwaiter<T> { *this, std::move(start) };
+    }
+
+    // 在线程池中执行fn, 完成后在反应器线程恢复协程并返回fn的结果
+    template <typename F, typename R = std::invoke_result_t<F>>
+    class OffloadAwaiter {
+    private:
+        using Stored = std::conditional_t<std::is_void_v<R>, bool, R>;
+        Reactor& m_reactor;
+        ThreadPool& m_pool;
+        F m_fn;
+        std::optional<Stored> m_value;
+        std::exception_ptr m_error;
+
+    public:
+        OffloadAwaiter(Reactor& reactor, ThreadPool& pool, F fn)
+            : m_reactor { reactor }
+            , m_pool { pool }
+            , m_fn { std::move(fn) }
+        {
+        }
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            m_pool.submit([this, h]() {
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        m_fn();
+                        m_value = true;
+                    } else {
+                        m_value = m_fn();
+                    }
+                } catch (...) {
+                    m_error = std::current_exception();
+                }
+                m_reactor.post([h]() { h.resume(); });
+            });
+        }
+        R await_resume()
+        {
+            if (m_error) {
+                std::rethrow_exception(m_error);
+            }
+            if constexpr (!std::is_void_v<R>) {
+                return std::move(*m_value);
+            }
+        }
+    };
+
+    template <typename F>
+    OffloadAwaiter<F> offload(ThreadPool& pool, F fn)
+    {
+        return OffloadAwaiter<F> { *this, pool, std::move(fn) };
+    }
+};
+
+// 等待一组协程全部完成, 只在反应器线程上使用
+class WaitGroup {
+private:
+    std::size_t m_count { 0 };
+    std::coroutine_handle<> m_waiter;
+
+public:
+    void add(std::size_t n = 1) { m_count += n; }
+    void done()
+    {
+        if (--m_count == 0 && m_waiter) {
+            std::exchange(m_waiter, nullptr).resume();
+        }
+    }
+
+    bool await_ready() const noexcept { return m_count == 0; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { m_waiter = h; }
+    void await_resume() const noexcept { }
+};
+
+// 协程互斥, 只在反应器线程上使用. 解锁时直接恢复下一个等待者
+class AsyncMutex {
+private:
+    bool m_locked { false };
+    std::deque<std::coroutine_handle<>> m_waiters;
+
+public:
+    class LockAwaiter {
+    private:
+        AsyncMutex& m_mutex;
+
+    public:
+        explicit LockAwaiter(AsyncMutex& mutex)
+            : m_mutex { mutex }
+        {
+        }
+        bool await_ready() const noexcept
+        {
+            if (!m_mutex.m_locked) {
+                m_mutex.m_locked = true;
+                return true;
+            }
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> h) { m_mutex.m_waiters.push_back(h); }
+        void await_resume() const noexcept { }
+    };
+
+    LockAwaiter lock() { return LockAwaiter { *this }; }
+    void unlock()
+    {
+        if (m_waiters.empty()) {
+            m_locked = false;
+            return;
+        }
+        auto next = m_waiters.front();
+        m_waiters.pop_front();
+        next.resume(); // 锁直接转交
+    }
+};
+
+#endif // REACTOR_H
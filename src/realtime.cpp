@@ -0,0 +1,185 @@
+#include "realtime.h"
+#include "myTrace.h"
+
+#include "spdlog/spdlog.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+std::vector<int> parse_cpu_list(const char* str)
+{
+    std::vector<int> cpus;
+    if (str == nullptr) {
+        return cpus;
+    }
+
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        try {
+            const auto dash = item.find('-');
+            if (dash == std::string::npos) {
+                cpus.emplace_back(std::stoi(item));
+            } else {
+                const int first { std::stoi(item.substr(0, dash)) };
+                const int last { std::stoi(item.substr(dash + 1)) };
+                for (int cpu { first }; cpu <= last; ++cpu) {
+                    cpus.emplace_back(cpu);
+                }
+            }
+        } catch (const std::exception&) {
+            spdlog::warn("Invalid cpu list item: {}", item);
+        }
+    }
+    return cpus;
+}
+
+RealtimeConfig load_realtime_config()
+{
+    RealtimeConfig config;
+    config.computeCpus = parse_cpu_list(std::getenv("RT_COMPUTE_CPUS"));
+    config.ioCpus = parse_cpu_list(std::getenv("RT_IO_CPUS"));
+    return config;
+}
+
+namespace {
+
+cpu_set_t to_cpu_set(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return set;
+}
+
+} // namespace
+
+bool set_thread_affinity(const std::vector<int>& cpus)
+{
+    if (cpus.empty()) {
+        return false;
+    }
+    const cpu_set_t set { to_cpu_set(cpus) };
+    const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        spdlog::warn("Unable to set thread affinity: {}", std::strerror(rc));
+        return false;
+    }
+    return true;
+}
+
+bool set_process_affinity(const std::vector<int>& cpus)
+{
+    if (cpus.empty()) {
+        return false;
+    }
+    const cpu_set_t set { to_cpu_set(cpus) };
+    bool ok { true };
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/proc/self/task", ec)) {
+        const pid_t tid = static_cast<pid_t>(std::atoi(entry.path().filename().c_str()));
+        if (sched_setaffinity(tid, sizeof(set), &set) == -1) {
+            spdlog::warn("Unable to set affinity of thread {}: {}", tid, std::strerror(errno));
+            ok = false;
+        }
+    }
+    if (ec) {
+        spdlog::warn("Unable to list threads: {}", ec.message());
+        return false;
+    }
+    return ok;
+}
+
+bool set_thread_realtime(int priority)
+{
+    sched_param param {};
+    param.sched_priority = priority;
+    const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        spdlog::warn("Unable to set SCHED_FIFO priority {}: {}", priority, std::strerror(rc));
+        return false;
+    }
+    return true;
+}
+
+bool set_thread_background()
+{
+    sched_param param {};
+    const int rc = pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    if (rc != 0) {
+        spdlog::warn("Unable to set SCHED_IDLE: {}", std::strerror(rc));
+        return false;
+    }
+    return true;
+}
+
+bool lock_memory()
+{
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+        spdlog::warn("Unable to lock memory: {}", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void prefault_stack(std::size_t size)
+{
+    volatile unsigned char* stack = static_cast<unsigned char*>(alloca(size));
+    const long page { sysconf(_SC_PAGESIZE) };
+    for (std::size_t i { 0 }; i < size; i += page) {
+        stack[i] = 0;
+    }
+}
+
+void prefault_heap(std::size_t size)
+{
+    // 关闭收缩后free不会归还, 后续分配直接复用这些已驻留的页
+    auto* heap = static_cast<unsigned char*>(std::malloc(size));
+    if (heap == nullptr) {
+        return;
+    }
+    const long page { sysconf(_SC_PAGESIZE) };
+    for (std::size_t i { 0 }; i < size; i += page) {
+        heap[i] = 0;
+    }
+    std::free(heap);
+}
+
+void LatencyMonitor::record_step(std::chrono::nanoseconds elapsed)
+{
+    const int64_t ns { elapsed.count() };
+    int64_t cur { m_stepMaxNs.load(std::memory_order_relaxed) };
+    while (ns > cur && !m_stepMaxNs.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) { }
+}
+
+void LatencyMonitor::record_cycle(long long count, std::chrono::microseconds wake, std::chrono::microseconds cycle)
+{
+    m_windowWakeMaxUs = std::max<int64_t>(m_windowWakeMaxUs, wake.count());
+    m_windowCycleMaxUs = std::max<int64_t>(m_windowCycleMaxUs, cycle.count());
+    m_wakeMaxUs = std::max(m_wakeMaxUs, m_windowWakeMaxUs);
+    m_cycleMaxUs = std::max(m_cycleMaxUs, m_windowCycleMaxUs);
+
+    trace(TraceLevel::info, TraceEvent::cycle_latency,
+        CycleLatencyPayload { count, wake.count(), cycle.count(), m_stepMaxNs.load(std::memory_order_relaxed) });
+
+    if (++m_cycles % RT_REPORT_PERIOD == 0) {
+        spdlog::info("Cycle latency over last {} cycles: wake max {} us, cycle max {} us, step max {} us; worst wake {} us, worst cycle {} us",
+            RT_REPORT_PERIOD, m_windowWakeMaxUs, m_windowCycleMaxUs, m_stepMaxNs.exchange(0, std::memory_order_relaxed) / 1000,
+            m_wakeMaxUs, m_cycleMaxUs);
+        m_windowWakeMaxUs = 0;
+        m_windowCycleMaxUs = 0;
+    }
+}
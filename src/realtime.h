@@ -0,0 +1,60 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 实时模式: 计算线程SCHED_FIFO并绑定到独立核, I/O线程(日志/Modbus服务端/paho/反应器)绑定到其余核,
+// 启动时锁定并预取内存, 运行中统计唤醒延迟与计算耗时的最坏值
+
+constexpr const int RT_PRIORITY { 80 };
+constexpr const std::size_t RT_STACK_PREFAULT { 512 * 1024 };
+constexpr const std::size_t RT_HEAP_PREFAULT { 64 * 1024 * 1024 };
+constexpr const long long RT_REPORT_PERIOD { 720 }; // 周期数
+
+struct RealtimeConfig {
+    std::vector<int> computeCpus;
+    std::vector<int> ioCpus;
+    int priority { RT_PRIORITY };
+};
+
+// "2,3,6-7" -> {2, 3, 6, 7}, 非法项忽略
+std::vector<int> parse_cpu_list(const char* str);
+// 从RT_COMPUTE_CPUS/RT_IO_CPUS读取, 未设置时为空
+RealtimeConfig load_realtime_config();
+
+// 以下函数失败时记录警告并返回false, 进程继续以普通模式运行
+bool set_thread_affinity(const std::vector<int>& cpus);
+// 对进程内已有的全部线程设置亲和性, 之后创建的线程从创建者继承
+bool set_process_affinity(const std::vector<int>& cpus);
+bool set_thread_realtime(int priority);
+// SCHED_IDLE: 只在CPU空闲时运行, 用于不得影响主循环的后台计算
+bool set_thread_background();
+// mlockall并关闭堆收缩与大块mmap分配, 使释放的内存仍保持驻留
+bool lock_memory();
+// 触碰当前线程栈和一块堆内存, 使其在进入循环前全部缺页完毕
+void prefault_stack(std::size_t size = RT_STACK_PREFAULT);
+void prefault_heap(std::size_t size = RT_HEAP_PREFAULT);
+
+// 周期延迟统计. record_step可在任意线程调用, record_cycle只在循环线程调用, 每RT_REPORT_PERIOD个周期写一次日志
+class LatencyMonitor {
+private:
+    std::atomic<int64_t> m_stepMaxNs { 0 };
+    int64_t m_wakeMaxUs { 0 };
+    int64_t m_cycleMaxUs { 0 };
+    int64_t m_windowWakeMaxUs { 0 };
+    int64_t m_windowCycleMaxUs { 0 };
+    long long m_cycles { 0 };
+
+public:
+    void record_step(std::chrono::nanoseconds elapsed);
+    // wake: 实际唤醒时刻与计划时刻之差, cycle: 本周期工作耗时
+    void record_cycle(long long count, std::chrono::microseconds wake, std::chrono::microseconds cycle);
+    int64_t worst_wake_us() const { return m_wakeMaxUs; }
+    int64_t worst_cycle_us() const { return m_cycleMaxUs; }
+};
+
+#endif // REALTIME_H
@@ -0,0 +1,240 @@
+#include "registerMap.h"
+#include "Rotor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr const std::size_t DEFAULT_STRIDE { 37 };
+
+const char* const SOURCE_NAMES[] {
+    "lifeRatio",
+    "overhaulLifeRatio",
+    "alert",
+    "ts",
+    "t0",
+    "centerThermalStress",
+    "surfaceThermalStress",
+    "thermalStress",
+    "thermalStressMargin"
+};
+
+std::optional<std::size_t> parse_source(const std::string& field)
+{
+    for (std::size_t i { 0 }; i < std::size(SOURCE_NAMES); ++i) {
+        if (field == SOURCE_NAMES[i]) {
+            return i;
+        }
+    }
+    // temperature[k]
+    const std::string prefix { "temperature[" };
+    if (field.size() > prefix.size() + 1 && field.compare(0, prefix.size(), prefix) == 0 && field.back() == ']') {
+        try {
+            std::size_t pos {};
+            const std::string index { field.substr(prefix.size(), field.size() - prefix.size() - 1) };
+            const int k { std::stoi(index, &pos) };
+            if (pos == index.size() && k >= 0 && static_cast<std::size_t>(k) < FIELD_OUTPUT_NUM) {
+                return static_cast<std::size_t>(RegisterSource::temperature) + k;
+            }
+        } catch (const std::exception&) {
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<RegisterType> parse_type(const std::string& type)
+{
+    if (type == "u16") {
+        return RegisterType::u16;
+    } else if (type == "i16") {
+        return RegisterType::i16;
+    } else if (type == "u32") {
+        return RegisterType::u32;
+    } else if (type == "i32") {
+        return RegisterType::i32;
+    } else if (type == "f32") {
+        return RegisterType::f32;
+    }
+    return std::nullopt;
+}
+
+std::size_t width(RegisterType type)
+{
+    return type == RegisterType::u16 || type == RegisterType::i16 ? 1 : 2;
+}
+
+template <typename T>
+T to_integer(double value)
+{
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+    const double rounded { std::round(value) };
+    if (rounded <= static_cast<double>(std::numeric_limits<T>::min())) {
+        return std::numeric_limits<T>::min();
+    }
+    if (rounded >= static_cast<double>(std::numeric_limits<T>::max())) {
+        return std::numeric_limits<T>::max();
+    }
+    return static_cast<T>(rounded);
+}
+
+std::optional<std::size_t> rotor_base(const json& config, const std::string& name, std::size_t index, std::size_t stride)
+{
+    if (config.contains("rotors") && config["rotors"].contains(name)) {
+        return config["rotors"][name].get<std::size_t>();
+    }
+    try {
+        std::size_t pos {};
+        const int n { std::stoi(name, &pos) };
+        if (pos == name.size()) {
+            if (n < 1) {
+                return std::nullopt;
+            }
+            return stride * static_cast<std::size_t>(n - 1);
+        }
+    } catch (const std::exception&) {
+    }
+    return stride * index;
+}
+
+} // namespace
+
+RegisterValues pack_register_values(const RotorState& state)
+{
+    RegisterValues values {
+        state.lifeRatio,
+        state.overhaulLifeRatio,
+        static_cast<double>(state.alert),
+        state.ts,
+        state.t0,
+        state.centerThermalStress,
+        state.surfaceThermalStress,
+        state.thermalStress,
+        state.thermalStressMargin
+    };
+    std::copy(state.temperature.begin(), state.temperature.end(), values.begin() + static_cast<std::size_t>(RegisterSource::temperature));
+    return values;
+}
+
+json RegisterMap::default_config()
+{
+    json fields = json::array();
+    fields.push_back({ { "field", "alert" }, { "offset", 0 }, { "type", "u16" } });
+    std::size_t offset { 1 };
+    for (const char* field : { "centerThermalStress", "lifeRatio", "overhaulLifeRatio", "surfaceThermalStress",
+             "t0", "thermalStress", "thermalStressMargin", "ts" }) {
+        fields.push_back({ { "field", field }, { "offset", offset }, { "type", "f32" } });
+        offset += 2;
+    }
+    for (std::size_t k { 0 }; k < FIELD_OUTPUT_NUM; ++k) {
+        fields.push_back({ { "field", "temperature[" + std::to_string(k) + "]" }, { "offset", offset }, { "type", "f32" } });
+        offset += 2;
+    }
+    return { { "stride", DEFAULT_STRIDE }, { "fields", fields } };
+}
+
+std::optional<RegisterMap> RegisterMap::compile(const json& config, const std::vector<std::string>& names, std::size_t registerCount)
+{
+    RegisterMap map;
+    map.m_rotors = names.size();
+
+    try {
+        const std::size_t stride { config.value("stride", DEFAULT_STRIDE) };
+
+        struct Field {
+            std::size_t offset;
+            std::size_t source;
+            RegisterType type;
+            bool highFirst;
+            double scale;
+        };
+        std::vector<Field> fields;
+        for (const auto& f : config.at("fields")) {
+            const std::string name { f.at("field").get<std::string>() };
+            const auto source = parse_source(name);
+            if (!source) {
+                spdlog::error("Register map: unknown field {}", name);
+                return std::nullopt;
+            }
+            const auto type = parse_type(f.value("type", std::string { "f32" }));
+            if (!type) {
+                spdlog::error("Register map: unknown type of field {}", name);
+                return std::nullopt;
+            }
+            const std::string order { f.value("order", std::string { "low_first" }) };
+            if (order != "low_first" && order != "high_first") {
+                spdlog::error("Register map: unknown word order {} of field {}", order, name);
+                return std::nullopt;
+            }
+            fields.push_back({ f.at("offset").get<std::size_t>(), *source, *type, order == "high_first", f.value("scale", 1.0) });
+        }
+
+        std::vector<bool> used(registerCount, false);
+        for (std::size_t i { 0 }; i < names.size(); ++i) {
+            const auto base = rotor_base(config, names[i], i, stride);
+            if (!base) {
+                spdlog::error("Register map: no base address for rotor {}", names[i]);
+                return std::nullopt;
+            }
+            for (const auto& f : fields) {
+                const std::size_t reg { *base + f.offset };
+                const std::size_t n { width(f.type) };
+                if (reg + n > registerCount) {
+                    spdlog::error("Register map: rotor {} field at {} exceeds {} registers", names[i], reg, registerCount);
+                    return std::nullopt;
+                }
+                for (std::size_t r { reg }; r < reg + n; ++r) {
+                    if (used[r]) {
+                        spdlog::error("Register map: rotor {} overlaps at register {}", names[i], r);
+                        return std::nullopt;
+                    }
+                    used[r] = true;
+                }
+                map.m_ops.push_back({ static_cast<uint32_t>(reg), static_cast<uint16_t>(i), static_cast<uint8_t>(f.source),
+                    f.type, f.highFirst, f.scale });
+                map.m_registers = std::max(map.m_registers, reg + n);
+            }
+        }
+    } catch (const std::exception& e) {
+        spdlog::error("Register map: {}", e.what());
+        return std::nullopt;
+    }
+
+    // 按地址排序, 写入时顺序访问寄存器表
+    std::sort(map.m_ops.begin(), map.m_ops.end(), [](const Op& a, const Op& b) { return a.reg < b.reg; });
+    return map;
+}
+
+void RegisterMap::write(uint16_t* registers, const RegisterValues* values) const
+{
+    for (const auto& op : m_ops) {
+        const double value { values[op.rotor][op.source] * op.scale };
+        uint32_t bits;
+        switch (op.type) {
+        case RegisterType::u16:
+            registers[op.reg] = to_integer<uint16_t>(value);
+            continue;
+        case RegisterType::i16:
+            registers[op.reg] = static_cast<uint16_t>(to_integer<int16_t>(value));
+            continue;
+        case RegisterType::u32:
+            bits = to_integer<uint32_t>(value);
+            break;
+        case RegisterType::i32:
+            bits = static_cast<uint32_t>(to_integer<int32_t>(value));
+            break;
+        default: {
+            const float f { static_cast<float>(value) };
+            std::memcpy(&bits, &f, sizeof(f));
+        }
+        }
+        const uint16_t low { static_cast<uint16_t>(bits & 0xFFFF) };
+        const uint16_t high { static_cast<uint16_t>(bits >> 16) };
+        registers[op.reg] = op.highFirst ? high : low;
+        registers[op.reg + 1] = op.highFirst ? low : high;
+    }
+}
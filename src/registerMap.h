@@ -0,0 +1,83 @@
+#ifndef REGISTERMAP_H
+#define REGISTERMAP_H
+
+#include "thermalModel.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct RotorState;
+
+// Modbus保持寄存器映射. 由声明式配置(register_map.json)描述每个转子的字段布局, 启动时编译为
+// 扁平的写操作表, 每周期由RegisterMap::write一次写入所有转子, 不做json或字符串处理.
+//
+// 配置格式, 除fields外均可省略:
+// {
+//     "stride": 37,                  // 转子间隔; 未在rotors中列出的转子, 名称为整数n时基址为stride*(n-1), 否则为stride*序号
+//     "rotors": { "HP": 0 },         // 指定转子基址
+//     "fields": [
+//         { "field": "alert", "offset": 0, "type": "u16" },
+//         { "field": "temperature[0]", "offset": 17, "type": "f32", "order": "low_first", "scale": 1.0 }
+//     ]
+// }
+// field为RotorState的成员名, temperature用下标; type为u16/i16/u32/i32/f32; order为32位类型的字序,
+// low_first(默认, 与原实现一致)或high_first; 写入值为value*scale, 整数类型四舍五入并截断到类型范围
+
+enum class RegisterSource : uint8_t {
+    lifeRatio,
+    overhaulLifeRatio,
+    alert,
+    ts,
+    t0,
+    centerThermalStress,
+    surfaceThermalStress,
+    thermalStress,
+    thermalStressMargin,
+    temperature // 后接FIELD_OUTPUT_NUM个
+};
+
+constexpr const std::size_t REGISTER_SOURCE_NUM { static_cast<std::size_t>(RegisterSource::temperature) + FIELD_OUTPUT_NUM };
+
+// 一个转子本周期的全部输出值, 按RegisterSource排列
+using RegisterValues = std::array<double, REGISTER_SOURCE_NUM>;
+
+RegisterValues pack_register_values(const RotorState& state);
+
+enum class RegisterType : uint8_t {
+    u16,
+    i16,
+    u32,
+    i32,
+    f32
+};
+
+class RegisterMap {
+private:
+    struct Op {
+        uint32_t reg;
+        uint16_t rotor;
+        uint8_t source;
+        RegisterType type;
+        bool highFirst;
+        double scale;
+    };
+
+    std::vector<Op> m_ops;
+    std::size_t m_rotors { 0 };
+    std::size_t m_registers { 0 }; // 用到的最大地址+1
+
+public:
+    // 与原37寄存器布局一致的默认配置
+    static json default_config();
+    // 配置非法(未知字段/类型, 越界, 重叠)时记录错误并返回空
+    static std::optional<RegisterMap> compile(const json& config, const std::vector<std::string>& names, std::size_t registerCount);
+
+    // values[i]对应names[i]
+    void write(uint16_t* registers, const RegisterValues* values) const;
+    std::size_t rotors() const { return m_rotors; }
+    std::size_t registers() const { return m_registers; }
+};
+
+#endif // REGISTERMAP_H
@@ -0,0 +1,30 @@
+#include "rotorRegistry.h"
+
+RotorRegistry::RotorRegistry(const std::vector<std::string>& names, const std::string& unit, const std::vector<Parameters>& paraList,
+    const std::vector<int>& controlWords, std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli,
+    std::vector<std::unique_ptr<MyModbusClient>>&& modbusClis)
+    : m_parameters(paraList.begin(), paraList.begin() + names.size())
+{
+    // 先确定容量, 之后的emplace_back不会重新分配, 已取得的引用和span一直有效
+    std::size_t sectionNum { 0 };
+    for (const auto& para : m_parameters) {
+        sectionNum += 1 + para.sections.size();
+    }
+    m_sections.reserve(sectionNum);
+    m_firstSection.reserve(names.size());
+    for (const auto& para : m_parameters) {
+        m_firstSection.push_back(m_sections.size());
+        m_sections.emplace_back("main", 0, para);
+        for (const auto& section : para.sections) {
+            m_sections.emplace_back(section.name, section.surfaceRegister, section.para);
+        }
+    }
+
+    m_rotors.reserve(names.size());
+    for (std::size_t i { 0 }; i < names.size(); ++i) {
+        const std::size_t first { m_firstSection[i] };
+        const std::size_t count { (i + 1 < names.size() ? m_firstSection[i + 1] : m_sections.size()) - first };
+        m_rotors.emplace_back(names[i], unit, m_parameters[i], controlWords[i], std::span<RotorSection>(m_sections).subspan(first, count),
+            redis, MQTTCli, std::move(modbusClis[i]));
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef ROTORREGISTRY_H
+#define ROTORREGISTRY_H
+
+#include "Rotor.h"
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// 转子在机组中的序号, 与names/paraList/寄存器映射的顺序一致, 在Task的生存期内不变
+using RotorHandle = std::size_t;
+
+// 一台机组所有转子的存储, 构造时一次分配, 之后不增删, 元素不移动:
+// - 参数: 复制调用者的paraList, 转子与截面引用这里的副本, 不再依赖调用者的vector
+//   (曲线仍指向MaterialLibrary, 库须比注册表活得久)
+// - 热数据: 所有转子的截面(温度场/应力/寿命)按句柄顺序连续存放, 逐周期的计算和批量引擎顺序访问
+// - 冷数据: Rotor对象(名称, Redis/MQTT/Modbus客户端, 周期状态), 只持有指向自己截面的span
+class RotorRegistry {
+private:
+    std::vector<Parameters> m_parameters;
+    std::vector<RotorSection> m_sections;
+    std::vector<std::size_t> m_firstSection; // 各转子的第一个截面在m_sections中的位置
+    std::vector<Rotor> m_rotors;
+
+public:
+    // modbusClis中的元素可为空, 见Task
+    RotorRegistry(const std::vector<std::string>& names, const std::string& unit, const std::vector<Parameters>& paraList,
+        const std::vector<int>& controlWords, std::shared_ptr<MyRedis> redis, std::shared_ptr<MyMQTT> MQTTCli,
+        std::vector<std::unique_ptr<MyModbusClient>>&& modbusClis);
+    RotorRegistry(const RotorRegistry&) = delete;
+    RotorRegistry& operator=(const RotorRegistry&) = delete;
+
+    std::size_t size() const { return m_rotors.size(); }
+    Rotor& operator[](RotorHandle h) { return m_rotors[h]; }
+    const Rotor& operator[](RotorHandle h) const { return m_rotors[h]; }
+    const Parameters& parameters(RotorHandle h) const { return m_parameters[h]; }
+
+    // 截面多的转子在pool上分块推进, 见Rotor::set_pool
+    void set_pool(ThreadPool* pool)
+    {
+        for (auto& rotor : m_rotors) {
+            rotor.set_pool(pool);
+        }
+    }
+    // 截面数最多的转子的截面数
+    std::size_t max_section_count() const
+    {
+        std::size_t res { 0 };
+        for (const auto& rotor : m_rotors) {
+            res = std::max(res, rotor.section_count());
+        }
+        return res;
+    }
+
+    // 所有转子的截面, 按句柄顺序, 同一转子的截面相邻
+    std::span<RotorSection> sections() { return m_sections; }
+    std::span<const RotorSection> sections() const { return m_sections; }
+    // 转子h的截面在sections()中的起始位置
+    std::size_t first_section(RotorHandle h) const { return m_firstSection[h]; }
+};
+
+#endif // ROTORREGISTRY_H
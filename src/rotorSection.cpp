@@ -0,0 +1,29 @@
+#include "rotorSection.h"
+
+RotorSection::RotorSection(const std::string& name, std::size_t surfaceRegister, const Parameters& para)
+    : name { name }
+    , surfaceRegister { surfaceRegister }
+    , para { para }
+    , thermal { para }
+    , history { para }
+{
+}
+
+bool RotorSection::step(double dt, double end)
+{
+    const double stableDt { thermal.stable_dt() };
+    const int substeps { dt > stableDt ? static_cast<int>(std::ceil(dt / stableDt)) : 1 };
+    bool changed { false };
+    std::visit([&](auto& kernel) {
+        for (int k { 0 }; k < substeps; ++k) {
+            kernel.temp_field(dt / substeps);
+            stress = kernel.thermal_stress();
+            if (recordHistory) {
+                history.record(end - dt + dt * (k + 1) / substeps, stress.thermalStress, kernel.average_temp());
+            }
+            changed = kernel.life(stress.thermalStress, life) > 0 || changed;
+        }
+    },
+        thermal.kernel());
+    return changed;
+}
@@ -0,0 +1,29 @@
+#ifndef ROTORSECTION_H
+#define ROTORSECTION_H
+
+#include "lifeUncertainty.h"
+#include "thermalModel.h"
+#include <string>
+
+constexpr const std::size_t SECTION_PARALLEL_MIN { 64 }; // 一个转子的截面数不少于此值时分块并行推进
+
+// 转子的一个危险截面, 截面0由转子本身的参数描述, 其余来自Parameters::sections.
+// 各截面的温度场, 应力, 寿命和应力历程相互独立, 只共享转子的采集周期
+struct RotorSection {
+    const std::string name;
+    const std::size_t surfaceRegister; // 表面温度寄存器块内的序号, 截面0使用整个块
+    const Parameters& para;
+    ThermalModel thermal;
+    StressState stress;
+    LifeState life;
+    StressHistory history;
+    bool recordHistory { false }; // 记录应力历程, 只在LIFE_UNCERTAINTY时由Task打开
+
+    RotorSection(const std::string& name, std::size_t surfaceRegister, const Parameters& para);
+
+    // 推进dt秒, 超过稳定步长时等分为子步, 每个子步都计算应力并计入寿命, 不漏掉子步之间的应力峰值.
+    // 所有子步在同一个内核实例上完成, 只分派一次. end为本步结束的时刻(steady_seconds). 返回寿命是否变化
+    bool step(double dt, double end);
+};
+
+#endif // ROTORSECTION_H
@@ -0,0 +1,57 @@
+#include "rotorStream.h"
+
+#include <cmath>
+
+namespace {
+
+void append_number(std::string& out, double value)
+{
+    if (std::isfinite(value)) {
+        fmt::format_to(std::back_inserter(out), "{}", value);
+    }
+}
+
+} // namespace
+
+RotorStream::RotorStream(const std::string& unit)
+    : m_key { "TS" + unit + ":Mechanism:RotorStream" }
+{
+}
+
+void RotorStream::clear()
+{
+    m_count = 0;
+}
+
+void RotorStream::add(long long count, const std::string& name, const RotorState& state)
+{
+    if (m_count == m_entries.size()) {
+        m_entries.emplace_back(MyRedis::StreamFields { { "c", "" }, { "n", "" }, { "d", "" } });
+    }
+    auto& fields = m_entries[m_count++];
+    fields[0].second = std::to_string(count);
+    fields[1].second = name;
+
+    std::string& d = fields[2].second;
+    d.clear();
+    for (double value : { state.lifeRatio, state.overhaulLifeRatio, static_cast<double>(state.alert), state.ts, state.t0,
+             state.centerThermalStress, state.surfaceThermalStress, state.thermalStress, state.thermalStressMargin }) {
+        append_number(d, value);
+        d.push_back(',');
+    }
+    for (std::size_t i { 0 }; i < state.temperature.size(); ++i) {
+        if (i != 0) {
+            d.push_back(',');
+        }
+        append_number(d, state.temperature[i]);
+    }
+}
+
+void RotorStream::flush(MyRedis& redis)
+{
+    if (m_count == 0) {
+        return;
+    }
+    redis.m_xadd_batch(m_key, m_entries.data(), m_entries.data() + m_count, REDIS_STREAM_MAXLEN);
+    m_count = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef ROTORSTREAM_H
+#define ROTORSTREAM_H
+
+#include "Rotor.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr const long long REDIS_STREAM_MAXLEN { 200000 }; // 近似上限, 约为20个转子1.4天的5秒样本
+
+// Redis Streams历史记录: 每台机组一个流TS<unit>:Mechanism:RotorStream, 每周期每个转子一条记录,
+// 一个周期的记录通过一次流水线写入. 记录字段:
+//   c: 循环计数
+//   n: 转子名
+//   d: 逗号分隔的lifeRatio,overhaulLifeRatio,alert,ts,t0,centerThermalStress,surfaceThermalStress,
+//      thermalStress,thermalStressMargin,temperature[0..9], 非有限值为空
+class RotorStream {
+private:
+    const std::string m_key;
+    std::vector<MyRedis::StreamFields> m_entries; // 复用, clear()不释放容量
+    std::size_t m_count { 0 };
+
+public:
+    explicit RotorStream(const std::string& unit);
+
+    void clear();
+    void add(long long count, const std::string& name, const RotorState& state);
+    // 一次往返写入本周期全部记录, 失败时记录日志并丢弃
+    void flush(MyRedis& redis);
+    const std::string& key() const { return m_key; }
+};
+
+#endif // ROTORSTREAM_H
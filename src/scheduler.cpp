@@ -0,0 +1,123 @@
+#include "scheduler.h"
+#include "myTrace.h"
+
+#include "nlohmann/json.hpp"
+#include "spdlog/spdlog.h"
+
+namespace {
+
+struct StageConfig {
+    const char* name;
+    double budgetUs; // 首次执行前的预计耗时
+    bool underLoad; // 上一周期超时时仍执行
+};
+
+constexpr const StageConfig STAGE_CONFIG[STAGE_NUM] {
+    { "registers", 100, true },
+    { "telemetry", 100, true },
+    { "live", 200, true },
+    { "rotorMessage", 20000, false },
+    { "unitMessage", 5000, false },
+    { "stream", 20000, false },
+    { "archive", 1000, false },
+    { "rampAdvice", 200000, false },
+    { "lifeUncertainty", 5000, false }
+};
+
+constexpr const double STAGE_EWMA_ALPHA { 0.2 };
+constexpr const double STAGE_SHED_DECAY { 0.9 };
+
+} // namespace
+
+CycleScheduler::CycleScheduler(Clock::duration interval)
+    : m_interval { interval }
+{
+    for (std::size_t i { 0 }; i < STAGE_NUM; ++i) {
+        m_stats.stages[i].avgUs = STAGE_CONFIG[i].budgetUs;
+    }
+}
+
+const char* CycleScheduler::stage_name(Stage stage)
+{
+    return STAGE_CONFIG[static_cast<std::size_t>(stage)].name;
+}
+
+void CycleScheduler::begin_cycle(Clock::time_point start)
+{
+    m_start = start;
+    m_deadline = start + m_interval;
+}
+
+bool CycleScheduler::admit(Stage stage, bool deferrable)
+{
+    const std::size_t i { static_cast<std::size_t>(stage) };
+    auto& s = m_stats.stages[i];
+
+    const auto estimate = std::chrono::microseconds(static_cast<int64_t>(s.avgUs));
+    const bool fits { Clock::now() + estimate <= m_deadline };
+    if (fits && (!m_overloaded || STAGE_CONFIG[i].underLoad)) {
+        return true;
+    }
+
+    if (deferrable) {
+        ++s.deferred;
+    } else {
+        ++s.shed;
+    }
+    // 偶发的一次慢执行不应让该阶段永远无法再被接纳
+    if (!fits) {
+        s.avgUs *= STAGE_SHED_DECAY;
+    }
+    return false;
+}
+
+void CycleScheduler::done(Stage stage, Clock::duration elapsed)
+{
+    auto& s = m_stats.stages[static_cast<std::size_t>(stage)];
+    const double us { std::chrono::duration<double, std::micro>(elapsed).count() };
+    s.avgUs = s.run++ == 0 ? us : s.avgUs + STAGE_EWMA_ALPHA * (us - s.avgUs);
+}
+
+CycleScheduler::Clock::time_point CycleScheduler::end_cycle(Clock::time_point now)
+{
+    ++m_stats.cycles;
+    const auto elapsed = now - m_start;
+    const int64_t elapsedUs { std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() };
+    m_stats.maxCycleUs = std::max(m_stats.maxCycleUs, elapsedUs);
+
+    m_overloaded = now > m_deadline;
+    if (!m_overloaded) {
+        ++m_tick;
+        return m_deadline;
+    }
+
+    // 已错过的周期边界直接放弃, 从下一个边界开始, 避免越积越多
+    ++m_stats.overruns;
+    const auto missed = (elapsed - m_interval) / m_interval + 1;
+    m_stats.skipped += static_cast<uint64_t>(missed);
+    m_tick += static_cast<uint64_t>(missed) + 1;
+    trace(TraceLevel::info, TraceEvent::cycle_overrun, CycleOverrunPayload { static_cast<int64_t>(m_stats.cycles), elapsedUs, static_cast<int64_t>(missed) });
+    if (m_stats.overruns == 1 || m_stats.overruns % 100 == 0) {
+        spdlog::warn("Cycle overrun: {} microseconds, {} overruns and {} skipped cycles so far", elapsedUs, m_stats.overruns, m_stats.skipped);
+    }
+    return m_start + (missed + 1) * m_interval;
+}
+
+std::string CycleScheduler::stats_json() const
+{
+    nlohmann::json j;
+    j["cycles"] = m_stats.cycles;
+    j["overruns"] = m_stats.overruns;
+    j["skipped"] = m_stats.skipped;
+    j["maxCycleUs"] = m_stats.maxCycleUs;
+    for (std::size_t i { 0 }; i < STAGE_NUM; ++i) {
+        const auto& s = m_stats.stages[i];
+        j["stages"][STAGE_CONFIG[i].name] = {
+            { "run", s.run },
+            { "shed", s.shed },
+            { "deferred", s.deferred },
+            { "avgUs", s.avgUs }
+        };
+    }
+    return j.dump();
+}
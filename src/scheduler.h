@@ -0,0 +1,75 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// 周期截止时间调度. 每个周期先执行关键阶段(控制字/温度场/应力/寿命/表面温度, 从不跳过),
+// 再按优先级依次执行可选阶段: 预计耗时超出本周期剩余时间, 或上一周期已超时时, 低优先级阶段被推迟或丢弃.
+// 超时后不追赶错过的周期, 直接对齐到下一个周期边界.
+
+// 按执行顺序排列, 越靠前优先级越高
+enum class Stage : uint8_t {
+    registers, // Modbus寄存器刷新
+    telemetry, // 共享内存
+    live, // 编辑器接口的/api/state与WebSocket推送
+    rotor_message, // 每转子MQTT消息
+    unit_message, // 整机MQTT消息
+    stream, // Redis Streams历史
+    archive, // 本地压缩归档
+    ramp_advice, // 升温速率建议
+    uncertainty, // 寿命不确定性评估, 计算在后台线程
+    count
+};
+
+constexpr const std::size_t STAGE_NUM { static_cast<std::size_t>(Stage::count) };
+
+struct StageStats {
+    uint64_t run { 0 };
+    uint64_t shed { 0 }; // 丢弃
+    uint64_t deferred { 0 }; // 推迟到下一周期
+    double avgUs { 0 }; // 耗时指数平均
+};
+
+struct SchedulerStats {
+    uint64_t cycles { 0 };
+    uint64_t overruns { 0 }; // 周期工作超过周期长度
+    uint64_t skipped { 0 }; // 因超时而跳过的周期边界
+    int64_t maxCycleUs { 0 };
+    std::array<StageStats, STAGE_NUM> stages {};
+};
+
+class CycleScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    const Clock::duration m_interval;
+    Clock::time_point m_start {};
+    Clock::time_point m_deadline {};
+    uint64_t m_tick { 0 };
+    bool m_overloaded { false };
+    SchedulerStats m_stats;
+
+public:
+    explicit CycleScheduler(Clock::duration interval);
+
+    static const char* stage_name(Stage stage);
+
+    void begin_cycle(Clock::time_point start);
+    // 可选阶段开始前调用, 返回false时不执行该阶段. deferrable为true的阶段计为推迟, 调用方保留其待办状态
+    bool admit(Stage stage, bool deferrable = false);
+    void done(Stage stage, Clock::duration elapsed);
+    // 返回下一个周期的开始时刻
+    Clock::time_point end_cycle(Clock::time_point now);
+
+    // 当前周期的节拍序号, 包括被跳过的周期边界
+    uint64_t tick() const { return m_tick; }
+    bool overloaded() const { return m_overloaded; }
+    const SchedulerStats& stats() const { return m_stats; }
+    std::string stats_json() const;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,295 @@
+#include "shard.h"
+
+#include <algorithm>
+
+namespace {
+
+// KEYS[1]: 心跳有序集合, KEYS[2]: 租约序号, KEYS[3..]: 各转子的租约. ARGV[1]: WORKER_ID, ARGV[2]: 有效期(毫秒), ARGV[3..]: 是否要持有该转子.
+// 租约的值为"<WORKER_ID>/<序号>", 每次获得时序号递增, 作为写入的防护令牌(FENCED_HMSET_SCRIPT).
+// 返回各转子的令牌, 不由本进程持有时为'0', 后接存活的进程. 使用服务器时间, 要求Redis 5及以上(脚本按效果复制)
+constexpr const char* LEASE_SCRIPT { R"(
+local t = redis.call('TIME')
+local now = tonumber(t[1]) * 1000 + math.floor(tonumber(t[2]) / 1000)
+local id, ttl = ARGV[1], tonumber(ARGV[2])
+redis.call('ZADD', KEYS[1], now + ttl, id)
+redis.call('ZREMRANGEBYSCORE', KEYS[1], '-inf', now)
+local res = {}
+for i = 3, #KEYS do
+    local owner = redis.call('GET', KEYS[i])
+    local want = ARGV[i] == '1'
+    local token = '0'
+    if owner and string.match(owner, '^(.*)/%d+$') == id then
+        if want then
+            redis.call('PEXPIRE', KEYS[i], ttl)
+            token = owner
+        else
+            redis.call('DEL', KEYS[i])
+        end
+    elseif not owner and want then
+        token = id .. '/' .. redis.call('INCR', KEYS[2])
+        redis.call('SET', KEYS[i], token, 'PX', ttl)
+    end
+    res[i - 2] = token
+end
+for _, w in ipairs(redis.call('ZRANGE', KEYS[1], 0, -1)) do
+    res[#res + 1] = w
+end
+return res
+)" };
+
+// KEYS[1]: 散列, KEYS[2..]: 各转子的租约. ARGV[1..n]: 各转子的令牌, ARGV[n+1..2n]: 各转子的字段数, 之后依次为各转子的字段/值.
+// 只写入租约的值仍为该令牌的转子的字段, 返回各转子是否写入('1'/'0')
+constexpr const char* FENCED_HMSET_SCRIPT { R"(
+local n = #KEYS - 1
+local pos = 2 * n + 1
+local res = {}
+for i = 1, n do
+    local count = tonumber(ARGV[n + i])
+    local written = redis.call('GET', KEYS[i + 1]) == ARGV[i]
+    if written and count > 0 then
+        redis.call('HSET', KEYS[1], unpack(ARGV, pos, pos + 2 * count - 1))
+    end
+    pos = pos + 2 * count
+    res[i] = written and '1' or '0'
+end
+return res
+)" };
+
+// FNV-1a后再混合一次, 使相近的名称(HP, HP#1, ...)在环上分散
+uint64_t ring_hash(const std::string& s)
+{
+    uint64_t h { 14695981039346656037ULL };
+    for (const unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+} // namespace
+
+ShardManager::ShardManager(const std::string& unit, const std::vector<std::string>& names, std::shared_ptr<MyRedis> redis, const std::string& workerId)
+    : m_unit { unit }
+    , m_names { names }
+    , m_redis { redis }
+    , m_workerId { workerId }
+    , m_held(names.size(), 0)
+    , m_releasing(names.size(), 0)
+    , m_handedOver(names.size(), 0)
+    , m_tokens(names.size())
+    , m_lastSync { std::chrono::steady_clock::now() }
+{
+    for (const auto& name : m_names) {
+        m_rotorHashes.emplace_back(ring_hash(m_unit + ":" + name));
+    }
+    spdlog::info("Sharding enabled, worker {}", m_workerId);
+    m_thread = std::thread([this]() { run(); });
+}
+
+ShardManager::~ShardManager() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+
+    // 有效期为0: 释放所有租约并立即移除心跳
+    std::vector<std::string> keys { "TS" + m_unit + ":Mechanism:Workers", epoch_key() };
+    std::vector<std::string> args { m_workerId, "0" };
+    for (std::size_t i { 0 }; i < m_names.size(); ++i) {
+        keys.emplace_back(lease_key(i));
+        args.emplace_back("0");
+    }
+    m_redis->m_eval(LEASE_SCRIPT, keys, args);
+}
+
+void ShardManager::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        lock.unlock();
+        sync();
+        lock.lock();
+        m_cv.wait_for(lock, std::chrono::milliseconds(LEASE_RENEW_PERIOD), [this]() { return m_stop; });
+    }
+}
+
+void ShardManager::sync()
+{
+    const std::size_t n { m_names.size() };
+    std::vector<std::string> keys { "TS" + m_unit + ":Mechanism:Workers", epoch_key() };
+    std::vector<std::string> args { m_workerId, std::to_string(LEASE_TTL) };
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 首次同步前不知道其它进程, 不获取任何转子
+        const std::vector<char> mine { m_workers.empty() ? std::vector<char>(n, 0) : assigned(m_workers) };
+        for (std::size_t i { 0 }; i < n; ++i) {
+            keys.emplace_back(lease_key(i));
+            if (m_held[i] && !mine[i] && !m_releasing[i] && !m_handedOver[i]) {
+                m_releasing[i] = true;
+                spdlog::info("Rotor {} moves to another worker, handing over", m_names[i]);
+            }
+            // 交接完成前继续续约
+            const bool want { m_held[i] ? !m_handedOver[i] : mine[i] != 0 };
+            args.emplace_back(want ? "1" : "0");
+        }
+    }
+
+    const auto result = m_redis->m_eval(LEASE_SCRIPT, keys, args);
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (result.size() < n) {
+        if (now - m_lastSync > std::chrono::milliseconds(LEASE_TTL)) {
+            spdlog::error("Lease sync failed for {} ms, dropping all rotors", LEASE_TTL);
+            lose_all();
+        }
+        return;
+    }
+    m_lastSync = now;
+
+    for (std::size_t i { 0 }; i < n; ++i) {
+        const bool held { result[i] != "0" };
+        if (held && !m_held[i]) {
+            m_changes.acquired.emplace_back(i);
+            spdlog::info("Acquired rotor {}", m_names[i]);
+        } else if (!held && m_held[i] && !m_handedOver[i]) {
+            // 租约已过期并被其它进程获得
+            lose(i);
+            spdlog::warn("Lost lease of rotor {}", m_names[i]);
+        }
+        m_held[i] = held;
+        m_tokens[i] = held ? result[i] : std::string();
+        if (!held) {
+            m_releasing[i] = false;
+            m_handedOver[i] = false;
+        }
+    }
+    m_workers.assign(result.begin() + n, result.end());
+}
+
+std::vector<char> ShardManager::assigned(const std::vector<std::string>& workers) const
+{
+    std::vector<std::pair<uint64_t, std::size_t>> ring;
+    ring.reserve(workers.size() * HASH_RING_VNODES);
+    for (std::size_t w { 0 }; w < workers.size(); ++w) {
+        for (int v { 0 }; v < HASH_RING_VNODES; ++v) {
+            ring.emplace_back(ring_hash(workers[w] + "#" + std::to_string(v)), w);
+        }
+    }
+    std::sort(ring.begin(), ring.end());
+
+    std::vector<char> mine(m_names.size(), 0);
+    for (std::size_t i { 0 }; i < m_names.size(); ++i) {
+        auto it = std::lower_bound(ring.begin(), ring.end(), std::make_pair(m_rotorHashes[i], std::size_t { 0 }));
+        if (it == ring.end()) {
+            it = ring.begin();
+        }
+        mine[i] = workers[it->second] == m_workerId;
+    }
+    return mine;
+}
+
+void ShardManager::lose(std::size_t i)
+{
+    // 循环线程还未取走的获得与之抵消, 否则先处理失去再处理获得
+    auto& acquired = m_changes.acquired;
+    const auto it = std::find(acquired.begin(), acquired.end(), i);
+    if (it != acquired.end()) {
+        acquired.erase(it);
+    } else {
+        m_changes.lost.emplace_back(i);
+    }
+}
+
+void ShardManager::lose_all()
+{
+    for (std::size_t i { 0 }; i < m_names.size(); ++i) {
+        if (m_held[i] && !m_handedOver[i]) {
+            lose(i);
+        }
+        m_held[i] = false;
+        m_releasing[i] = false;
+        m_handedOver[i] = false;
+        m_tokens[i].clear();
+    }
+    m_workers.clear();
+}
+
+ShardChanges ShardManager::take()
+{
+    ShardChanges changes;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::swap(changes, m_changes);
+    return changes;
+}
+
+std::vector<std::size_t> ShardManager::releasing()
+{
+    std::vector<std::size_t> res;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::size_t i { 0 }; i < m_names.size(); ++i) {
+        if (m_releasing[i]) {
+            res.emplace_back(i);
+        }
+    }
+    return res;
+}
+
+void ShardManager::handed_over(std::size_t i)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_releasing[i] = false;
+    // 期间租约已失去时不再释放
+    m_handedOver[i] = m_held[i];
+}
+
+std::vector<std::size_t> ShardManager::fenced_hmset(const std::string& key, const std::vector<FencedWrite>& writes)
+{
+    std::vector<std::size_t> rejected;
+    std::vector<const FencedWrite*> fenced;
+    std::vector<std::string> keys { key };
+    std::vector<std::string> args;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& write : writes) {
+            if (m_tokens[write.rotor].empty()) {
+                rejected.emplace_back(write.rotor);
+                continue;
+            }
+            fenced.emplace_back(&write);
+            keys.emplace_back(lease_key(write.rotor));
+            args.emplace_back(m_tokens[write.rotor]);
+        }
+    }
+    if (fenced.empty()) {
+        return rejected;
+    }
+    for (const FencedWrite* write : fenced) {
+        args.emplace_back(std::to_string(write->fields.size()));
+    }
+    for (const FencedWrite* write : fenced) {
+        for (const auto& [field, value] : write->fields) {
+            args.emplace_back(field);
+            args.emplace_back(value);
+        }
+    }
+
+    // 脚本失败时m_eval已告警, 全部视为未写入
+    const auto result = m_redis->m_eval(FENCED_HMSET_SCRIPT, keys, args);
+    for (std::size_t k { 0 }; k < fenced.size(); ++k) {
+        if (k < result.size() && result[k] == "1") {
+            continue;
+        }
+        rejected.emplace_back(fenced[k]->rotor);
+        if (k < result.size()) {
+            spdlog::warn("Lease of rotor {} is held by another worker, write to {} rejected", m_names[fenced[k]->rotor], key);
+        }
+    }
+    return rejected;
+}
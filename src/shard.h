@@ -0,0 +1,93 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "myRedis.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr const int LEASE_TTL { 3000 }; // 租约和进程心跳的有效期, 毫秒
+constexpr const int LEASE_RENEW_PERIOD { 1000 }; // 续约周期, 毫秒
+constexpr const int HASH_RING_VNODES { 64 }; // 每个进程在一致性散列环上的虚拟节点数
+
+// 分片模式: 多个进程(可在不同主机上)共同计算一台机组的转子. 每个进程运行相同的配置, 以WORKER_ID区分:
+//
+// - 心跳: 有序集合TS<unit>:Mechanism:Workers, 成员为WORKER_ID, 分值为心跳到期时间, 到期的成员被移除
+// - 分配: 按存活进程构造一致性散列环, 转子<unit>:<name>归环上顺时针的第一个进程, 进程增减时只移动少数转子
+// - 租约: TS<unit>:Mechanism:Lease:<name>, 值为"<WORKER_ID>/<序号>", 只有持有者计算/发布/保存该转子.
+//   心跳, 续约, 获取和释放由一个Lua脚本一次完成, 时间取Redis服务器的时间, 不受主机时钟偏差影响.
+//   序号取自TS<unit>:Mechanism:LeaseEpoch, 每次获得租约时递增; 寿命和快照用fenced_hmset()写入,
+//   Redis核对租约的值后才写入, 租约过期并被其它进程获得后, 本进程进行中的写入不会覆盖对方的结果
+// - 交接: 转子改归其它进程时, 先把快照(Rotor::snapshot)写入TS<unit>:Mechanism:RotorState再释放租约;
+//   进程退出或失联时, 租约在LEASE_TTL后过期, 接手的进程从最近一个周期的快照恢复, 没有快照时重新初始化
+//
+// 后台线程每LEASE_RENEW_PERIOD同步一次, 循环线程在周期开始时用take()取得变化并用handed_over()确认交接.
+// 同步失败超过LEASE_TTL时视为失去所有租约
+struct ShardChanges {
+    std::vector<std::size_t> acquired;
+    std::vector<std::size_t> lost;
+};
+
+// 写入散列的一个转子的字段
+struct FencedWrite {
+    std::size_t rotor;
+    std::vector<std::pair<std::string, std::string>> fields;
+};
+
+class ShardManager {
+private:
+    const std::string m_unit;
+    const std::vector<std::string> m_names;
+    std::shared_ptr<MyRedis> m_redis;
+    const std::string m_workerId;
+    std::vector<uint64_t> m_rotorHashes;
+
+    std::mutex m_mutex;
+    std::vector<char> m_held; // 持有租约, 包括等待交接的转子
+    std::vector<char> m_releasing; // 已改归其它进程, 等循环线程保存快照
+    std::vector<char> m_handedOver; // 快照已保存, 下次同步时释放租约
+    std::vector<std::string> m_tokens; // 持有的租约的值, 未持有时为空
+    ShardChanges m_changes;
+    std::vector<std::string> m_workers; // 上次同步时存活的进程
+
+    std::chrono::steady_clock::time_point m_lastSync;
+    bool m_stop { false };
+    std::condition_variable m_cv;
+    std::thread m_thread;
+
+    void run();
+    void sync();
+    // 按一致性散列应归本进程的转子
+    std::vector<char> assigned(const std::vector<std::string>& workers) const;
+    void lose(std::size_t i);
+    void lose_all();
+    std::string lease_key(std::size_t i) const { return "TS" + m_unit + ":Mechanism:Lease:" + m_names[i]; }
+    std::string epoch_key() const { return "TS" + m_unit + ":Mechanism:LeaseEpoch"; }
+
+public:
+    ShardManager(const std::string& unit, const std::vector<std::string>& names, std::shared_ptr<MyRedis> redis, const std::string& workerId);
+    ShardManager(const ShardManager&) = delete;
+    ShardManager& operator=(const ShardManager&) = delete;
+    // 释放本进程的租约并移除心跳, 其它进程不必等待过期即可接手
+    ~ShardManager() noexcept;
+
+    const std::string& worker_id() const { return m_workerId; }
+    std::string state_key() const { return "TS" + m_unit + ":Mechanism:RotorState"; }
+
+    // 取出上次调用以来获得和失去的转子, 先处理lost再处理acquired
+    ShardChanges take();
+    // 已改归其它进程, 需要保存快照后交接的转子
+    std::vector<std::size_t> releasing();
+    // 转子i的快照已保存, 不再由本进程计算
+    void handed_over(std::size_t i);
+    // 把writes写入散列key, 只写入租约仍由本进程持有的转子, 返回未写入的转子
+    std::vector<std::size_t> fenced_hmset(const std::string& key, const std::vector<FencedWrite>& writes);
+};
+
+#endif // SHARD_H
@@ -0,0 +1,803 @@
+#include "task.h"
+
+#include <algorithm>
+#include <future>
+#include <numeric>
+#include <thread>
+
+Task::Task(const std::vector<std::string>& names, const std::string& unit, const std::vector<Parameters>& paraList, const std::vector<int>& controlWords,
+    std::shared_ptr<MyRedis> redisCli, std::shared_ptr<MyMQTT> MQTTCli,
+    std::vector<std::unique_ptr<MyModbusClient>>&& modbusClis,
+    std::shared_ptr<MyModbusServer> modbusServer, RegisterMap registerMap, RateTable rates)
+    : rotors { names, unit, paraList, controlWords, redisCli, MQTTCli, std::move(modbusClis) }
+    , m_names { names }
+    , m_unit { unit }
+    , m_redis { redisCli }
+    , m_MQTTCli { MQTTCli }
+    , m_modbusServer { modbusServer }
+    , m_registerMap { std::move(registerMap) }
+    , m_registerValues(names.size())
+    , m_unitMessage { unit }
+    , m_stream { unit }
+    , m_ready(names.size(), false)
+    , m_owned(names.size(), 1)
+    , m_initializing(names.size(), 0)
+    , m_initRetryAt(names.size())
+    , m_initBackoff(names.size(), INIT_RETRY_MIN)
+    , m_rates { std::move(rates) }
+    , m_scheduler { m_rates.tick() }
+    , m_rotorMessagePending(names.size(), 0)
+{
+    load_lives();
+    if (RAMP_ADVISOR) {
+        m_rampAdvisor = std::make_unique<RampAdvisor>();
+    }
+    if (TELEMETRY_BUS) {
+        m_telemetry = std::make_unique<TelemetryBus>(unit, names);
+    }
+    if (ARCHIVE) {
+        m_archive = std::make_unique<ArchiveWriter>(ARCHIVE_DIR, unit, names);
+    }
+    if (LIFE_UNCERTAINTY) {
+        m_uncertainty = std::make_unique<LifeUncertainty>(names.size());
+        for (auto& section : rotors.sections()) {
+            section.recordHistory = true;
+        }
+    }
+    if (CONTROL_MQTT || CONTROL_REDIS) {
+        m_control = std::make_unique<ControlPlane>(unit, names, redisCli, MQTTCli, CONTROL_MQTT, CONTROL_REDIS);
+    }
+}
+
+void Task::load_lives()
+{
+    std::vector<std::size_t> all(rotors.size());
+    std::iota(all.begin(), all.end(), 0);
+    load_lives(all);
+}
+
+void Task::load_lives(const std::vector<std::size_t>& which)
+{
+    std::vector<std::string> fields;
+    std::vector<std::size_t> offsets;
+    for (const std::size_t i : which) {
+        offsets.push_back(fields.size());
+        const auto rotorFields = rotors[i].life_fields();
+        fields.insert(fields.end(), rotorFields.begin(), rotorFields.end());
+    }
+    const auto values = m_redis->m_hmget("TS" + m_unit + ":Mechanism:RotorLife", fields);
+    for (std::size_t k { 0 }; k < which.size(); ++k) {
+        rotors[which[k]].set_lives(std::span<const double>(values).subspan(offsets[k], 2 * rotors[which[k]].section_count()));
+    }
+}
+
+void Task::init_done(std::size_t i, bool ok)
+{
+    if (ok) {
+        m_initBackoff[i] = INIT_RETRY_MIN;
+        return;
+    }
+    // 循环到期后重试, 间隔加倍
+    spdlog::warn("Unable to read the surface temperature of rotor {}, retrying in {} s", m_names[i],
+        std::chrono::duration_cast<std::chrono::seconds>(m_initBackoff[i]).count());
+    m_initRetryAt[i] = std::chrono::steady_clock::now() + m_initBackoff[i];
+    m_initBackoff[i] = std::min<std::chrono::steady_clock::duration>(2 * m_initBackoff[i], INIT_RETRY_MAX);
+}
+
+void Task::save_life(std::size_t i)
+{
+    if (!m_shard) {
+        rotors[i].save_life();
+        return;
+    }
+    m_shard->fenced_hmset(rotors[i].life_key(), { { i, rotors[i].take_life_values() } });
+}
+
+void Task::apply_commands(const std::vector<ControlCommand>& commands)
+{
+    for (const auto& command : commands) {
+        // 分片时每个进程都收到命令, 只由持有该转子的进程执行和应答
+        if (!m_owned[command.rotor]) {
+            continue;
+        }
+        Rotor& rotor = rotors[command.rotor];
+        bool ok;
+        if (m_shard) {
+            // 租约已被其它进程获得时不写入, 内存中的寿命也不清零
+            ok = m_shard->fenced_hmset(rotor.life_key(), { { command.rotor, rotor.reset_values(command.life, command.overhaulLife) } }).empty();
+            if (ok) {
+                rotor.clear_lives(command.life, command.overhaulLife);
+            }
+        } else {
+            ok = rotor.reset_life(command.life, command.overhaulLife);
+        }
+        if (ok) {
+            m_control->ack(command, "done");
+        } else {
+            m_control->ack(command, "failed", m_shard ? "lease lost or Redis write failed" : "Redis write failed");
+        }
+    }
+}
+
+void Task::run(long long& count)
+{
+    const std::size_t len { m_names.size() };
+    if (rotors.max_section_count() >= SECTION_PARALLEL_MIN) {
+        m_sectionPool = std::make_unique<ThreadPool>(std::thread::hardware_concurrency());
+        rotors.set_pool(m_sectionPool.get());
+    }
+
+    // 所有转子同时连接并初始化, 已就绪的转子从下一个周期开始参与计算, 不等待慢的从站
+    std::vector<std::future<bool>> inits(len);
+    auto start_init = [this, &inits](std::size_t i) {
+        m_initializing[i] = true;
+        inits[i] = std::async(std::launch::async, [this, i]() { return rotors[i].init(); });
+    };
+    for (std::size_t i { 0 }; i < len; ++i) {
+        if (m_owned[i]) {
+            start_init(i);
+        }
+    }
+
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        m_scheduler.begin_cycle(start);
+        const uint64_t tick { m_scheduler.tick() };
+        std::vector<std::future<void>> futures;
+
+        if (m_shard) {
+            for (const std::size_t i : sync_shard()) {
+                if (!m_initializing[i]) {
+                    start_init(i);
+                }
+            }
+        }
+
+        if (m_control) {
+            apply_commands(m_control->take());
+        }
+
+        // 关键阶段, 从不跳过. 本节拍到期的转子才参与
+        for (std::size_t i { 0 }; i < len; ++i) {
+            if (m_initializing[i] && inits[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                const bool ok { inits[i].get() };
+                init_done(i, ok);
+                m_initializing[i] = false;
+                m_ready[i] = ok && m_owned[i] != 0;
+            } else if (m_owned[i] && !m_ready[i] && !m_initializing[i] && start >= m_initRetryAt[i]) {
+                start_init(i);
+            }
+            auto& rates = m_rates.rotor(i);
+            if (!m_ready[i] || !rates.step.due(tick)) {
+                continue;
+            }
+            const bool saveLife { rates.life.due(tick) };
+            const bool pollControl { rates.control.due(tick) };
+            if (MQTT_ROTOR_MESSAGE && rates.publish.due(tick)) {
+                m_rotorMessagePending[i] = true;
+            }
+            futures.emplace_back(std::async(std::launch::async, [this, i, saveLife, pollControl]() {
+                // 分片时寿命在计算后另行核对租约保存
+                rotors[i].run(saveLife && !m_shard, pollControl);
+                if (m_shard && saveLife && rotors[i].life_dirty()) {
+                    save_life(i);
+                }
+            }));
+        }
+
+        for (auto& f : futures) {
+            f.wait();
+        }
+
+        // 可选阶段, 按优先级执行
+        const bool report { m_rates.stage_due(Stage::unit_message, tick) };
+        if (report) {
+            m_unitMessagePending = MQTT_UNIT_MESSAGE;
+        }
+
+        if (m_rates.stage_due(Stage::registers, tick)) {
+            run_stage(Stage::registers, [this]() { update_registers(); });
+        }
+
+        if (TELEMETRY_BUS && m_rates.stage_due(Stage::telemetry, tick)) {
+            run_stage(Stage::telemetry, [this, &count]() { publish_telemetry(count + 1); });
+        }
+
+        if (m_editorApi && m_rates.stage_due(Stage::live, tick)) {
+            run_stage(Stage::live, [this]() { m_editorApi->push_state(unit_message()); });
+        }
+
+        if (rotor_message_pending()) {
+            const bool sent = run_stage(Stage::rotor_message, [this, len]() {
+                std::vector<std::future<void>> sends;
+                for (std::size_t i { 0 }; i < len; ++i) {
+                    if (m_rotorMessagePending[i]) {
+                        sends.emplace_back(std::async(std::launch::async, [this, i]() { rotors[i].send_message(); }));
+                    }
+                }
+                for (auto& f : sends) {
+                    f.wait();
+                }
+            }, true);
+            if (sent) {
+                std::fill(m_rotorMessagePending.begin(), m_rotorMessagePending.end(), 0);
+            }
+        }
+
+        if (m_unitMessagePending) {
+            m_unitMessagePending = !run_stage(Stage::unit_message, [this]() { send_unit_message(); }, true);
+        }
+
+        if (REDIS_STREAM && m_rates.stage_due(Stage::stream, tick)) {
+            run_stage(Stage::stream, [this, &count]() { write_stream(count + 1); });
+        }
+
+        if (ARCHIVE && m_rates.stage_due(Stage::archive, tick)) {
+            run_stage(Stage::archive, [this]() { write_archive(); });
+        }
+
+        if (RAMP_ADVISOR && m_rates.stage_due(Stage::ramp_advice, tick)) {
+            run_stage(Stage::ramp_advice, [this]() { send_ramp_advice(); });
+        }
+
+        if (LIFE_UNCERTAINTY) {
+            if (m_rates.stage_due(Stage::uncertainty, tick)) {
+                run_stage(Stage::uncertainty, [this]() { submit_uncertainty(); });
+            }
+            const std::string bands { life_uncertainty() };
+            if (!bands.empty()) {
+                m_MQTTCli->publish(uncertainty_topic(), bands, QOS);
+            }
+        }
+
+        if (report) {
+            m_MQTTCli->publish(scheduler_topic(), m_scheduler.stats_json(), QOS);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        auto elapsed_time = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        trace(TraceLevel::info, TraceEvent::loop_time, LoopTimePayload { ++count, elapsed_time.count() });
+        std::this_thread::sleep_until(m_scheduler.end_cycle(end));
+    }
+}
+
+void Task::enable_sharding(std::unique_ptr<ShardManager> shard)
+{
+    m_shard = std::move(shard);
+    std::fill(m_owned.begin(), m_owned.end(), 0);
+    // 控制字的复位随寿命一起核对租约保存
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        rotors[i].defer_life_writes(true);
+    }
+}
+
+std::vector<std::size_t> Task::apply_shard_changes(const ShardChanges& changes, const std::vector<std::string>& snapshots)
+{
+    for (const std::size_t i : changes.lost) {
+        m_owned[i] = false;
+        m_ready[i] = false;
+        m_rotorMessagePending[i] = false;
+    }
+
+    std::vector<std::size_t> uninitialized;
+    for (std::size_t k { 0 }; k < changes.acquired.size(); ++k) {
+        const std::size_t i { changes.acquired[k] };
+        m_owned[i] = true;
+        if (m_initializing[i]) {
+            continue;
+        }
+        if (k < snapshots.size() && !snapshots[k].empty() && rotors[i].restore(json::parse(snapshots[k], nullptr, false))) {
+            m_ready[i] = true;
+            spdlog::info("Rotor {} restored from snapshot", rotors[i].name());
+        } else {
+            m_ready[i] = false;
+            uninitialized.emplace_back(i);
+        }
+    }
+    return uninitialized;
+}
+
+std::vector<FencedWrite> Task::shard_snapshots() const
+{
+    std::vector<FencedWrite> snapshots;
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_owned[i] && m_ready[i]) {
+            snapshots.push_back({ i, { { m_names[i], rotors[i].snapshot().dump() } } });
+        }
+    }
+    return snapshots;
+}
+
+void Task::hand_over(const std::vector<std::size_t>& releasing)
+{
+    for (const std::size_t i : releasing) {
+        m_owned[i] = false;
+        m_ready[i] = false;
+        m_rotorMessagePending[i] = false;
+        m_shard->handed_over(i);
+    }
+}
+
+std::vector<std::string> Task::load_snapshots(const std::vector<std::size_t>& which)
+{
+    std::vector<std::string> fields;
+    for (const std::size_t i : which) {
+        fields.emplace_back(m_names[i]);
+    }
+    return m_redis->m_hmget_strings(m_shard->state_key(), fields);
+}
+
+std::vector<std::size_t> Task::sync_shard()
+{
+    const ShardChanges changes { m_shard->take() };
+    std::vector<std::string> snapshots;
+    if (!changes.acquired.empty()) {
+        snapshots = load_snapshots(changes.acquired);
+    }
+    auto uninitialized = apply_shard_changes(changes, snapshots);
+    if (!uninitialized.empty()) {
+        load_lives(uninitialized);
+    }
+
+    // 每个周期写一次快照, 进程失联时接手的进程最多丢失一个周期; 要交接的转子也在其中
+    const auto releasing = m_shard->releasing();
+    const auto fields = shard_snapshots();
+    if (!fields.empty()) {
+        m_shard->fenced_hmset(m_shard->state_key(), fields);
+    }
+    hand_over(releasing);
+    return uninitialized;
+}
+
+bool Task::run_stage(Stage stage, const std::function<void()>& fn, bool deferrable)
+{
+    if (!m_scheduler.admit(stage, deferrable)) {
+        return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    m_scheduler.done(stage, std::chrono::steady_clock::now() - start);
+    return true;
+}
+
+bool Task::rotor_message_pending() const
+{
+    return std::find(m_rotorMessagePending.begin(), m_rotorMessagePending.end(), 1) != m_rotorMessagePending.end();
+}
+
+const std::string& Task::unit_message()
+{
+    m_unitMessage.clear();
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_ready[i]) {
+            m_unitMessage.add(rotors[i].name(), rotors[i].state());
+        }
+    }
+    return m_unitMessage.finish();
+}
+
+std::string Task::ramp_advice()
+{
+    auto& inputs = m_rampAdvisor->inputs();
+    inputs.clear();
+    std::vector<std::size_t> index;
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_ready[i]) {
+            inputs.push_back({ rotors[i].thermal(), rotors[i].life_state() });
+            index.push_back(i);
+        }
+    }
+    const auto& advice = m_rampAdvisor->run();
+
+    json j = json::object();
+    for (std::size_t i { 0 }; i < advice.size(); ++i) {
+        j[m_names[index[i]]] = {
+            { "rampRate", advice[i].rampRate },
+            { "lifeConsumption", advice[i].lifeConsumption },
+            { "minMargin", advice[i].minMargin },
+            { "feasible", advice[i].feasible }
+        };
+    }
+    return j.dump();
+}
+
+void Task::publish_telemetry(long long count)
+{
+    if (!m_telemetry) {
+        return;
+    }
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_ready[i]) {
+            m_telemetry->write(i, rotors[i]);
+        }
+    }
+    m_telemetry->notify(count);
+}
+
+void Task::write_stream(long long count)
+{
+    m_stream.clear();
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_ready[i]) {
+            m_stream.add(count, rotors[i].name(), rotors[i].state());
+        }
+    }
+    m_stream.flush(*m_redis);
+}
+
+void Task::write_archive()
+{
+    const int64_t now { std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() };
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_ready[i]) {
+            m_archive->append(i, now, rotors[i].state());
+        }
+    }
+    m_archive->sync();
+}
+
+void Task::submit_uncertainty()
+{
+    if (m_uncertainty->busy()) {
+        return;
+    }
+    const double now { steady_seconds(std::chrono::steady_clock::now()) };
+    std::vector<UncertaintyInput> inputs;
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_ready[i]) {
+            // 寿命消耗最多的截面
+            const RotorSection& section = rotors[i].section(rotors[i].life_section());
+            inputs.push_back({ i, &section.para, section.history.samples(), section.life.lifeRatio, now - section.history.start() });
+        }
+    }
+    m_uncertainty->submit(std::move(inputs));
+}
+
+std::string Task::life_uncertainty()
+{
+    if (!m_uncertainty->take(m_uncertaintyBands)) {
+        return {};
+    }
+    auto percentiles = [](const std::array<double, 3>& p) {
+        return json { { "p10", p[0] }, { "p50", p[1] }, { "p90", p[2] } };
+    };
+    json j = json::object();
+    for (std::size_t i { 0 }; i < m_uncertaintyBands.size(); ++i) {
+        const UncertaintyBand& band = m_uncertaintyBands[i];
+        if (band.valid) {
+            j[m_names[i]] = {
+                { "lifeRatio", percentiles(band.lifeRatio) },
+                { "remainingHours", percentiles(band.remainingHours) },
+                { "nominalConsumption", band.nominalConsumption },
+                { "windowHours", band.window / 3600 }
+            };
+        }
+    }
+    return j.dump();
+}
+
+void Task::update_registers()
+{
+    for (std::size_t i { 0 }; i < rotors.size(); ++i) {
+        if (m_ready[i]) {
+            m_registerValues[i] = pack_register_values(rotors[i].state());
+        }
+    }
+    m_modbusServer->update(m_registerMap, m_registerValues);
+}
+
+void Task::send_unit_message()
+{
+    m_MQTTCli->publish(m_unitMessage.topic(), unit_message(), QOS);
+}
+
+void Task::send_ramp_advice()
+{
+    m_MQTTCli->publish("TS" + m_unit + "/RampAdvice", ramp_advice(), QOS);
+}
+
+namespace {
+
+std::vector<std::unique_ptr<MyModbusClient>> no_modbus_clients(std::size_t n)
+{
+    std::vector<std::unique_ptr<MyModbusClient>> clis;
+    clis.resize(n);
+    return clis;
+}
+
+} // namespace
+
+ReactorTask::ReactorTask(const std::vector<std::string>& names, const std::string& unit, const std::vector<Parameters>& paraList, const std::vector<int>& controlWords,
+    std::shared_ptr<MyRedis> redisCli, std::shared_ptr<MyMQTT> MQTTCli,
+    const std::string& modbusIp, int modbusPort, const std::vector<int>& slaveIDs,
+    std::shared_ptr<MyModbusServer> modbusServer, RegisterMap registerMap, RateTable rates)
+    : Task { names, unit, paraList, controlWords, redisCli, MQTTCli, no_modbus_clients(names.size()), modbusServer, std::move(registerMap), std::move(rates) }
+    , m_computePool { std::max(1u, std::thread::hardware_concurrency() / 2) }
+    , m_ioPool { REACTOR_IO_THREADS }
+    , m_initialized(names.size(), 0)
+{
+    for (int slaveID : slaveIDs) {
+        m_modbusClis.emplace_back(std::make_unique<AsyncModbusClient>(m_reactor, modbusIp, modbusPort, slaveID));
+    }
+    rotors.set_pool(&m_computePool);
+}
+
+Coro<bool> ReactorTask::publish(const std::string& topic, const std::string& payload)
+{
+    co_return co_await m_reactor.await_callback<bool>([this, &topic, &payload](std::function<void(bool)> done) {
+        m_MQTTCli->publish_async(topic, payload, QOS, std::move(done));
+    });
+}
+
+Coro<void> ReactorTask::init_rotor(std::size_t i)
+{
+    Rotor& rotor = rotors[i];
+    bool ok { false };
+    try {
+        // 连接或请求失败时read_registers返回空, 不抛出
+        ok = rotor.init_field(co_await m_modbusClis[i]->read_registers(SURFACE_REGISTER_START, SURFACE_REGISTER_NUM));
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from init_rotor {}: {}", rotor.name(), e.what());
+    }
+    init_done(i, ok);
+    m_initialized[i] = ok;
+    m_initializing[i] = false;
+}
+
+Coro<void> ReactorTask::sync_shard()
+{
+    // Redis交给I/O线程池, 转子状态只在反应器线程上修改, 不与进行中的init_rotor冲突
+    const ShardChanges changes { m_shard->take() };
+    std::vector<std::string> snapshots;
+    if (!changes.acquired.empty()) {
+        snapshots = co_await m_reactor.offload(m_ioPool, [this, &changes]() { return load_snapshots(changes.acquired); });
+    }
+    const auto uninitialized = apply_shard_changes(changes, snapshots);
+    const auto releasing = m_shard->releasing();
+    const auto fields = shard_snapshots();
+    if (!uninitialized.empty() || !fields.empty()) {
+        co_await m_reactor.offload(m_ioPool, [this, &uninitialized, &fields]() {
+            if (!uninitialized.empty()) {
+                load_lives(uninitialized);
+            }
+            if (!fields.empty()) {
+                m_shard->fenced_hmset(m_shard->state_key(), fields);
+            }
+        });
+    }
+    hand_over(releasing);
+
+    for (const std::size_t i : uninitialized) {
+        m_initialized[i] = false;
+        m_initializing[i] = true;
+        spawn(init_rotor(i));
+    }
+}
+
+Coro<void> ReactorTask::run_rotor(std::size_t i, bool saveLife, bool pollControl, WaitGroup& wg)
+{
+    Rotor& rotor = rotors[i];
+    try {
+        // 控制字与表面温度合并为一次读取
+        const RegisterBlock block { rotor.acquisition_block(pollControl) };
+        const auto registers = co_await m_modbusClis[i]->read_registers(block.start, block.count);
+        if (pollControl) {
+            std::vector<uint16_t> control;
+            if (rotor.contains_control_word(block)) {
+                control = Rotor::slice(registers, block, rotor.control_word(), 1);
+            } else {
+                control = co_await m_modbusClis[i]->read_registers(rotor.control_word(), 1);
+            }
+            if (Rotor::has_control_command(control)) {
+                co_await m_reactor.offload(m_ioPool, [&rotor, &control]() { rotor.apply_control_command(control); });
+            }
+        }
+
+        co_await m_reactor.offload(m_computePool, [this, &rotor]() {
+            if (!m_realtime) {
+                rotor.step();
+                return;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            rotor.step();
+            m_latency.record_step(std::chrono::steady_clock::now() - start);
+        });
+        if (saveLife && rotor.life_dirty()) {
+            co_await m_reactor.offload(m_ioPool, [this, i]() { save_life(i); });
+        }
+
+        rotor.update_surface_temp(Rotor::slice(registers, block, SURFACE_REGISTER_START, SURFACE_REGISTER_NUM));
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from run_rotor {}: {}", rotor.name(), e.what());
+    }
+    wg.done();
+}
+
+Coro<void> ReactorTask::publish_rotor(std::size_t i, WaitGroup& wg)
+{
+    try {
+        co_await publish("TS" + m_unit + "/Rotor" + rotors[i].name(), rotors[i].message().dump());
+    } catch (const std::exception& e) {
+        spdlog::warn("Exception from publish_rotor {}: {}", rotors[i].name(), e.what());
+    }
+    wg.done();
+}
+
+Coro<bool> ReactorTask::await_stage(Stage stage, std::function<Coro<void>()> fn, bool deferrable)
+{
+    if (!m_scheduler.admit(stage, deferrable)) {
+        co_return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    co_await fn();
+    m_scheduler.done(stage, std::chrono::steady_clock::now() - start);
+    co_return true;
+}
+
+Coro<void> ReactorTask::loop(long long& count)
+{
+    const std::size_t len { m_names.size() };
+
+    // 不等待初始化完成, 就绪的转子从下一个周期开始参与计算
+    for (std::size_t i { 0 }; i < len; ++i) {
+        if (m_owned[i]) {
+            m_initializing[i] = true;
+            spawn(init_rotor(i));
+        }
+    }
+
+    std::chrono::microseconds wake { 0 };
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        m_scheduler.begin_cycle(start);
+        const uint64_t tick { m_scheduler.tick() };
+
+        // 只在周期开始时改变就绪集合, 周期内被卸载到线程池的汇总计算看到的集合不变
+        for (std::size_t i { 0 }; i < len; ++i) {
+            if (m_initialized[i]) {
+                m_initialized[i] = false;
+                m_ready[i] = m_owned[i] != 0;
+            } else if (m_owned[i] && !m_ready[i] && !m_initializing[i] && start >= m_initRetryAt[i]) {
+                m_initializing[i] = true;
+                spawn(init_rotor(i));
+            }
+        }
+
+        if (m_shard) {
+            co_await sync_shard();
+        }
+
+        if (m_control) {
+            const auto commands = m_control->take();
+            if (!commands.empty()) {
+                co_await m_reactor.offload(m_ioPool, [this, &commands]() { apply_commands(commands); });
+            }
+        }
+
+        // 关键阶段, 从不跳过. 本节拍到期的转子才参与
+        WaitGroup wg;
+        for (std::size_t i { 0 }; i < len; ++i) {
+            auto& rates = m_rates.rotor(i);
+            if (!m_ready[i] || !rates.step.due(tick)) {
+                continue;
+            }
+            const bool saveLife { rates.life.due(tick) };
+            const bool pollControl { rates.control.due(tick) };
+            if (MQTT_ROTOR_MESSAGE && rates.publish.due(tick)) {
+                m_rotorMessagePending[i] = true;
+            }
+            wg.add();
+            spawn(run_rotor(i, saveLife, pollControl, wg));
+        }
+        co_await wg;
+
+        // 可选阶段, 按优先级执行
+        const bool report { m_rates.stage_due(Stage::unit_message, tick) };
+        if (report) {
+            m_unitMessagePending = MQTT_UNIT_MESSAGE;
+        }
+
+        if (m_rates.stage_due(Stage::registers, tick)) {
+            run_stage(Stage::registers, [this]() { update_registers(); });
+        }
+
+        if (TELEMETRY_BUS && m_rates.stage_due(Stage::telemetry, tick)) {
+            run_stage(Stage::telemetry, [this, &count]() { publish_telemetry(count + 1); });
+        }
+
+        if (m_editorApi && m_rates.stage_due(Stage::live, tick)) {
+            run_stage(Stage::live, [this]() { m_editorApi->push_state(unit_message()); });
+        }
+
+        if (rotor_message_pending()) {
+            const bool sent = co_await await_stage(Stage::rotor_message, [this, len]() -> Coro<void> {
+                WaitGroup sends;
+                for (std::size_t i { 0 }; i < len; ++i) {
+                    if (m_rotorMessagePending[i]) {
+                        sends.add();
+                        spawn(publish_rotor(i, sends));
+                    }
+                }
+                co_await sends;
+            }, true);
+            if (sent) {
+                std::fill(m_rotorMessagePending.begin(), m_rotorMessagePending.end(), 0);
+            }
+        }
+
+        if (m_unitMessagePending) {
+            const bool sent = co_await await_stage(Stage::unit_message, [this]() -> Coro<void> {
+                co_await publish(m_unitMessage.topic(), unit_message());
+            }, true);
+            if (sent) {
+                m_unitMessagePending = false;
+            }
+        }
+
+        if (REDIS_STREAM && m_rates.stage_due(Stage::stream, tick)) {
+            co_await await_stage(Stage::stream, [this, &count]() -> Coro<void> {
+                co_await m_reactor.offload(m_ioPool, [this, &count]() { write_stream(count + 1); });
+            });
+        }
+
+        if (ARCHIVE && m_rates.stage_due(Stage::archive, tick)) {
+            co_await await_stage(Stage::archive, [this]() -> Coro<void> {
+                co_await m_reactor.offload(m_ioPool, [this]() { write_archive(); });
+            });
+        }
+
+        if (RAMP_ADVISOR && m_rates.stage_due(Stage::ramp_advice, tick)) {
+            co_await await_stage(Stage::ramp_advice, [this]() -> Coro<void> {
+                const std::string advice = co_await m_reactor.offload(m_computePool, [this]() { return ramp_advice(); });
+                co_await publish("TS" + m_unit + "/RampAdvice", advice);
+            });
+        }
+
+        if (LIFE_UNCERTAINTY) {
+            if (m_rates.stage_due(Stage::uncertainty, tick)) {
+                co_await await_stage(Stage::uncertainty, [this]() -> Coro<void> {
+                    co_await m_reactor.offload(m_computePool, [this]() { submit_uncertainty(); });
+                });
+            }
+            const std::string bands { life_uncertainty() };
+            if (!bands.empty()) {
+                co_await publish(uncertainty_topic(), bands);
+            }
+        }
+
+        if (report) {
+            co_await publish(scheduler_topic(), m_scheduler.stats_json());
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        auto elapsed_time = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        trace(TraceLevel::info, TraceEvent::loop_time, LoopTimePayload { ++count, elapsed_time.count() });
+        if (m_realtime) {
+            m_latency.record_cycle(count, wake, elapsed_time);
+        }
+
+        const auto next = m_scheduler.end_cycle(end);
+        co_await m_reactor.sleep_for(next - std::chrono::steady_clock::now());
+        wake = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - next);
+    }
+}
+
+void ReactorTask::enable_realtime(const RealtimeConfig& config)
+{
+    m_computePool.for_each_worker([&config](std::size_t) {
+        set_thread_affinity(config.computeCpus);
+        set_thread_realtime(config.priority);
+        prefault_stack();
+    });
+    m_ioPool.for_each_worker([&config](std::size_t) {
+        set_thread_affinity(config.ioCpus);
+    });
+    m_realtime = true;
+    spdlog::info("Real-time mode: {} compute threads, SCHED_FIFO priority {}", m_computePool.size(), config.priority);
+}
+
+void ReactorTask::run(long long& count)
+{
+    spawn(loop(count));
+    m_reactor.run();
+}
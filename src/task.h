@@ -0,0 +1,155 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include "Rotor.h"
+#include "archiveWriter.h"
+#include "asyncModbus.h"
+#include "controlPlane.h"
+#include "editorApi.h"
+#include "rampAdvisor.h"
+#include "reactor.h"
+#include "rates.h"
+#include "realtime.h"
+#include "rotorRegistry.h"
+#include "rotorStream.h"
+#include "scheduler.h"
+#include "shard.h"
+#include "telemetryBus.h"
+#include "unitMessage.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr const bool MQTT_ROTOR_MESSAGE { true }; // 每个转子单独发布TS<unit>/Rotor<name>
+constexpr const bool MQTT_UNIT_MESSAGE { false }; // 每台机组汇总发布一条TS<unit>/Rotors
+constexpr const bool RAMP_ADVISOR { false }; // 每周期发布TS<unit>/RampAdvice升温速率建议
+constexpr const bool TELEMETRY_BUS { false }; // 每周期写共享内存/ts<unit>_telemetry供本机读取
+constexpr const bool REDIS_STREAM { false }; // 每周期追加转子样本到TS<unit>:Mechanism:RotorStream
+constexpr const bool ARCHIVE { false }; // 每周期把转子样本压缩写入ARCHIVE_DIR/TS<unit>/, 用tools/archive_export导出
+constexpr const char* ARCHIVE_DIR { "archive" };
+constexpr const bool LIFE_UNCERTAINTY { false }; // 后台评估寿命的P10/P50/P90, 完成后发布TS<unit>/LifeUncertainty
+constexpr const bool CONTROL_MQTT { false }; // 接受TS<unit>/Command的寿命复位命令; 命令本身不鉴权, 启用前须由broker ACL限制该主题的发布者
+constexpr const bool CONTROL_REDIS { false }; // 接受Redis频道TS<unit>:Mechanism:Command的寿命复位命令
+constexpr const std::size_t REACTOR_IO_THREADS { 2 }; // 阻塞的Redis调用
+constexpr const auto INIT_RETRY_MIN { std::chrono::seconds(5) }; // 初始化读取失败后重试的间隔, 每次失败加倍
+constexpr const auto INIT_RETRY_MAX { std::chrono::seconds(60) };
+
+// 每个周期为每个转子启动一个线程, 同步读写Modbus/Redis/MQTT
+class Task {
+protected:
+    RotorRegistry rotors; // 序号即RotorHandle
+    const std::vector<std::string> m_names;
+    const std::string m_unit;
+    std::shared_ptr<MyRedis> m_redis;
+    std::shared_ptr<MyMQTT> m_MQTTCli;
+    std::shared_ptr<MyModbusServer> m_modbusServer;
+    const RegisterMap m_registerMap;
+    std::vector<RegisterValues> m_registerValues;
+    UnitMessage m_unitMessage;
+    RotorStream m_stream;
+    std::unique_ptr<RampAdvisor> m_rampAdvisor;
+    std::unique_ptr<TelemetryBus> m_telemetry;
+    std::unique_ptr<ArchiveWriter> m_archive;
+    std::unique_ptr<LifeUncertainty> m_uncertainty;
+    std::vector<UncertaintyBand> m_uncertaintyBands;
+    std::unique_ptr<ControlPlane> m_control;
+    std::unique_ptr<EditorApi> m_editorApi;
+    std::unique_ptr<ShardManager> m_shard;
+    std::vector<bool> m_ready; // 初始化完成的转子, 只在循环线程读写
+    std::vector<char> m_owned; // 由本进程计算的转子, 不分片时为全部
+    std::vector<char> m_initializing; // 正在初始化, 不从快照恢复
+    std::vector<std::chrono::steady_clock::time_point> m_initRetryAt; // 初始化失败后, 到此时刻再重试
+    std::vector<std::chrono::steady_clock::duration> m_initBackoff;
+    RateTable m_rates;
+    CycleScheduler m_scheduler;
+    std::vector<char> m_rotorMessagePending; // 被推迟的消息在后续周期补发
+    bool m_unitMessagePending { false };
+    std::unique_ptr<ThreadPool> m_sectionPool; // 线程模式下截面多的转子分块推进, 反应器模式使用计算线程池
+
+    // 一次HMGET读取所有转子的寿命
+    void load_lives();
+    void load_lives(const std::vector<std::size_t>& which);
+    // 保存转子i的寿命; 分片时核对租约, 租约已被其它进程获得时不写入
+    void save_life(std::size_t i);
+    // 记录转子i初始化的结果, 失败时安排在m_initRetryAt[i]重试
+    void init_done(std::size_t i, bool ok);
+    // 执行控制面收到的命令并应答, 只在转子不运行时调用
+    void apply_commands(const std::vector<ControlCommand>& commands);
+
+    const std::string& unit_message();
+    void publish_telemetry(long long count);
+    void write_stream(long long count);
+    void write_archive();
+    // 把各转子的应力历程交给后台评估, 上一次评估未完成时跳过
+    void submit_uncertainty();
+    // 新完成的评估结果, 没有时为空
+    std::string life_uncertainty();
+    std::string uncertainty_topic() const { return "TS" + m_unit + "/LifeUncertainty"; }
+    void update_registers();
+    bool rotor_message_pending() const;
+    // 调度器允许时执行fn并记录耗时, 返回是否执行
+    bool run_stage(Stage stage, const std::function<void()>& fn, bool deferrable = false);
+    std::string scheduler_topic() const { return "TS" + m_unit + "/Scheduler"; }
+    std::string ramp_advice();
+
+    // 分片: 停止计算失去的转子, 从快照恢复新获得的转子, 返回没有可用快照需要初始化的转子
+    std::vector<std::size_t> apply_shard_changes(const ShardChanges& changes, const std::vector<std::string>& snapshots);
+    // 所有持有的转子的快照, 用ShardManager::fenced_hmset()写入state_key()
+    std::vector<FencedWrite> shard_snapshots() const;
+    // 快照已写入, 把releasing中的转子交给其它进程
+    void hand_over(const std::vector<std::size_t>& releasing);
+    std::vector<std::string> load_snapshots(const std::vector<std::size_t>& which);
+    // 同步执行以上各步
+    std::vector<std::size_t> sync_shard();
+
+public:
+    // modbusClis中的元素为空时转子不在构造中初始化, 由派生类负责. paraList被复制, 构造后调用者可释放
+    Task(const std::vector<std::string>& names, const std::string& unit, const std::vector<Parameters>& paraList, const std::vector<int>& controlWords,
+        std::shared_ptr<MyRedis> redisCli, std::shared_ptr<MyMQTT> MQTTCli,
+        std::vector<std::unique_ptr<MyModbusClient>>&& modbusClis,
+        std::shared_ptr<MyModbusServer> modbusServer, RegisterMap registerMap, RateTable rates);
+    virtual ~Task() = default;
+
+    // 每周期向编辑器接口推送所有转子的状态
+    void enable_editor_api(std::unique_ptr<EditorApi> editorApi) { m_editorApi = std::move(editorApi); }
+    // 只计算按租约分给本进程的转子, 须在run()之前调用
+    void enable_sharding(std::unique_ptr<ShardManager> shard);
+    virtual void run(long long& count);
+    void send_unit_message();
+    void send_ramp_advice();
+};
+
+// 单线程反应器驱动所有转子: Modbus读取为非阻塞协程, MQTT发布不等待确认,
+// 计算交给计算线程池, Redis交给小的阻塞I/O线程池
+class ReactorTask : public Task {
+private:
+    Reactor m_reactor;
+    ThreadPool m_computePool;
+    ThreadPool m_ioPool;
+    std::vector<std::unique_ptr<AsyncModbusClient>> m_modbusClis;
+    std::vector<char> m_initialized; // init_rotor完成, 下个周期开始时并入m_ready
+    bool m_realtime { false };
+    LatencyMonitor m_latency;
+
+    Coro<bool> publish(const std::string& topic, const std::string& payload);
+    Coro<void> init_rotor(std::size_t i);
+    Coro<void> sync_shard();
+    Coro<void> run_rotor(std::size_t i, bool saveLife, bool pollControl, WaitGroup& wg);
+    Coro<void> publish_rotor(std::size_t i, WaitGroup& wg);
+    // 同Task::run_stage, 等待fn返回的协程完成后记录耗时.
+    // fn只捕获this, 引用和标量: GCC 12会把co_await表达式中捕获了非平凡对象的临时lambda析构两次
+    Coro<bool> await_stage(Stage stage, std::function<Coro<void>()> fn, bool deferrable = false);
+    Coro<void> loop(long long& count);
+
+public:
+    ReactorTask(const std::vector<std::string>& names, const std::string& unit, const std::vector<Parameters>& paraList, const std::vector<int>& controlWords,
+        std::shared_ptr<MyRedis> redisCli, std::shared_ptr<MyMQTT> MQTTCli,
+        const std::string& modbusIp, int modbusPort, const std::vector<int>& slaveIDs,
+        std::shared_ptr<MyModbusServer> modbusServer, RegisterMap registerMap, RateTable rates);
+
+    // 计算线程绑定到computeCpus并切换为SCHED_FIFO, I/O线程绑定到ioCpus, 并开始统计周期延迟
+    void enable_realtime(const RealtimeConfig& config);
+    void run(long long& count) override;
+};
+
+#endif // TASK_H
@@ -0,0 +1,110 @@
+#include "telemetryBus.h"
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+TelemetryBus::TelemetryBus(const std::string& unit, const std::vector<std::string>& names)
+    : m_name { segment_name(unit) }
+    , m_size { sizeof(TelemetryHeader) + names.size() * sizeof(TelemetrySlot) }
+{
+    // 上次异常退出留下的段可能布局不同, 重新创建
+    ::shm_unlink(m_name.c_str());
+    const int fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        spdlog::error("Unable to create telemetry segment {}: {}", m_name, std::strerror(errno));
+        return;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(m_size)) == -1) {
+        spdlog::error("Unable to size telemetry segment {}: {}", m_name, std::strerror(errno));
+        ::close(fd);
+        ::shm_unlink(m_name.c_str());
+        return;
+    }
+    void* addr = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        spdlog::error("Unable to map telemetry segment {}: {}", m_name, std::strerror(errno));
+        ::shm_unlink(m_name.c_str());
+        return;
+    }
+
+    // ftruncate后内容全为0, 各原子量的初始值即为0
+    m_header = static_cast<TelemetryHeader*>(addr);
+    m_slots = reinterpret_cast<TelemetrySlot*>(static_cast<char*>(addr) + sizeof(TelemetryHeader));
+
+    m_header->version = TELEMETRY_VERSION;
+    m_header->headerSize = sizeof(TelemetryHeader);
+    m_header->slotSize = sizeof(TelemetrySlot);
+    m_header->rotorCount = static_cast<uint32_t>(names.size());
+    m_header->maxNodes = TELEMETRY_MAX_NODES;
+    unit.copy(m_header->unit, sizeof(m_header->unit) - 1);
+    for (std::size_t i { 0 }; i < names.size(); ++i) {
+        names[i].copy(m_slots[i].data.name, sizeof(m_slots[i].data.name) - 1);
+    }
+    // magic最后写入, 读者见到magic即可信任其余头部字段
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_header->magic, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC));
+
+    spdlog::info("Telemetry segment {} created: {} rotors, {} bytes", m_name, names.size(), m_size);
+}
+
+TelemetryBus::~TelemetryBus() noexcept
+{
+    if (m_header != nullptr) {
+        // 先删除段再唤醒等待的读者, 读者随后open()时发现段已不存在或已重建
+        ::shm_unlink(m_name.c_str());
+        m_header->cycle.fetch_add(1, std::memory_order_release);
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->cycle), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        ::munmap(m_header, m_size);
+    }
+}
+
+void TelemetryBus::write(std::size_t index, const Rotor& rotor)
+{
+    if (m_header == nullptr || index >= m_header->rotorCount) {
+        return;
+    }
+
+    const RotorState state { rotor.state() };
+    TelemetrySlot& slot = m_slots[index];
+    const uint32_t seq { slot.seq.load(std::memory_order_relaxed) };
+
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TelemetryRotor& d = slot.data;
+    d.lifeRatio = state.lifeRatio;
+    d.overhaulLifeRatio = state.overhaulLifeRatio;
+    d.alert = state.alert;
+    d.ts = state.ts;
+    d.t0 = state.t0;
+    d.centerThermalStress = state.centerThermalStress;
+    d.surfaceThermalStress = state.surfaceThermalStress;
+    d.thermalStress = state.thermalStress;
+    d.thermalStressMargin = state.thermalStressMargin;
+    std::copy(state.temperature.begin(), state.temperature.end(), d.temperature);
+    d.nodes = static_cast<uint32_t>(rotor.thermal().copy_field(d.field, TELEMETRY_MAX_NODES));
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+void TelemetryBus::notify(long long count)
+{
+    if (m_header == nullptr) {
+        return;
+    }
+    m_header->cycleCount = static_cast<uint64_t>(count);
+    m_header->updatedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+    m_header->cycle.fetch_add(1, std::memory_order_release);
+    // 共享映射上的futex, 不能用FUTEX_PRIVATE_FLAG
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_header->cycle), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
@@ -0,0 +1,31 @@
+#ifndef TELEMETRYBUS_H
+#define TELEMETRYBUS_H
+
+#include "Rotor.h"
+#include "telemetryLayout.h"
+#include <string>
+#include <vector>
+
+// 把每个转子的状态写入POSIX共享内存, 供同机HMI/历史库适配器直接读取(见telemetryReader.h).
+// 只在一个线程中写; 创建失败时记录错误, 之后的写入均为空操作
+class TelemetryBus {
+private:
+    std::string m_name;
+    std::size_t m_size { 0 };
+    TelemetryHeader* m_header { nullptr };
+    TelemetrySlot* m_slots { nullptr };
+
+public:
+    TelemetryBus(const std::string& unit, const std::vector<std::string>& names);
+    TelemetryBus(const TelemetryBus&) = delete;
+    TelemetryBus& operator=(const TelemetryBus&) = delete;
+    ~TelemetryBus() noexcept;
+
+    static std::string segment_name(const std::string& unit) { return "/ts" + unit + "_telemetry"; }
+
+    void write(std::size_t index, const Rotor& rotor);
+    // 一个周期的全部槽位写完后调用, 唤醒等待的读者
+    void notify(long long count);
+};
+
+#endif // TELEMETRYBUS_H
@@ -0,0 +1,56 @@
+#ifndef TELEMETRYLAYOUT_H
+#define TELEMETRYLAYOUT_H
+
+#include <atomic>
+#include <cstdint>
+
+// 共享内存遥测段布局, 服务端(TelemetryBus)与本机读者(TelemetryReader)共用, 不依赖其他头文件.
+// 段名 /ts<unit>_telemetry, 内容为一个TelemetryHeader后接rotorCount个TelemetrySlot.
+// 每个槽位是一把seqlock: 写者把seq加为奇数, 写数据, 再加为偶数; 读者在seq为偶数且前后一致时数据有效.
+// 每个周期写完所有槽位后header.cycle加1并对其futex唤醒.
+
+constexpr const char TELEMETRY_MAGIC[8] { 'T', 'S', 'B', 'U', 'S', '\0', '\0', '\0' };
+constexpr const uint32_t TELEMETRY_VERSION { 1 };
+constexpr const std::size_t TELEMETRY_NAME_SIZE { 16 };
+constexpr const std::size_t TELEMETRY_OUTPUT_NUM { 10 };
+constexpr const std::size_t TELEMETRY_MAX_NODES { 40 };
+
+struct alignas(64) TelemetryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t slotSize;
+    uint32_t rotorCount;
+    uint32_t maxNodes;
+    std::atomic<uint32_t> cycle; // futex字, 每周期加1
+    uint64_t cycleCount; // 服务端循环计数
+    int64_t updatedNs; // system_clock, 纳秒
+    char unit[TELEMETRY_NAME_SIZE];
+};
+
+// 字段与Rotor::send_message的json一致, 另加全部节点温度
+struct TelemetryRotor {
+    char name[TELEMETRY_NAME_SIZE];
+    double lifeRatio;
+    double overhaulLifeRatio;
+    int32_t alert;
+    uint32_t nodes; // field中有效节点数
+    double ts;
+    double t0;
+    double centerThermalStress;
+    double surfaceThermalStress;
+    double thermalStress;
+    double thermalStressMargin;
+    double temperature[TELEMETRY_OUTPUT_NUM];
+    double field[TELEMETRY_MAX_NODES];
+};
+
+struct alignas(64) TelemetrySlot {
+    std::atomic<uint32_t> seq;
+    TelemetryRotor data;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex word must be lock free");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32 bits");
+
+#endif // TELEMETRYLAYOUT_H
@@ -0,0 +1,101 @@
+#include "telemetryReader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+TelemetryReader::TelemetryReader(const std::string& unit)
+    : m_name { "/ts" + unit + "_telemetry" }
+{
+}
+
+TelemetryReader::~TelemetryReader() noexcept
+{
+    close();
+}
+
+bool TelemetryReader::open()
+{
+    const int fd = ::shm_open(m_name.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        close();
+        return false;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) == -1) {
+        ::close(fd);
+        close();
+        return false;
+    }
+    if (is_open() && st.st_dev == m_dev && st.st_ino == m_ino) {
+        ::close(fd);
+        return true;
+    }
+    close();
+    if (static_cast<std::size_t>(st.st_size) < sizeof(TelemetryHeader)) {
+        ::close(fd);
+        return false;
+    }
+    const std::size_t size { static_cast<std::size_t>(st.st_size) };
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    const auto* header = static_cast<const TelemetryHeader*>(addr);
+    const bool valid { std::memcmp(header->magic, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC)) == 0
+        && header->version == TELEMETRY_VERSION
+        && header->headerSize == sizeof(TelemetryHeader)
+        && header->slotSize == sizeof(TelemetrySlot)
+        && size >= sizeof(TelemetryHeader) + header->rotorCount * sizeof(TelemetrySlot) };
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid) {
+        ::munmap(addr, size);
+        return false;
+    }
+
+    m_size = size;
+    m_dev = st.st_dev;
+    m_ino = st.st_ino;
+    m_header = header;
+    m_slots = reinterpret_cast<const TelemetrySlot*>(static_cast<const char*>(addr) + sizeof(TelemetryHeader));
+    return true;
+}
+
+void TelemetryReader::close()
+{
+    if (m_header != nullptr) {
+        ::munmap(const_cast<TelemetryHeader*>(m_header), m_size);
+        m_header = nullptr;
+        m_slots = nullptr;
+    }
+}
+
+bool TelemetryReader::wait(uint32_t last, std::chrono::milliseconds timeout) const
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (cycle() == last) {
+        const auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::steady_clock::duration::zero()) {
+            return false;
+        }
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(left);
+        const timespec ts { static_cast<time_t>(secs.count()),
+            static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(left - secs).count()) };
+        // 值已变化时立即返回EAGAIN, 由循环条件判断
+        ::syscall(SYS_futex, const_cast<std::atomic<uint32_t>*>(&m_header->cycle), FUTEX_WAIT, last, &ts, nullptr, 0);
+    }
+    return true;
+}
+
+bool TelemetryReader::read(std::size_t index, TelemetryRotor& out) const
+{
+    return visit(index, [&out](const TelemetryRotor& data) { std::memcpy(&out, &data, sizeof(out)); });
+}
@@ -0,0 +1,79 @@
+#ifndef TELEMETRYREADER_H
+#define TELEMETRYREADER_H
+
+#include "telemetryLayout.h"
+#include <chrono>
+#include <string>
+#include <thread>
+
+// 本机遥测读者, 只读映射服务端的共享内存段, 只依赖telemetryLayout.h, 可单独编入HMI/历史库适配器:
+//
+//     TelemetryReader reader("1");
+//     uint32_t cycle { 0 };
+//     while (reader.open() && reader.wait(cycle, std::chrono::seconds(10))) {
+//         cycle = reader.cycle();
+//         if (!reader.visit(0, [](const TelemetryRotor& r) { use(r.thermalStress); })) {
+//             reader.close(); // 写者停在写入中途, 等服务重建段
+//         }
+//     }
+//
+// 服务重启时删除并重新创建段, 已映射的旧段不再更新; 每次open()按inode检查, 段已重建时重新映射
+constexpr const int TELEMETRY_READ_ATTEMPTS { 10000 }; // 槽位一直处于写入中(服务在写入中途退出)时放弃
+
+class TelemetryReader {
+private:
+    std::string m_name;
+    std::size_t m_size { 0 };
+    uint64_t m_dev { 0 }; // 已映射的段, 用于发现服务重建了段
+    uint64_t m_ino { 0 };
+    const TelemetryHeader* m_header { nullptr };
+    const TelemetrySlot* m_slots { nullptr };
+
+public:
+    explicit TelemetryReader(const std::string& unit);
+    TelemetryReader(const TelemetryReader&) = delete;
+    TelemetryReader& operator=(const TelemetryReader&) = delete;
+    ~TelemetryReader() noexcept;
+
+    // 已打开且段未被重建时直接返回true, 段已重建时重新映射(cycle()从新段的值开始);
+    // 段不存在或版本不兼容时关闭并返回false, 可稍后重试
+    bool open();
+    void close();
+    bool is_open() const { return m_header != nullptr; }
+
+    std::size_t size() const { return is_open() ? m_header->rotorCount : 0; }
+    const TelemetryHeader& header() const { return *m_header; }
+    uint32_t cycle() const { return m_header->cycle.load(std::memory_order_acquire); }
+
+    // 等待cycle()不等于last, 超时返回false
+    bool wait(uint32_t last, std::chrono::milliseconds timeout) const;
+
+    // 在共享内存上直接执行fn, 读到的数据不一致(写者正在更新)时重试, TELEMETRY_READ_ATTEMPTS次后返回false.
+    // fn可能被调用多次, 只应读取数据; 只有返回true时最后一次调用看到的是一致的快照
+    template <typename F>
+    bool visit(std::size_t index, F&& fn) const
+    {
+        if (index >= size()) {
+            return false;
+        }
+        const TelemetrySlot& slot = m_slots[index];
+        for (int attempt { 0 }; attempt < TELEMETRY_READ_ATTEMPTS; ++attempt) {
+            const uint32_t before { slot.seq.load(std::memory_order_acquire) };
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            fn(slot.data);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 复制一个转子的一致快照, 失败时同visit()
+    bool read(std::size_t index, TelemetryRotor& out) const;
+};
+
+#endif // TELEMETRYREADER_H
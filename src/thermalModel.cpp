@@ -0,0 +1,143 @@
+#include "thermalModel.h"
+
+namespace {
+
+template <std::size_t N, typename Real>
+ThermalVariant make_kernel(const Parameters& para, std::size_t curvePoints)
+{
+    if (curvePoints <= 8) {
+        return ThermalKernel<N, Real, 8>(para);
+    } else if (curvePoints <= 16) {
+        return ThermalKernel<N, Real, 16>(para);
+    }
+    return ThermalKernel<N, Real, 32>(para);
+}
+
+template <std::size_t N>
+ThermalVariant make_kernel(const Parameters& para, std::size_t curvePoints)
+{
+    if (para.precision == "float") {
+        return make_kernel<N, float>(para, curvePoints);
+    } else if (para.precision != "double") {
+        spdlog::error("Invalid precision: {}", para.precision);
+        std::terminate();
+    }
+    return make_kernel<N, double>(para, curvePoints);
+}
+
+ThermalVariant make_kernel(const Parameters& para)
+{
+    std::size_t curvePoints { PROPERTY_CURVE_POINTS };
+    for (const TempZone* zone : { &para.lecz, &para.SN1, &para.SN2, &para.SN3 }) {
+        curvePoints = std::max(curvePoints, zone->X.size());
+    }
+    if (curvePoints > 32) {
+        spdlog::error("Material curve has {} points, at most 32 are supported", curvePoints);
+        std::terminate();
+    }
+
+    switch (para.nodes) {
+    case 20:
+        return make_kernel<20>(para, curvePoints);
+    case 40:
+        return make_kernel<40>(para, curvePoints);
+    default:
+        spdlog::error("Unsupported node count: {}", para.nodes);
+        std::terminate();
+    }
+}
+
+} // namespace
+
+ThermalModel::ThermalModel(const Parameters& para)
+    : m_kernel { make_kernel(para) }
+{
+}
+
+void ThermalModel::init_field(double temp)
+{
+    std::visit([temp](auto& k) { k.init_field(temp); }, m_kernel);
+}
+
+void ThermalModel::temp_field()
+{
+    std::visit([](auto& k) { k.temp_field(); }, m_kernel);
+}
+
+void ThermalModel::temp_field(double dt)
+{
+    std::visit([dt](auto& k) { k.temp_field(dt); }, m_kernel);
+}
+
+StressState ThermalModel::thermal_stress() const
+{
+    return std::visit([](const auto& k) { return k.thermal_stress(); }, m_kernel);
+}
+
+double ThermalModel::life(double thermalStress, LifeState& l, double K) const
+{
+    return std::visit([&](const auto& k) { return k.life(thermalStress, l, K); }, m_kernel);
+}
+
+double ThermalModel::scan_cycle() const
+{
+    return std::visit([](const auto& k) { return k.scan_cycle(); }, m_kernel);
+}
+
+double ThermalModel::stable_dt() const
+{
+    return std::visit([](const auto& k) { return k.stable_dt(); }, m_kernel);
+}
+
+double ThermalModel::surface_temp() const
+{
+    return std::visit([](const auto& k) { return k.surface_temp(); }, m_kernel);
+}
+
+void ThermalModel::set_surface_temp(double temp)
+{
+    std::visit([temp](auto& k) { k.set_surface_temp(temp); }, m_kernel);
+}
+
+double ThermalModel::center_temp() const
+{
+    return std::visit([](const auto& k) { return k.center_temp(); }, m_kernel);
+}
+
+double ThermalModel::average_temp() const
+{
+    return std::visit([](const auto& k) { return k.average_temp(); }, m_kernel);
+}
+
+const std::array<double, FIELD_OUTPUT_NUM>& ThermalModel::fieldmHR() const
+{
+    return std::visit([](const auto& k) -> const std::array<double, FIELD_OUTPUT_NUM>& { return k.fieldmHR(); }, m_kernel);
+}
+
+std::size_t ThermalModel::nodes() const
+{
+    return std::visit([](const auto& k) { return k.NODES; }, m_kernel);
+}
+
+std::size_t ThermalModel::copy_field(double* out, std::size_t capacity) const
+{
+    return std::visit([out, capacity](const auto& k) {
+        const auto& field = k.field();
+        const std::size_t n { std::min(capacity, field.size()) };
+        std::copy_n(field.begin(), n, out);
+        return n;
+    },
+        m_kernel);
+}
+
+bool ThermalModel::load_field(const std::vector<double>& field, double surface, double center)
+{
+    return std::visit([&](auto& k) {
+        if (field.size() != k.NODES) {
+            return false;
+        }
+        k.load_field(field.data(), surface, center);
+        return true;
+    },
+        m_kernel);
+}
@@ -0,0 +1,328 @@
+#ifndef THERMALMODEL_H
+#define THERMALMODEL_H
+
+#include "utils.h"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <variant>
+
+// 转子温度场/热应力/寿命模型. 节点数, 计算精度和曲线容量为模板参数, 状态均为定长值类型,
+// 可直接复制用于推演, 计算过程不分配内存
+
+struct StressState {
+    double surfaceThermalStress { 0 };
+    double centerThermalStress { 0 };
+    double thermalStress { 0 };
+    double thermalStressMargin { 0 };
+};
+
+struct LifeState {
+    double lifeRatio { 0 };
+    double overhaulLifeRatio { 0 };
+    double thermalStressMax { 0 }; // 最大寿命消耗率对应的应力
+};
+
+constexpr const std::size_t PROPERTY_CURVE_POINTS { 8 }; // 物性曲线参与插值的点数
+constexpr const std::size_t FIELD_OUTPUT_NUM { 10 }; // 输出的分区平均温度个数
+
+// 定长材料曲线
+template <typename Real, std::size_t CurveN>
+struct Curve {
+    std::array<Real, CurveN> X {};
+    std::array<Real, CurveN> Y {};
+    std::array<Real, CurveN> slope {}; // slope[i]为第i-1到第i点的斜率
+    std::size_t pointNum { 0 }; // 参与插值的点数, 为0时插值结果为0
+
+    void assign(const TempZone& zone, std::size_t points)
+    {
+        if (points == 0 || points > zone.X.size() || points > zone.Y.size() || points > CurveN) {
+            pointNum = 0;
+            return;
+        }
+        for (std::size_t i { 0 }; i < points; ++i) {
+            X[i] = static_cast<Real>(zone.X[i]);
+            Y[i] = static_cast<Real>(zone.Y[i]);
+            if (i > 0) {
+                slope[i] = static_cast<Real>((zone.Y[i] - zone.Y[i - 1]) / (zone.X[i] - zone.X[i - 1]));
+            }
+        }
+        pointNum = points;
+    }
+
+    Real operator()(Real temp) const
+    {
+        if (pointNum == 0) {
+            return 0;
+        }
+        if (temp < X[0]) {
+            return Y[0];
+        } else if (temp >= X[pointNum - 1]) {
+            return Y[pointNum - 1];
+        }
+        std::size_t i { 1 };
+        while (temp >= X[i]) {
+            ++i;
+        }
+        return Y[i - 1] + slope[i] * (temp - X[i - 1]);
+    }
+};
+
+template <std::size_t N, typename Real, std::size_t CurveN>
+class ThermalKernel {
+    static_assert(N >= 2 && N % FIELD_OUTPUT_NUM == 0, "Node count must be a multiple of the output zone count");
+
+public:
+    static constexpr std::size_t NODES { N };
+    static constexpr std::size_t GROUP { N / FIELD_OUTPUT_NUM };
+
+    explicit ThermalKernel(const Parameters& para)
+        : m_scanCycle { static_cast<Real>(para.scanCycle) }
+        , m_surfaceFactor { static_cast<Real>(para.surfaceFactor) }
+        , m_centerFactor { static_cast<Real>(para.centerFactor) }
+        , m_freeFactor { static_cast<Real>(para.freeFactor) }
+        , m_sn { para.sn }
+    {
+        m_tcz.assign(para.tcz, PROPERTY_CURVE_POINTS);
+        m_shz.assign(para.shz, PROPERTY_CURVE_POINTS);
+        m_emz.assign(para.emz, PROPERTY_CURVE_POINTS);
+        m_prz.assign(para.prz, PROPERTY_CURVE_POINTS);
+        m_lecz.assign(para.lecz, para.lecz.X.size());
+        m_SN[0].assign(para.SN1, para.SN1.X.size());
+        m_SN[1].assign(para.SN2, para.SN2.X.size());
+        m_SN[2].assign(para.SN3, para.SN3.X.size());
+
+        // 径向几何系数只与半径和步长有关, 构造时计算一次
+        const double dR { para.deltaR };
+        double totalWeight { 0 };
+        for (std::size_t i { 0 }; i < N; ++i) {
+            const double ri { para.radius - dR * i };
+            if (i == 0) {
+                m_prev[i] = static_cast<Real>(2 * (ri - dR / 4));
+                m_self[i] = static_cast<Real>(3 * (ri - dR / 2));
+                m_next[i] = static_cast<Real>(ri - dR);
+            } else if (i != N - 1) {
+                m_prev[i] = static_cast<Real>(ri);
+                m_self[i] = static_cast<Real>(2 * ri - dR);
+                m_next[i] = static_cast<Real>(ri - dR);
+            } else {
+                m_prev[i] = static_cast<Real>(ri);
+                m_self[i] = static_cast<Real>(3 * (ri - dR / 2));
+                m_next[i] = static_cast<Real>(2 * (ri - 3 * dR / 4));
+            }
+            m_inv[i] = static_cast<Real>(2 / ((2 * ri - dR) * para.density * dR * dR * 1000));
+
+            const double weight { 2 * ri * dR - dR * dR };
+            m_weight[i] = static_cast<Real>(weight);
+            totalWeight += weight;
+        }
+        for (std::size_t g { 0 }; g < FIELD_OUTPUT_NUM; ++g) {
+            double groupWeight { 0 };
+            for (std::size_t i { g * GROUP }; i < (g + 1) * GROUP; ++i) {
+                groupWeight += m_weight[i];
+            }
+            m_groupInv[g] = static_cast<Real>(1 / groupWeight);
+        }
+        m_totalInv = static_cast<Real>(1 / totalWeight);
+
+        // 显式格式要求 dt * tc / sh * inv_i * self_i <= 1. 插值结果不超出曲线Y的范围,
+        // 取tc最大值与sh最小值得到与温度无关的保守上限
+        double tcMax { 0 };
+        double shMin { std::numeric_limits<double>::max() };
+        for (std::size_t i { 0 }; i < m_tcz.pointNum; ++i) {
+            tcMax = std::max(tcMax, static_cast<double>(m_tcz.Y[i]));
+        }
+        for (std::size_t i { 0 }; i < m_shz.pointNum; ++i) {
+            shMin = std::min(shMin, static_cast<double>(m_shz.Y[i]));
+        }
+        double rate { 0 };
+        for (std::size_t i { 0 }; i < N; ++i) {
+            rate = std::max(rate, static_cast<double>(m_inv[i]) * static_cast<double>(m_self[i]));
+        }
+        rate *= tcMax / shMin;
+        m_stableDt = rate > 0 && std::isfinite(rate) ? 1 / rate : std::numeric_limits<double>::infinity();
+    }
+
+    // 初始化为均匀温度场
+    void init_field(double temp)
+    {
+        m_last.fill(static_cast<Real>(temp));
+        m_cur.fill(static_cast<Real>(temp));
+        m_surfaceLast = static_cast<Real>(temp);
+        m_centerLast = static_cast<Real>(temp);
+    }
+
+    void temp_field()
+    {
+        temp_field(m_scanCycle);
+    }
+
+    // 计算T1~TN及中心孔温度, 再计算分区平均温度, 最后将本步结果作为下一步初值
+    void temp_field(Real dt)
+    {
+#pragma GCC unroll 40
+        for (std::size_t i { 0 }; i < N; ++i) {
+            const Real prev { i == 0 ? m_surfaceLast : m_last[i - 1] };
+            const Real next { i == N - 1 ? m_centerLast : m_last[i + 1] };
+            const Real tc { m_tcz(m_last[i]) };
+            const Real sh { m_shz(m_last[i]) };
+            m_cur[i] = m_last[i] + dt * tc / sh * m_inv[i] * (m_prev[i] * prev - m_self[i] * m_last[i] + m_next[i] * next);
+        }
+        m_centerCur = (3 * m_cur[N - 1] - m_cur[N - 2]) / 2;
+        update_averages();
+
+        m_last = m_cur;
+        m_centerLast = m_centerCur;
+        m_surfaceLast = m_surfaceCur;
+    }
+
+    // 恢复由field()/surface_temp()/center_temp()保存的状态, values为N个节点温度
+    void load_field(const double* values, double surface, double center)
+    {
+        for (std::size_t i { 0 }; i < N; ++i) {
+            m_cur[i] = static_cast<Real>(values[i]);
+        }
+        m_last = m_cur;
+        m_surfaceCur = m_surfaceLast = static_cast<Real>(surface);
+        m_centerCur = m_centerLast = static_cast<Real>(center);
+        update_averages();
+    }
+
+    StressState thermal_stress() const
+    {
+        const Real em { m_emz(m_aveTemp) };
+        const Real pr { m_prz(m_aveTemp) };
+        const Real lec { m_lecz(m_aveTemp) };
+        const Real k { em * lec / 1000 / (1 - pr) };
+
+        StressState res;
+        res.surfaceThermalStress = static_cast<double>(m_surfaceFactor * k * (m_aveTemp - m_surfaceCur));
+        res.centerThermalStress = static_cast<double>(m_centerFactor * k * (m_aveTemp - m_centerCur));
+        res.thermalStress = std::max(std::fabs(res.surfaceThermalStress), std::fabs(res.centerThermalStress));
+        res.thermalStressMargin = 100.0 * (1 - res.thermalStress / static_cast<double>(m_freeFactor));
+        return res;
+    }
+
+    // 返回本步寿命消耗率, 未完成一个应力循环时为0
+    double life(double thermalStress, LifeState& l, double K = 1.0 /*热应力集中系数*/) const
+    {
+        const double aveTemp { static_cast<double>(m_aveTemp) };
+        const auto& SNx = aveTemp < m_sn[0] ? m_SN[0] : (aveTemp > m_sn[1] ? m_SN[2] : m_SN[1]);
+        // 最小寿命消耗率对应的应力
+        const double thermalStressMin { std::fabs(static_cast<double>(SNx.X[0])) };
+
+        if (std::fabs(thermalStress) >= thermalStressMin) {
+            if (thermalStress > l.thermalStressMax) {
+                l.thermalStressMax = thermalStress;
+            }
+        } else if (l.thermalStressMax > thermalStressMin) {
+            const double lifeConsumptionRate { 1.0 / static_cast<double>(SNx(static_cast<Real>(K * l.thermalStressMax))) };
+            l.lifeRatio += lifeConsumptionRate;
+            l.overhaulLifeRatio += lifeConsumptionRate;
+            l.thermalStressMax = 0;
+            return lifeConsumptionRate;
+        }
+        return 0;
+    }
+
+    double scan_cycle() const { return static_cast<double>(m_scanCycle); }
+    // 单步稳定的最大时间步长, 秒
+    double stable_dt() const { return m_stableDt; }
+    double surface_temp() const { return static_cast<double>(m_surfaceCur); }
+    void set_surface_temp(double temp) { m_surfaceCur = static_cast<Real>(temp); }
+    double center_temp() const { return static_cast<double>(m_centerCur); }
+    double average_temp() const { return static_cast<double>(m_aveTemp); }
+    const std::array<double, FIELD_OUTPUT_NUM>& fieldmHR() const { return m_fieldmHR; }
+    const std::array<Real, N>& field() const { return m_cur; }
+
+private:
+    // 由m_cur计算分区平均温度和平均温度
+    void update_averages()
+    {
+        Real total { 0 };
+#pragma GCC unroll 10
+        for (std::size_t g { 0 }; g < FIELD_OUTPUT_NUM; ++g) {
+            Real sum { 0 };
+#pragma GCC unroll 4
+            for (std::size_t i { g * GROUP }; i < (g + 1) * GROUP; ++i) {
+                sum += m_weight[i] * m_cur[i];
+            }
+            m_fieldmHR[g] = static_cast<double>(sum * m_groupInv[g]);
+            total += sum;
+        }
+        m_aveTemp = total * m_totalInv;
+    }
+
+    // 材料
+    Curve<Real, CurveN> m_tcz; // Thermal Conductivity
+    Curve<Real, CurveN> m_shz; // Specific Heat
+    Curve<Real, CurveN> m_emz; // Elastic Modulus
+    Curve<Real, CurveN> m_prz; // Poisson's ratio
+    Curve<Real, CurveN> m_lecz; // Linear expansion coefficient
+    std::array<Curve<Real, CurveN>, 3> m_SN;
+    Real m_scanCycle;
+    Real m_surfaceFactor;
+    Real m_centerFactor;
+    Real m_freeFactor;
+    std::array<double, 2> m_sn;
+    double m_stableDt { 0 };
+
+    // 几何: T_i += dt * tc / sh * inv_i * (prev_i * T_{i-1} - self_i * T_i + next_i * T_{i+1})
+    std::array<Real, N> m_prev {};
+    std::array<Real, N> m_self {};
+    std::array<Real, N> m_next {};
+    std::array<Real, N> m_inv {};
+    std::array<Real, N> m_weight {};
+    std::array<Real, FIELD_OUTPUT_NUM> m_groupInv {};
+    Real m_totalInv { 0 };
+
+    // 状态
+    std::array<Real, N> m_last {};
+    std::array<Real, N> m_cur {};
+    Real m_surfaceLast { 0 };
+    Real m_surfaceCur { 0 };
+    Real m_centerLast { 0 };
+    Real m_centerCur { 0 };
+    Real m_aveTemp { 0 };
+    std::array<double, FIELD_OUTPUT_NUM> m_fieldmHR {};
+};
+
+using ThermalVariant = std::variant<
+    ThermalKernel<20, double, 8>, ThermalKernel<20, double, 16>, ThermalKernel<20, double, 32>,
+    ThermalKernel<20, float, 8>, ThermalKernel<20, float, 16>, ThermalKernel<20, float, 32>,
+    ThermalKernel<40, double, 8>, ThermalKernel<40, double, 16>, ThermalKernel<40, double, 32>,
+    ThermalKernel<40, float, 8>, ThermalKernel<40, float, 16>, ThermalKernel<40, float, 32>>;
+
+// 按Parameters的nodes/precision及曲线点数选择具体实例, 其余接口转发到该实例
+class ThermalModel {
+private:
+    ThermalVariant m_kernel;
+
+public:
+    explicit ThermalModel(const Parameters& para);
+
+    // 在具体实例上批量计算时使用, 避免每步分派
+    ThermalVariant& kernel() { return m_kernel; }
+    const ThermalVariant& kernel() const { return m_kernel; }
+
+    void init_field(double temp);
+    void temp_field();
+    void temp_field(double dt);
+    StressState thermal_stress() const;
+    double life(double thermalStress, LifeState& l, double K = 1.0) const;
+
+    double scan_cycle() const;
+    double stable_dt() const;
+    double surface_temp() const;
+    void set_surface_temp(double temp);
+    double center_temp() const;
+    double average_temp() const;
+    const std::array<double, FIELD_OUTPUT_NUM>& fieldmHR() const;
+    std::size_t nodes() const;
+    // 复制全部节点温度(转换为double), 返回复制的节点数
+    std::size_t copy_field(double* out, std::size_t capacity) const;
+    // 恢复copy_field复制的节点温度及表面/中心孔温度, 节点数不符时返回false
+    bool load_field(const std::vector<double>& field, double surface, double center);
+};
+
+#endif // THERMALMODEL_H
@@ -0,0 +1,90 @@
+#include "unitMessage.h"
+
+#include <cmath>
+
+// 与Rotor::send_message的json字段一一对应, 数组中按此顺序排列
+static constexpr const char* UNIT_MESSAGE_HEADER {
+    "{\"fields\":[\"name\",\"lifeRatio\",\"overhaulLifeRatio\",\"alert\",\"ts\",\"t0\","
+    "\"centerThermalStress\",\"surfaceThermalStress\",\"thermalStress\",\"thermalStressMargin\",\"temperature\"],"
+    "\"rotors\":["
+};
+
+UnitMessage::UnitMessage(const std::string& unit)
+    : m_topic { "TS" + unit + "/Rotors" }
+{
+    m_payload.reserve(4096);
+    clear();
+}
+
+void UnitMessage::clear()
+{
+    m_payload.clear();
+    m_payload.append(UNIT_MESSAGE_HEADER);
+    m_count = 0;
+}
+
+void UnitMessage::append_number(double value)
+{
+    // 与json::dump保持一致, 非有限值输出null
+    if (std::isfinite(value)) {
+        fmt::format_to(std::back_inserter(m_payload), "{}", value);
+    } else {
+        m_payload.append("null");
+    }
+}
+
+void UnitMessage::append_string(const std::string& value)
+{
+    // 转子名称来自参数键, 可能含引号或控制字符; 其余字节(UTF-8)原样输出, 与json::dump一致
+    m_payload.push_back('"');
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            m_payload.push_back('\\');
+            m_payload.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fmt::format_to(std::back_inserter(m_payload), "\\u{:04x}", static_cast<unsigned char>(c));
+        } else {
+            m_payload.push_back(c);
+        }
+    }
+    m_payload.push_back('"');
+}
+
+void UnitMessage::add(const std::string& name, const RotorState& state)
+{
+    if (m_count++ != 0) {
+        m_payload.push_back(',');
+    }
+    m_payload.push_back('[');
+    append_string(name);
+    m_payload.push_back(',');
+    append_number(state.lifeRatio);
+    m_payload.push_back(',');
+    append_number(state.overhaulLifeRatio);
+    fmt::format_to(std::back_inserter(m_payload), ",{},", state.alert);
+    append_number(state.ts);
+    m_payload.push_back(',');
+    append_number(state.t0);
+    m_payload.push_back(',');
+    append_number(state.centerThermalStress);
+    m_payload.push_back(',');
+    append_number(state.surfaceThermalStress);
+    m_payload.push_back(',');
+    append_number(state.thermalStress);
+    m_payload.push_back(',');
+    append_number(state.thermalStressMargin);
+    m_payload.append(",[");
+    for (std::size_t i { 0 }; i < state.temperature.size(); ++i) {
+        if (i != 0) {
+            m_payload.push_back(',');
+        }
+        append_number(state.temperature[i]);
+    }
+    m_payload.append("]]");
+}
+
+const std::string& UnitMessage::finish()
+{
+    m_payload.append("]}");
+    return m_payload;
+}
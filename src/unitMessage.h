@@ -0,0 +1,27 @@
+#ifndef UNITMESSAGE_H
+#define UNITMESSAGE_H
+
+#include "Rotor.h"
+#include <string>
+
+// 整机汇总消息: 每周期每台机组一条, 所有转子按固定字段顺序紧凑排列
+class UnitMessage {
+private:
+    const std::string m_topic;
+    std::string m_payload; // 复用缓冲区, clear()不释放容量
+    std::size_t m_count { 0 };
+
+    void append_number(double value);
+    void append_string(const std::string& value);
+
+public:
+    explicit UnitMessage(const std::string& unit);
+
+    void clear();
+    void add(const std::string& name, const RotorState& state);
+    const std::string& topic() const { return m_topic; }
+    const std::string& finish(); // 每次clear()后调用一次
+    std::size_t size() const { return m_count; }
+};
+
+#endif // UNITMESSAGE_H
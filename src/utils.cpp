@@ -1,5 +1,7 @@
 #include "utils.h"
 
+#include <functional>
+
 std::ostream& operator<<(std::ostream& os, const TempZone& tz)
 {
     os << "X: ";
@@ -29,7 +31,13 @@ std::ostream& operator<<(std::ostream& os, const Parameters& p)
        << "SN1: " << p.SN1 << "\n"
        << "SN2: " << p.SN2 << "\n"
        << "SN3: " << p.SN3 << "\n"
-       << "Sn: [" << p.sn[0] << ", " << p.sn[1] << "]";
+       << "Sn: [" << p.sn[0] << ", " << p.sn[1] << "]\n"
+       << "Nodes: " << p.nodes << "\n"
+       << "Precision: " << p.precision;
+    for (const auto& section : p.sections) {
+        os << "\nSection " << section.name << " (surface register " << section.surfaceRegister << "):\n"
+           << section.para;
+    }
     return os;
 }
 
@@ -49,7 +57,49 @@ std::vector<double> split_and_convert(const std::string& str)
     return result;
 }
 
-Parameters loadParasFromRedis(const json& j, const std::string& key)
+namespace {
+
+// 截面的参数: 转子的参数被截面中的字段覆盖后, 按与转子相同的规则加载
+std::vector<SectionParameters> load_sections(const json& rotor, const json& sections, const std::string& key,
+    const std::function<Parameters(const json&, const std::string&)>& load)
+{
+    std::vector<SectionParameters> res;
+    if (!sections.is_array()) {
+        spdlog::error("Sections of rotor {} must be an array", key);
+        std::terminate();
+    }
+    for (const auto& section : sections) {
+        if (!section.is_object() || !section.contains("name")) {
+            spdlog::error("Every section of rotor {} must be an object with a name", key);
+            std::terminate();
+        }
+        json merged = rotor;
+        merged.erase("sections");
+        std::string name;
+        std::size_t surfaceRegister { 0 };
+        for (const auto& [field, value] : section.items()) {
+            if (field == "name") {
+                name = value.get<std::string>();
+            } else if (field == "surfaceRegister") {
+                surfaceRegister = value.is_string() ? std::stoul(value.get<std::string>()) : value.get<std::size_t>();
+            } else {
+                merged[field] = value;
+            }
+        }
+        if (surfaceRegister >= SECTION_REGISTER_NUM) {
+            spdlog::error("Section {} of rotor {}: surfaceRegister must be less than {}", name, key, SECTION_REGISTER_NUM);
+            std::terminate();
+        }
+        json wrapper;
+        wrapper[key] = merged;
+        res.push_back({ name, surfaceRegister, load(wrapper, key) });
+    }
+    return res;
+}
+
+} // namespace
+
+Parameters loadParasFromRedis(const json& j, const std::string& key, MaterialLibrary& materials)
 {
     auto get_value_as_double = [&j, &key](const std::string& subkey) -> double {
         auto it = j[key].find(subkey);
@@ -79,8 +129,17 @@ Parameters loadParasFromRedis(const json& j, const std::string& key)
         std::terminate();
     };
 
+    auto get_optional_string = [&j, &key](const std::string& subkey, const std::string& fallback) -> std::string {
+        auto it = j[key].find(subkey);
+        if (it != j[key].end() && it->is_string()) {
+            return it->get<std::string>();
+        }
+        return fallback;
+    };
+
     try {
         auto sn_vector = get_vector_of_doubles("sn");
+        const std::string sections { get_optional_string("sections", "") };
 
         return {
             get_value_as_double("density"),
@@ -91,15 +150,20 @@ Parameters loadParasFromRedis(const json& j, const std::string& key)
             get_value_as_double("surfaceFactor"),
             get_value_as_double("centerFactor"),
             get_value_as_double("freeFactor"),
-            { get_vector_of_doubles("tcz_X"), get_vector_of_doubles("tcz_Y") },
-            { get_vector_of_doubles("shz_X"), get_vector_of_doubles("shz_Y") },
-            { get_vector_of_doubles("emz_X"), get_vector_of_doubles("emz_Y") },
-            { get_vector_of_doubles("prz_X"), get_vector_of_doubles("prz_Y") },
-            { get_vector_of_doubles("lecz_X"), get_vector_of_doubles("lecz_Y") },
-            { get_vector_of_doubles("SN1_X"), get_vector_of_doubles("SN1_Y") },
-            { get_vector_of_doubles("SN2_X"), get_vector_of_doubles("SN2_Y") },
-            { get_vector_of_doubles("SN3_X"), get_vector_of_doubles("SN3_Y") },
-            { sn_vector[0], sn_vector[1] }
+            materials.intern(get_vector_of_doubles("tcz_X"), get_vector_of_doubles("tcz_Y")),
+            materials.intern(get_vector_of_doubles("shz_X"), get_vector_of_doubles("shz_Y")),
+            materials.intern(get_vector_of_doubles("emz_X"), get_vector_of_doubles("emz_Y")),
+            materials.intern(get_vector_of_doubles("prz_X"), get_vector_of_doubles("prz_Y")),
+            materials.intern(get_vector_of_doubles("lecz_X"), get_vector_of_doubles("lecz_Y")),
+            materials.intern(get_vector_of_doubles("SN1_X"), get_vector_of_doubles("SN1_Y")),
+            materials.intern(get_vector_of_doubles("SN2_X"), get_vector_of_doubles("SN2_Y")),
+            materials.intern(get_vector_of_doubles("SN3_X"), get_vector_of_doubles("SN3_Y")),
+            { sn_vector[0], sn_vector[1] },
+            std::stoul(get_optional_string("nodes", "20")),
+            get_optional_string("precision", "double"),
+            sections.empty() ? std::vector<SectionParameters> {} : load_sections(j[key], json::parse(sections), key, [&materials](const json& section, const std::string& k) {
+                return loadParasFromRedis(section, k, materials);
+            })
         };
     } catch (const std::exception& e) {
         spdlog::error("Error loading parameters: {}", e.what());
@@ -107,7 +171,7 @@ Parameters loadParasFromRedis(const json& j, const std::string& key)
     }
 }
 
-Parameters loadParasFromJson(const json& j, const std::string& key)
+Parameters loadParasFromJson(const json& j, const std::string& key, MaterialLibrary& materials)
 {
     return {
         j[key]["density"].get<double>(),
@@ -118,15 +182,21 @@ Parameters loadParasFromJson(const json& j, const std::string& key)
         j[key]["surfaceFactor"].get<double>(),
         j[key]["centerFactor"].get<double>(),
         j[key]["freeFactor"].get<double>(),
-        { j[key]["tcz"]["X"].get<std::vector<double>>(), j[key]["tcz"]["Y"].get<std::vector<double>>() },
-        { j[key]["shz"]["X"].get<std::vector<double>>(), j[key]["shz"]["Y"].get<std::vector<double>>() },
-        { j[key]["emz"]["X"].get<std::vector<double>>(), j[key]["emz"]["Y"].get<std::vector<double>>() },
-        { j[key]["prz"]["X"].get<std::vector<double>>(), j[key]["prz"]["Y"].get<std::vector<double>>() },
-        { j[key]["lecz"]["X"].get<std::vector<double>>(), j[key]["lecz"]["Y"].get<std::vector<double>>() },
-        { j[key]["SN1"]["X"].get<std::vector<double>>(), j[key]["SN1"]["Y"].get<std::vector<double>>() },
-        { j[key]["SN2"]["X"].get<std::vector<double>>(), j[key]["SN2"]["Y"].get<std::vector<double>>() },
-        { j[key]["SN3"]["X"].get<std::vector<double>>(), j[key]["SN3"]["Y"].get<std::vector<double>>() },
-        j[key]["sn"].get<std::array<double, 2>>()
+        materials.intern(j[key]["tcz"]["X"].get<std::vector<double>>(), j[key]["tcz"]["Y"].get<std::vector<double>>()),
+        materials.intern(j[key]["shz"]["X"].get<std::vector<double>>(), j[key]["shz"]["Y"].get<std::vector<double>>()),
+        materials.intern(j[key]["emz"]["X"].get<std::vector<double>>(), j[key]["emz"]["Y"].get<std::vector<double>>()),
+        materials.intern(j[key]["prz"]["X"].get<std::vector<double>>(), j[key]["prz"]["Y"].get<std::vector<double>>()),
+        materials.intern(j[key]["lecz"]["X"].get<std::vector<double>>(), j[key]["lecz"]["Y"].get<std::vector<double>>()),
+        materials.intern(j[key]["SN1"]["X"].get<std::vector<double>>(), j[key]["SN1"]["Y"].get<std::vector<double>>()),
+        materials.intern(j[key]["SN2"]["X"].get<std::vector<double>>(), j[key]["SN2"]["Y"].get<std::vector<double>>()),
+        materials.intern(j[key]["SN3"]["X"].get<std::vector<double>>(), j[key]["SN3"]["Y"].get<std::vector<double>>()),
+        j[key]["sn"].get<std::array<double, 2>>(),
+        j[key].value("nodes", std::size_t { 20 }),
+        j[key].value("precision", std::string { "double" }),
+        j[key].contains("sections") ? load_sections(j[key], j[key]["sections"], key, [&materials](const json& section, const std::string& k) {
+            return loadParasFromJson(section, k, materials);
+        })
+                                    : std::vector<SectionParameters> {}
     };
 }
 
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <random>
 
+#include "materialLibrary.h"
 #include "nlohmann/json.hpp"
 #include "spdlog/async.h"
 #include "spdlog/spdlog.h"
@@ -15,10 +16,7 @@ struct TempPoint {
     double cur;
 };
 
-struct TempZone {
-    std::vector<double> X;
-    std::vector<double> Y;
-};
+struct SectionParameters;
 
 struct Parameters {
     const double density;
@@ -35,7 +33,22 @@ struct Parameters {
     const TempZone prz; // Poisson's ratio
     const TempZone lecz; // Linear expansion coefficient
     const TempZone SN1, SN2, SN3; // 材料曲线插值
+    // 以上曲线均由MaterialLibrary持有, 各转子相同的曲线共用一份
     const std::array<double, 2> sn; // SN曲线温度设定点
+    const std::size_t nodes { 20 }; // 径向节点数, 20或40
+    const std::string precision { "double" }; // 计算精度, double或float
+    const std::vector<SectionParameters> sections {}; // 除本截面外的其它危险截面
+};
+
+constexpr const std::size_t SECTION_REGISTER_NUM { 10 }; // 截面的表面温度寄存器须在表面温度寄存器块内
+
+// 转子的危险截面(调节级叶根槽, 汽封, 中心孔等), 各有边界温度, 应力集中系数, 温度场和寿命.
+// 参数中的"sections"为数组, 每项为name, surfaceRegister(表面温度寄存器块内的序号)及要覆盖的转子参数,
+// 未覆盖的参数(如材料曲线)与转子相同. Redis中"sections"为该数组的JSON字符串, 覆盖值与其它字段一样为字符串
+struct SectionParameters {
+    std::string name;
+    std::size_t surfaceRegister;
+    Parameters para;
 };
 
 std::ostream& operator<<(std::ostream& os, const TempZone& tz);
@@ -44,9 +57,9 @@ std::ostream& operator<<(std::ostream& os, const Parameters& p);
 
 std::vector<double> split_and_convert(const std::string& str);
 
-Parameters loadParasFromRedis(const json& j, const std::string& key);
+Parameters loadParasFromRedis(const json& j, const std::string& key, MaterialLibrary& materials);
 
-Parameters loadParasFromJson(const json& j, const std::string& key);
+Parameters loadParasFromJson(const json& j, const std::string& key, MaterialLibrary& materials);
 
 bool fileExists(const std::string& filename);
 
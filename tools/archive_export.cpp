@@ -0,0 +1,80 @@
+#include "../src/archiveReader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <limits>
+
+// 用法: archive_export <dir> <unit> [from] [to] [rotor]
+// 以CSV输出归档中[from, to]内的样本, 时间为UTC的YYYY-MM-DD或YYYY-MM-DDTHH:MM:SS, "-"表示不限
+static bool parse_time(const char* str, int64_t& ms)
+{
+    std::tm tm {};
+    int n { 0 };
+    if (std::sscanf(str, "%d-%d-%dT%d:%d:%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &n) != 6) {
+        tm = {};
+        if (std::sscanf(str, "%d-%d-%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &n) != 3) {
+            return false;
+        }
+    }
+    if (str[n] != '\0') {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    ms = static_cast<int64_t>(::timegm(&tm)) * 1000;
+    return true;
+}
+
+static void print_time(int64_t ms)
+{
+    const std::time_t t { static_cast<std::time_t>(ms / 1000) };
+    std::tm tm {};
+    ::gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::printf("%s.%03dZ", buf, static_cast<int>(ms % 1000));
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " dir unit [from|-] [to|-] [rotor]\n";
+        return 1;
+    }
+
+    int64_t from { 0 };
+    int64_t to { std::numeric_limits<int64_t>::max() / 2 };
+    if (argc > 3 && std::string(argv[3]) != "-" && !parse_time(argv[3], from)) {
+        std::cerr << "Invalid time " << argv[3] << '\n';
+        return 1;
+    }
+    if (argc > 4 && std::string(argv[4]) != "-" && !parse_time(argv[4], to)) {
+        std::cerr << "Invalid time " << argv[4] << '\n';
+        return 1;
+    }
+    const std::string rotor { argc > 5 ? argv[5] : "" };
+
+    std::printf("rotor,time");
+    for (const char* column : ARCHIVE_COLUMNS) {
+        std::printf(",%s", column);
+    }
+    std::printf("\n");
+
+    const ArchiveReader reader(argv[1], argv[2]);
+    const std::size_t n = reader.scan(from, to, rotor, [](const std::string& name, const ArchiveSample& sample) {
+        std::printf("%s,", name.c_str());
+        print_time(sample.timeMs);
+        for (const double value : sample.values) {
+            if (std::isfinite(value)) {
+                std::printf(",%.17g", value);
+            } else {
+                std::printf(",");
+            }
+        }
+        std::printf("\n");
+    });
+    std::cerr << n << " samples\n";
+    return 0;
+}
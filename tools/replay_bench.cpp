@@ -0,0 +1,236 @@
+#include "../src/myModbus.h"
+#include "../src/registerMap.h"
+#include "../src/rotorRegistry.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+// 用法:
+//   replay_bench <parameters.json> <temperature.csv> [passes]
+//   replay_bench --write-profile <parameters.json> <temperature.csv>
+// 离线回放记录的表面温度, 驱动与在线相同的计算路径(截面推进 -> 消息 -> 寄存器打包 -> Modbus映像更新), 不访问Redis/MQTT/Modbus.
+// CSV与archive_export的输出相同(rotor,time,...,ts,...), 只用到rotor, time和ts三列.
+// 结果确定, 可作为PGO的训练负载, 最后一行为"elapsed <秒>"
+constexpr const double REPLAY_INTERVAL { 60 }; // 合成温度曲线的采样间隔, 秒
+constexpr const std::size_t REPLAY_PROFILE_HOURS { 48 };
+
+struct ReplaySample {
+    int64_t timeMs;
+    double ts;
+};
+
+static bool parse_time(const std::string& str, int64_t& ms)
+{
+    std::tm tm {};
+    int milli { 0 };
+    if (std::sscanf(str.c_str(), "%d-%d-%dT%d:%d:%d.%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &milli) < 6) {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    ms = static_cast<int64_t>(::timegm(&tm)) * 1000 + milli;
+    return true;
+}
+
+static std::vector<std::string> split(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// 冷态启动 -> 带负荷(小幅波动) -> 停机 -> 冷却, 24小时一个循环, 各转子相位错开
+static double profile_temp(double hour, std::size_t rotor)
+{
+    const double h { std::fmod(hour + 1.5 * rotor, 24.0) };
+    if (h < 2) {
+        return 80;
+    } else if (h < 6) {
+        return 80 + (535 - 80) * (h - 2) / 4;
+    } else if (h < 18) {
+        return 535 + 15 * std::sin(2 * M_PI * (h - 6) / 1.5);
+    } else if (h < 20) {
+        return 535 - (535 - 250) * (h - 18) / 2;
+    }
+    return 80 + (250 - 80) * std::exp(-(h - 20));
+}
+
+static int write_profile(const std::vector<std::string>& names, const char* path)
+{
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Cannot write " << path << '\n';
+        return 1;
+    }
+    out << "rotor,time,ts\n";
+    const std::size_t samples { static_cast<std::size_t>(REPLAY_PROFILE_HOURS * 3600 / REPLAY_INTERVAL) };
+    for (std::size_t i { 0 }; i < samples; ++i) {
+        const double seconds { i * REPLAY_INTERVAL };
+        const std::time_t t { static_cast<std::time_t>(seconds) };
+        std::tm tm {};
+        ::gmtime_r(&t, &tm);
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S.000Z", &tm);
+        for (std::size_t r { 0 }; r < names.size(); ++r) {
+            char temp[32];
+            std::snprintf(temp, sizeof(temp), "%.3f", profile_temp(seconds / 3600, r));
+            out << names[r] << ',' << buf << ',' << temp << '\n';
+        }
+    }
+    std::cerr << samples * names.size() << " samples written to " << path << '\n';
+    return 0;
+}
+
+static bool read_samples(const char* path, const std::map<std::string, RotorHandle>& handles, std::vector<std::vector<ReplaySample>>& samples)
+{
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line)) {
+        std::cerr << "Cannot read " << path << '\n';
+        return false;
+    }
+    const auto header = split(line);
+    std::size_t tsColumn { header.size() };
+    for (std::size_t c { 2 }; c < header.size(); ++c) {
+        if (header[c] == "ts") {
+            tsColumn = c;
+        }
+    }
+    if (header.size() < 3 || header[0] != "rotor" || header[1] != "time" || tsColumn == header.size()) {
+        std::cerr << path << ": expected columns rotor,time,...,ts\n";
+        return false;
+    }
+
+    std::size_t skipped { 0 };
+    while (std::getline(in, line)) {
+        const auto fields = split(line);
+        int64_t ms { 0 };
+        const auto it = fields.size() > tsColumn ? handles.find(fields[0]) : handles.end();
+        if (it == handles.end() || fields[tsColumn].empty() || !parse_time(fields[1], ms)) {
+            ++skipped;
+            continue;
+        }
+        samples[it->second].push_back({ ms, std::stod(fields[tsColumn]) });
+    }
+    if (skipped > 0) {
+        std::cerr << skipped << " lines skipped (unknown rotor or missing ts)\n";
+    }
+    for (auto& s : samples) {
+        std::stable_sort(s.begin(), s.end(), [](const ReplaySample& a, const ReplaySample& b) { return a.timeMs < b.timeMs; });
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    const bool writeProfile { argc > 1 && std::string(argv[1]) == "--write-profile" };
+    const int first { writeProfile ? 2 : 1 };
+    if (argc < first + 2) {
+        std::cerr << "Usage: " << argv[0] << " parameters.json temperature.csv [passes]\n"
+                  << "       " << argv[0] << " --write-profile parameters.json temperature.csv\n";
+        return 1;
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    std::ifstream file(argv[first]);
+    json j;
+    if (!file || !(file >> j) || j.empty()) {
+        std::cerr << "Cannot load parameters from " << argv[first] << '\n';
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    MaterialLibrary materials;
+    std::vector<Parameters> paraList;
+    std::vector<int> controlWords;
+    for (json::iterator it = j.begin(); it != j.end(); ++it) {
+        names.emplace_back(it.key());
+        paraList.emplace_back(loadParasFromJson(j, it.key(), materials));
+        controlWords.emplace_back(std::stoi(j[it.key()]["controlWord"].get<std::string>()));
+    }
+    if (writeProfile) {
+        return write_profile(names, argv[first + 1]);
+    }
+    const std::size_t passes { argc > first + 2 ? static_cast<std::size_t>(std::max(1, std::atoi(argv[first + 2]))) : 1 };
+
+    // 客户端全部为空: 构造和计算路径不做I/O
+    RotorRegistry rotors(names, "1", paraList, controlWords, nullptr, nullptr, std::vector<std::unique_ptr<MyModbusClient>>(names.size()));
+    auto registerMap = RegisterMap::compile(RegisterMap::default_config(), names, MODBUS_REGISTER_MAX);
+    if (!registerMap) {
+        return 1;
+    }
+
+    std::map<std::string, RotorHandle> handles;
+    for (RotorHandle h { 0 }; h < names.size(); ++h) {
+        handles.emplace(names[h], h);
+    }
+    std::vector<std::vector<ReplaySample>> samples(names.size());
+    if (!read_samples(argv[first + 1], handles, samples)) {
+        return 1;
+    }
+    std::size_t steps { 0 };
+    for (const auto& s : samples) {
+        steps = std::max(steps, s.size());
+    }
+    if (steps == 0) {
+        std::cerr << "No samples\n";
+        return 1;
+    }
+
+    const auto sections = rotors.sections();
+    const std::vector<double> zeros(2 * sections.size(), 0);
+    std::vector<RegisterValues> values(names.size());
+    // 不调用run(), 不监听端口, 只更新寄存器映像
+    MyModbusServer modbusServer("", 0, registerMap->registers());
+    std::size_t messageBytes { 0 };
+    double checksum { 0 };
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t pass { 0 }; pass < passes; ++pass) {
+        for (RotorHandle h { 0 }; h < rotors.size(); ++h) {
+            Rotor& rotor = rotors[h];
+            rotor.set_lives(zeros);
+            for (std::size_t k { 0 }; k < rotor.section_count(); ++k) {
+                sections[rotors.first_section(h) + k].thermal.init_field(samples[h].empty() ? 0 : samples[h][0].ts);
+            }
+        }
+        // 按周期轮流推进各转子, 与在线调度的访问顺序一致
+        for (std::size_t i { 1 }; i < steps; ++i) {
+            for (RotorHandle h { 0 }; h < rotors.size(); ++h) {
+                if (i >= samples[h].size()) {
+                    continue;
+                }
+                Rotor& rotor = rotors[h];
+                const double dt { std::min(STEP_ELAPSED_MAX, (samples[h][i].timeMs - samples[h][i - 1].timeMs) / 1000.0) };
+                for (std::size_t k { 0 }; k < rotor.section_count(); ++k) {
+                    sections[rotors.first_section(h) + k].thermal.set_surface_temp(samples[h][i].ts);
+                }
+                if (dt > 0) {
+                    rotor.step(dt);
+                }
+                messageBytes += rotor.message().dump().size();
+                values[h] = pack_register_values(rotor.state());
+            }
+            modbusServer.update(*registerMap, values);
+        }
+        for (RotorHandle h { 0 }; h < rotors.size(); ++h) {
+            checksum += rotors[h].state().lifeRatio;
+        }
+    }
+    const double elapsed { std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+    std::printf("rotors %zu, sections %zu, steps %zu, passes %zu\n", rotors.size(), sections.size(), steps, passes);
+    std::printf("message bytes %zu, life checksum %.17g\n", messageBytes, checksum);
+    std::printf("elapsed %.6f\n", elapsed);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "../src/telemetryReader.h"
+
+#include <iostream>
+#include <thread>
+
+// 用法: telemetry_dump <unit>
+// 每个周期打印一次共享内存中各转子的状态
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " unit\n";
+        return 1;
+    }
+
+    TelemetryReader reader(argv[1]);
+    uint32_t cycle { 0 };
+    TelemetryRotor rotor {};
+    while (true) {
+        // 服务重启后段被重建, open()重新映射
+        if (!reader.open()) {
+            std::cerr << "Waiting for telemetry segment of unit " << argv[1] << "...\n";
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+            continue;
+        }
+        if (!reader.wait(cycle, std::chrono::seconds(60))) {
+            std::cerr << "No update for 60 seconds\n";
+            continue;
+        }
+        cycle = reader.cycle();
+        std::cout << "Loop " << reader.header().cycleCount << '\n';
+        for (std::size_t i { 0 }; i < reader.size(); ++i) {
+            if (!reader.read(i, rotor)) {
+                // 服务在写入中途退出, 槽位不会再一致; 关闭后由open()等待重建的段
+                std::cerr << "Rotor " << i << " is stuck in an update, reopening\n";
+                reader.close();
+                break;
+            }
+            std::cout << "  " << rotor.name << ": ts=" << rotor.ts << " t0=" << rotor.t0
+                      << " thermalStress=" << rotor.thermalStress << " margin=" << rotor.thermalStressMargin
+                      << " life=" << rotor.lifeRatio << " overhaulLife=" << rotor.overhaulLifeRatio
+                      << " alert=" << rotor.alert << " nodes=" << rotor.nodes << '\n';
+        }
+    }
+}
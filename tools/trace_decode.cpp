@@ -0,0 +1,55 @@
+#include "../src/myTrace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// 用法: trace_decode logs/trace.bin [logs/trace.bin.1 ...]
+// 读取全部文件后按时间排序输出
+static bool load_file(const std::string& path, std::vector<TraceRecord>& records)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Unable to open " << path << '\n';
+        return false;
+    }
+
+    TraceFileHeader header {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0
+        || header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord)) {
+        std::cerr << path << " is not a trace file\n";
+        return false;
+    }
+
+    const uint64_t count = std::min(header.count, header.capacity);
+    const std::size_t offset = records.size();
+    records.resize(offset + count);
+    file.read(reinterpret_cast<char*>(records.data() + offset), static_cast<std::streamsize>(count * sizeof(TraceRecord)));
+    records.resize(offset + static_cast<std::size_t>(file.gcount()) / sizeof(TraceRecord));
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " trace.bin [trace.bin.1 ...]\n";
+        return 1;
+    }
+
+    std::vector<TraceRecord> records;
+    for (int i { 1 }; i < argc; ++i) {
+        if (!load_file(argv[i], records)) {
+            return 1;
+        }
+    }
+
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+        return a.timeNs < b.timeNs;
+    });
+    for (const auto& record : records) {
+        std::cout << trace_format(record) << '\n';
+    }
+    return 0;
+}